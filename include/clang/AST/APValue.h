@@ -72,6 +72,8 @@ private:
     APSInt Real, Imag;
     ComplexAPSInt() : Real(1), Imag(1) {}
   };
+  /// Complex floats are rare, and twice the size of anything else we store
+  /// inline, so they live out of line to keep APValue small.
   struct ComplexAPFloat {
     APFloat Real, Imag;
     ComplexAPFloat() : Real(0.0), Imag(0.0) {}
@@ -81,7 +83,7 @@ private:
     APValue *Elts;
     unsigned NumElts;
     Vec() : Elts(nullptr), NumElts(0) {}
-    ~Vec() { delete[] Elts; }
+    ~Vec();
   };
   struct Arr {
     APValue *Elts;
@@ -110,8 +112,8 @@ private:
 
   // We ensure elsewhere that Data is big enough for LV and MemberPointerData.
   typedef llvm::AlignedCharArrayUnion<void *, APSInt, APFloat, ComplexAPSInt,
-                                      ComplexAPFloat, Vec, Arr, StructData,
-                                      UnionData, AddrLabelDiffData> DataType;
+                                      Vec, Arr, StructData, UnionData,
+                                      AddrLabelDiffData> DataType;
   static const size_t DataSize = sizeof(DataType);
 
   DataType Data;
@@ -195,6 +197,13 @@ public:
   void dump() const;
   void dump(raw_ostream &OS) const;
 
+  /// \brief Start tracking the heap memory used by APValues.
+  static void EnableStatistics();
+
+  /// \brief Print the amount of heap memory used by APValues since statistics
+  /// were enabled.
+  static void PrintStats();
+
   void printPretty(raw_ostream &OS, ASTContext &Ctx, QualType Ty) const;
   std::string getAsString(ASTContext &Ctx, QualType Ty) const;
 
@@ -232,7 +241,7 @@ public:
 
   APFloat &getComplexFloatReal() {
     assert(isComplexFloat() && "Invalid accessor");
-    return ((ComplexAPFloat*)(char*)Data.buffer)->Real;
+    return (*(ComplexAPFloat**)(char*)Data.buffer)->Real;
   }
   const APFloat &getComplexFloatReal() const {
     return const_cast<APValue*>(this)->getComplexFloatReal();
@@ -240,7 +249,7 @@ public:
 
   APFloat &getComplexFloatImag() {
     assert(isComplexFloat() && "Invalid accessor");
-    return ((ComplexAPFloat*)(char*)Data.buffer)->Imag;
+    return (*(ComplexAPFloat**)(char*)Data.buffer)->Imag;
   }
   const APFloat &getComplexFloatImag() const {
     return const_cast<APValue*>(this)->getComplexFloatImag();
@@ -354,13 +363,7 @@ public:
     assert(isFloat() && "Invalid accessor");
     *(APFloat *)(char *)Data.buffer = std::move(F);
   }
-  void setVector(const APValue *E, unsigned N) {
-    assert(isVector() && "Invalid accessor");
-    ((Vec*)(char*)Data.buffer)->Elts = new APValue[N];
-    ((Vec*)(char*)Data.buffer)->NumElts = N;
-    for (unsigned i = 0; i != N; ++i)
-      ((Vec*)(char*)Data.buffer)->Elts[i] = E[i];
-  }
+  void setVector(const APValue *E, unsigned N);
   void setComplexInt(APSInt R, APSInt I) {
     assert(R.getBitWidth() == I.getBitWidth() &&
            "Invalid complex int (type mismatch).");
@@ -372,8 +375,8 @@ public:
     assert(&R.getSemantics() == &I.getSemantics() &&
            "Invalid complex float (type mismatch).");
     assert(isComplexFloat() && "Invalid accessor");
-    ((ComplexAPFloat *)(char *)Data.buffer)->Real = std::move(R);
-    ((ComplexAPFloat *)(char *)Data.buffer)->Imag = std::move(I);
+    (*(ComplexAPFloat **)(char *)Data.buffer)->Real = std::move(R);
+    (*(ComplexAPFloat **)(char *)Data.buffer)->Imag = std::move(I);
   }
   void setLValue(LValueBase B, const CharUnits &O, NoLValuePath,
                  unsigned CallIndex, bool IsNullPtr);
@@ -423,11 +426,7 @@ private:
     new ((void*)(char*)Data.buffer) ComplexAPSInt();
     Kind = ComplexInt;
   }
-  void MakeComplexFloat() {
-    assert(isUninit() && "Bad state change");
-    new ((void*)(char*)Data.buffer) ComplexAPFloat();
-    Kind = ComplexFloat;
-  }
+  void MakeComplexFloat();
   void MakeLValue();
   void MakeArray(unsigned InitElts, unsigned Size);
   void MakeStruct(unsigned B, unsigned M) {
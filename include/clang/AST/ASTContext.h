@@ -80,11 +80,14 @@ struct fltSemantics;
 
 namespace clang {
 
+class ASTMemoryAccounting;
 class ASTMutationListener;
 class ASTRecordLayout;
 class AtomicExpr;
 class BlockExpr;
 class CharUnits;
+class ConstexprCallCache;
+class ConstexprInterpreter;
 class CXXABI;
 class DiagnosticsEngine;
 class Expr;
@@ -488,6 +491,15 @@ private:
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief Attribution of allocations to AST nodes, if enabled by
+  /// enableMemoryAccounting().
+  std::unique_ptr<ASTMemoryAccounting> MemoryAccounting;
+
+  /// \brief The context that AST nodes were attributed to before this one
+  /// enabled memory accounting, such as the context of the module importer
+  /// that this context builds a module for.
+  const ASTContext *OuterMemoryAccountingContext = nullptr;
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -623,7 +635,10 @@ public:
   }
 
   void *Allocate(size_t Size, unsigned Align = 8) const {
-    return BumpAlloc.Allocate(Size, Align);
+    void *Mem = BumpAlloc.Allocate(Size, Align);
+    if (LLVM_UNLIKELY(MemoryAccounting != nullptr))
+      noteAllocation(Mem, Size);
+    return Mem;
   }
   template <typename T> T *Allocate(size_t Num = 1) const {
     return static_cast<T *>(Allocate(Num * sizeof(T), alignof(T)));
@@ -638,6 +653,31 @@ public:
   /// Return the total memory used for various side tables.
   size_t getSideTableAllocatedMemory() const;
 
+  /// Return the memory used by the lookup tables of all DeclContexts.
+  size_t getDeclContextLookupTableMemory() const;
+
+  /// \brief Start attributing the memory allocated by this context to the
+  /// kinds of AST node, and the files, that caused it.
+  ///
+  /// This slows down allocation and keeps a record of every node, so it is
+  /// only meant for investigating memory usage. Only one context at a time
+  /// can attribute the declarations and statements it creates.
+  void enableMemoryAccounting();
+
+  /// \brief Print a breakdown of the memory allocated since
+  /// enableMemoryAccounting() was called, as text sorted by size or as JSON.
+  ///
+  /// \param Tables The sizes of other tables (for instance, Sema's) to list
+  /// along with this context's side tables.
+  void printMemoryReport(
+      raw_ostream &OS, bool JSON,
+      ArrayRef<std::pair<StringRef, size_t>> Tables = None) const;
+
+  /// \brief Note that a declaration or statement is being constructed, for
+  /// the memory report.
+  void noteNodeConstructed(const Decl *D) const;
+  void noteNodeConstructed(const Stmt *S) const;
+
   PartialDiagnostic::StorageAllocator &getDiagAllocator() {
     return DiagAllocator;
   }
@@ -1031,6 +1071,23 @@ public:
   /// with this AST context, if any.
   ASTMutationListener *getASTMutationListener() const { return Listener; }
 
+  typedef void (*DeclLookupChangedFnTy)(void *Cookie, DeclarationName Name);
+
+  /// \brief Register a function to be called whenever the declarations that
+  /// name lookup can find with a given name in a namespace or class may have
+  /// changed.
+  void setDeclLookupChangedFn(DeclLookupChangedFnTy Fn, void *Cookie) {
+    DeclLookupChangedFn = Fn;
+    DeclLookupChangedCookie = Cookie;
+  }
+
+  /// \brief Note that the declarations named \p Name in the lookup table of
+  /// some namespace or class may have changed.
+  void notifyDeclLookupChanged(DeclarationName Name) const {
+    if (DeclLookupChangedFn)
+      DeclLookupChangedFn(DeclLookupChangedCookie, Name);
+  }
+
   void PrintStats() const;
   const SmallVectorImpl<Type *>& getTypes() const { return Types; }
 
@@ -2100,6 +2157,14 @@ public:
 
   VTableContextBase *getVTableContext();
 
+  /// \brief Retrieve the bytecode interpreter for constexpr function calls,
+  /// creating it on first use.
+  ConstexprInterpreter &getConstexprInterpreter();
+
+  /// \brief Retrieve the cache of constexpr function call results, creating
+  /// it on first use.
+  ConstexprCallCache &getConstexprCallCache();
+
   MangleContext *createMangleContext();
 
   void DeepCollectObjCIvars(const ObjCInterfaceDecl *OI, bool leafClass,
@@ -2751,6 +2816,18 @@ private:
 
   std::unique_ptr<VTableContextBase> VTContext;
 
+  /// \brief The bytecode interpreter used by -fconstexpr-bytecode.
+  std::unique_ptr<ConstexprInterpreter> ConstexprInterp;
+
+  /// \brief Memoized constexpr call results, used by -fconstexpr-call-cache.
+  std::unique_ptr<ConstexprCallCache> ConstexprCalls;
+
+  /// \brief The function notified of changes to DeclContext lookup tables.
+  DeclLookupChangedFnTy DeclLookupChangedFn = nullptr;
+  void *DeclLookupChangedCookie = nullptr;
+
+  void noteAllocation(const void *Mem, size_t Size) const;
+
 public:
   enum PragmaSectionFlag : unsigned {
     PSF_None = 0,
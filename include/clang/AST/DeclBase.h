@@ -306,6 +306,11 @@ private:
   /// \brief Whether statistic collection is enabled.
   static bool StatisticsEnabled;
 
+  /// \brief Whether any thread has attributed the memory of declarations to
+  /// a context's memory report. Only then is the thread's context looked up.
+  static bool MemoryAccountingEnabled;
+  static void noteConstructed(const Decl *D);
+
 protected:
   friend class ASTDeclReader;
   friend class ASTDeclWriter;
@@ -371,6 +376,7 @@ protected:
         IdentifierNamespace(getIdentifierNamespaceForKind(DK)),
         CacheValidAndLinkage(0) {
     if (StatisticsEnabled) add(DK);
+    if (MemoryAccountingEnabled) noteConstructed(this);
   }
 
   Decl(Kind DK, EmptyShell Empty)
@@ -380,6 +386,7 @@ protected:
         IdentifierNamespace(getIdentifierNamespaceForKind(DK)),
         CacheValidAndLinkage(0) {
     if (StatisticsEnabled) add(DK);
+    if (MemoryAccountingEnabled) noteConstructed(this);
   }
 
   virtual ~Decl();
@@ -988,6 +995,11 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Attribute the memory of declarations created on this thread from
+  /// now on to \p Ctx's memory report, or stop doing so if \p Ctx is null.
+  static void setMemoryAccountingContext(const ASTContext *Ctx);
+  static const ASTContext *getMemoryAccountingContext();
+
   /// isTemplateParameter - Determines whether this declaration is a
   /// template parameter.
   bool isTemplateParameter() const;
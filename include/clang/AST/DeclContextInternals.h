@@ -17,11 +17,14 @@
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclarationName.h"
-#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/AlignOf.h"
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
 
 namespace clang {
 
@@ -236,15 +239,157 @@ public:
   }
 };
 
-class StoredDeclsMap
-  : public llvm::SmallDenseMap<DeclarationName, StoredDeclsList, 4> {
-
+/// \brief The lookup table of a DeclContext, mapping each name declared in
+/// the context to the declarations with that name.
+///
+/// This is an open-addressing hash table specialized for the way name lookup
+/// uses it: entries are never removed (a name whose declarations have all
+/// been removed just keeps an empty list), so probing is linear and needs no
+/// tombstones, and the names are pointers, so they are scattered with a
+/// multiplicative hash rather than relying on the low bits of addresses that
+/// tend to be allocated consecutively. Small tables live inline in the map.
+class StoredDeclsMap {
 public:
+  typedef std::pair<DeclarationName, StoredDeclsList> value_type;
+
+  class iterator {
+    value_type *Ptr = nullptr;
+    value_type *End = nullptr;
+
+    void skipEmptyBuckets() {
+      while (Ptr != End && isEmptyKey(Ptr->first))
+        ++Ptr;
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef StoredDeclsMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type *pointer;
+    typedef value_type &reference;
+
+    iterator() {}
+    iterator(value_type *Ptr, value_type *End) : Ptr(Ptr), End(End) {
+      skipEmptyBuckets();
+    }
+
+    reference operator*() const { return *Ptr; }
+    pointer operator->() const { return Ptr; }
+
+    iterator &operator++() {
+      ++Ptr;
+      skipEmptyBuckets();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator Tmp(*this);
+      ++*this;
+      return Tmp;
+    }
+
+    friend bool operator==(iterator LHS, iterator RHS) {
+      return LHS.Ptr == RHS.Ptr;
+    }
+    friend bool operator!=(iterator LHS, iterator RHS) {
+      return LHS.Ptr != RHS.Ptr;
+    }
+  };
+
+  StoredDeclsMap();
+  ~StoredDeclsMap();
+
+  StoredDeclsMap(const StoredDeclsMap &) = delete;
+  StoredDeclsMap &operator=(const StoredDeclsMap &) = delete;
+
+  iterator begin() { return iterator(Buckets, Buckets + NumBuckets); }
+  iterator end() {
+    return iterator(Buckets + NumBuckets, Buckets + NumBuckets);
+  }
+
+  unsigned size() const { return NumEntries; }
+  bool empty() const { return NumEntries == 0; }
+
+  iterator find(DeclarationName Name) {
+    value_type *Bucket = lookupBucket(Name);
+    if (isEmptyKey(Bucket->first))
+      return end();
+    return iterator(Bucket, Buckets + NumBuckets);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&KV) {
+    value_type *Bucket = lookupBucket(KV.first);
+    if (!isEmptyKey(Bucket->first))
+      return std::make_pair(iterator(Bucket, Buckets + NumBuckets), false);
+
+    // Keep the table at most three quarters full, so that probe sequences
+    // stay short and always reach an empty bucket.
+    if ((NumEntries + 1) * 4 > NumBuckets * 3) {
+      grow(NumBuckets * 2);
+      Bucket = lookupBucket(KV.first);
+    }
+    Bucket->first = KV.first;
+    Bucket->second = std::move(KV.second);
+    ++NumEntries;
+    return std::make_pair(iterator(Bucket, Buckets + NumBuckets), true);
+  }
+
+  StoredDeclsList &operator[](DeclarationName Name) {
+    return insert(value_type(Name, StoredDeclsList())).first->second;
+  }
+
+  /// \brief Make room for \p NumNames names without further reallocation.
+  void reserve(unsigned NumNames) {
+    if (NumNames * 4 > NumBuckets * 3)
+      grow(NumNames * 4 / 3 + 1);
+  }
+
+  unsigned getNumBuckets() const { return NumBuckets; }
+
+  /// \brief Return the number of bytes allocated outside of the map itself.
+  size_t getMemorySize() const {
+    return isSmall() ? 0 : NumBuckets * sizeof(value_type);
+  }
+
   static void DestroyAll(StoredDeclsMap *Map, bool Dependent);
 
 private:
   friend class ASTContext; // walks the chain deleting these
   friend class DeclContext;
+
+  enum { NumInlineBuckets = 4, Log2NumInlineBuckets = 2 };
+
+  static bool isEmptyKey(DeclarationName Name) {
+    return Name == DeclarationName::getEmptyMarker();
+  }
+
+  value_type *getInlineBuckets() {
+    return reinterpret_cast<value_type *>(InlineBuckets.buffer);
+  }
+  bool isSmall() const { return NumBuckets == NumInlineBuckets; }
+
+  /// \brief Return the bucket holding \p Name, or the empty bucket where it
+  /// would be inserted.
+  value_type *lookupBucket(DeclarationName Name) const {
+    assert(!isEmptyKey(Name) && "looking up the empty marker");
+    uint64_t Hash = reinterpret_cast<uintptr_t>(Name.getAsOpaquePtr()) *
+                    UINT64_C(0x9E3779B97F4A7C15);
+    unsigned Mask = NumBuckets - 1;
+    for (unsigned I = unsigned(Hash >> (64 - Log2NumBuckets));;
+         I = (I + 1) & Mask) {
+      value_type *Bucket = Buckets + I;
+      if (Bucket->first == Name || isEmptyKey(Bucket->first))
+        return Bucket;
+    }
+  }
+
+  void grow(unsigned MinBuckets);
+
+  value_type *Buckets;
+  unsigned NumBuckets = NumInlineBuckets;
+  unsigned Log2NumBuckets = Log2NumInlineBuckets;
+  unsigned NumEntries = 0;
+  llvm::AlignedCharArrayUnion<value_type[NumInlineBuckets]> InlineBuckets;
+
   llvm::PointerIntPair<StoredDeclsMap*, 1> Previous;
 };
 
@@ -361,6 +361,11 @@ private:
   /// \brief Whether statistic collection is enabled.
   static bool StatisticsEnabled;
 
+  /// \brief Whether any thread has attributed the memory of statements to a
+  /// context's memory report. Only then is the thread's context looked up.
+  static bool MemoryAccountingEnabled;
+  static void noteConstructed(const Stmt *S);
+
 protected:
   /// \brief Construct an empty statement.
   explicit Stmt(StmtClass SC, EmptyShell) : Stmt(SC) {}
@@ -373,6 +378,7 @@ public:
                   "Insufficient alignment!");
     StmtBits.sClass = SC;
     if (StatisticsEnabled) Stmt::addStmtClass(SC);
+    if (MemoryAccountingEnabled) noteConstructed(this);
   }
 
   StmtClass getStmtClass() const {
@@ -393,6 +399,10 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Attribute the memory of statements created on this thread from
+  /// now on to \p Ctx's memory report, or stop doing so if \p Ctx is null.
+  static void setMemoryAccountingContext(const ASTContext *Ctx);
+
   /// \brief Dumps the specified AST fragment and all subtrees to
   /// \c llvm::errs().
   void dump() const;
@@ -389,6 +389,9 @@ public:
     return *VTableLayouts[RD];
   }
 
+  /// \brief Return the number of classes whose vtable layout was computed.
+  unsigned getNumVTableLayouts() const { return VTableLayouts.size(); }
+
   std::unique_ptr<VTableLayout> createConstructionVTableLayout(
       const CXXRecordDecl *MostDerivedClass, CharUnits MostDerivedClassOffset,
       bool MostDerivedClassIsVirtual, const CXXRecordDecl *LayoutClass);
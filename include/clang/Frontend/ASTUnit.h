@@ -51,6 +51,7 @@ class Decl;
 class DiagnosticsEngine;
 class FileEntry;
 class FileManager;
+class FunctionDecl;
 class HeaderSearch;
 class InputKind;
 class MemoryBufferCache;
@@ -839,6 +840,12 @@ public:
                     SmallVectorImpl<StoredDiagnostic> &StoredDiagnostics,
                     SmallVectorImpl<const llvm::MemoryBuffer *> &OwnedBuffers);
 
+  /// \brief Parse the body of \p FD, which was skipped because the translation
+  /// unit was parsed with -skip-non-main-file-function-bodies.
+  ///
+  /// \returns true if \p FD has a body afterwards.
+  bool parseSkippedFunctionBody(FunctionDecl *FD);
+
   /// \brief Save this translation unit to a file with the given name.
   ///
   /// \returns true if there was a file error or false if the save was
@@ -99,6 +99,11 @@ public:
     ProfileIRInstr,    // IR level PGO instrumentation in LLVM.
   };
 
+  enum CoverageCountersKind {
+    CoverageCountersFull, // Update the counters in memory on each execution.
+    CoverageCountersFast, // Keep the counters of loops in registers.
+  };
+
   enum EmbedBitcodeKind {
     Embed_Off,      // No embedded bitcode.
     Embed_All,      // Embed both bitcode and commandline in the output.
@@ -195,6 +200,19 @@ public:
   /// Name of the profile file to use as input for -fprofile-instr-use
   std::string ProfileInstrumentUsePath;
 
+  /// The manifest that assigns inline functions and template instantiations
+  /// to the translation unit that defines them, from -finstantiation-homes=.
+  std::string InstantiationHomesFile;
+
+  /// The file that the inline functions and template instantiations defined
+  /// by this translation unit are written to, from
+  /// -femit-instantiation-homes=.
+  std::string EmitInstantiationHomesFile;
+
+  /// The directory that optimized partitions of the module are cached in, or
+  /// empty if they are not cached.
+  std::string CodeGenCachePath;
+
   /// Name of the function summary index file to use for ThinLTO function
   /// importing.
   std::string ThinLTOIndexFile;
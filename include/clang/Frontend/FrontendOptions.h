@@ -178,6 +178,8 @@ public:
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
   unsigned ShowVersion : 1;                ///< Show the -version text.
+  unsigned PrintModuleCacheStats : 1;      ///< Show the module cache
+                                           /// statistics.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
   unsigned FixOnlyWarnings : 1;            ///< Apply fixes only for warnings.
@@ -189,6 +191,10 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned SkipNonMainFileFunctionBodies : 1; ///< Skip over function bodies
+                                           /// outside of the main file,
+                                           /// keeping their tokens so they
+                                           /// can be parsed on demand.
   unsigned UseGlobalModuleIndex : 1;       ///< Whether we can use the
                                            ///< global module index if available.
   unsigned GenerateGlobalModuleIndex : 1;  ///< Whether we can generate the
@@ -256,6 +262,14 @@ public:
   unsigned ObjCMTAction;
   std::string ObjCMTWhiteListPath;
 
+  /// \brief Whether to attribute AST memory to node kinds and files, and in
+  /// what format to report it.
+  enum {
+    AMR_None,
+    AMR_Text,
+    AMR_JSON
+  } ASTMemoryReport;
+
   std::string MTMigrateDir;
   std::string ARCMTMigrateReportOut;
 
@@ -331,13 +345,16 @@ public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
     ShowStats(false), ShowTimers(false), ShowVersion(false),
+    PrintModuleCacheStats(false),
     FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
-    SkipFunctionBodies(false), UseGlobalModuleIndex(true),
+    SkipFunctionBodies(false), SkipNonMainFileFunctionBodies(false),
+    UseGlobalModuleIndex(true),
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
     BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
     IncludeTimestamps(true), ARCMTAction(ARCMT_None),
-    ObjCMTAction(ObjCMT_None), ProgramAction(frontend::ParseSyntaxOnly)
+    ObjCMTAction(ObjCMT_None), ASTMemoryReport(AMR_None),
+    ProgramAction(frontend::ParseSyntaxOnly)
   {}
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
@@ -0,0 +1,98 @@
+//===--- ModuleCache.h - Storage of implicitly built modules ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the maintenance of the implicit module cache beyond
+// pruning by age: storing module files by content, so that identical module
+// files built for different configurations share their storage, bounding the
+// size of the cache, and accounting for how the cache is used.
+//
+// A module file stored by content is hard-linked from the 'objects' directory
+// of the module cache, under the hash of its content. A module file that is
+// identical to one already stored is replaced with a link to it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_MODULECACHE_H
+#define LLVM_CLANG_FRONTEND_MODULECACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+
+namespace clang {
+
+/// \brief Counts of how compilations used a module cache.
+struct ModuleCacheStats {
+  /// Module files that were found in the cache and loaded.
+  unsigned Hits = 0;
+
+  /// Module files that were built because they were not in the cache.
+  unsigned Missing = 0;
+
+  /// Module files that were rebuilt because they were out of date.
+  unsigned OutOfDate = 0;
+
+  /// Module builds that failed.
+  unsigned Failed = 0;
+
+  /// Module files built ahead of their import by -fmodules-build-threads.
+  unsigned Scheduled = 0;
+
+  /// Module files that were stored by content.
+  unsigned Stored = 0;
+
+  /// Module files that were identical to a stored one, and share it.
+  unsigned Deduplicated = 0;
+
+  bool empty() const {
+    return !Hits && !Missing && !OutOfDate && !Failed && !Scheduled &&
+           !Stored && !Deduplicated;
+  }
+
+  ModuleCacheStats &operator+=(const ModuleCacheStats &Other);
+
+  void print(raw_ostream &OS) const;
+};
+
+/// \brief The outcome of storing a module file by content.
+enum class ModuleFileStoreResult {
+  /// The module file was stored.
+  Stored,
+  /// The module file was replaced with a link to an identical one.
+  Deduplicated,
+  /// The module file could not be stored, and was left alone.
+  Failed
+};
+
+/// \brief Store the module file \p ModuleFileName, which was just written to
+/// the module cache at \p CachePath, by its content.
+///
+/// The caller must hold the lock on \p ModuleFileName.
+ModuleFileStoreResult storeModuleFileByContent(StringRef CachePath,
+                                               StringRef ModuleFileName);
+
+/// \brief Remove the stored module files that no module file links to any
+/// more.
+void removeUnusedModuleFileObjects(StringRef CachePath);
+
+/// \brief Remove the least recently used module files from the module cache
+/// at \p CachePath until it takes at most \p MaxSize bytes.
+void limitModuleCacheSize(StringRef CachePath, uint64_t MaxSize);
+
+/// \brief Add \p Stats to the counts recorded in the module cache at
+/// \p CachePath.
+void recordModuleCacheStats(StringRef CachePath, const ModuleCacheStats &Stats);
+
+/// \brief Print the size of the module cache at \p CachePath, and the counts
+/// recorded in it.
+void printModuleCacheStats(StringRef CachePath, raw_ostream &OS);
+
+} // end namespace clang
+
+#endif
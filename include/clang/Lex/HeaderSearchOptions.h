@@ -141,6 +141,16 @@ public:
   /// regenerated often.
   unsigned ModuleCachePruneAfter;
 
+  /// \brief The number of threads used to build the missing modules that an
+  /// implicitly built module depends on, before building it.
+  ///
+  /// With 0 or 1, each module is built when it is first imported.
+  unsigned ModuleBuildThreads;
+
+  /// \brief The size (in megabytes) that pruning reduces the module cache
+  /// to, by removing the least recently used module files, or 0 for no limit.
+  unsigned ModuleCacheMaxSize;
+
   /// \brief The time in seconds when the build session started.
   ///
   /// This time is used by other optimizations in header search and module
@@ -174,6 +184,19 @@ public:
   /// \c BuildSessionTimestamp).
   unsigned ModulesValidateOncePerBuildSession : 1;
 
+  /// \brief If true, record the module files whose input files were all
+  /// validated during this build session in the module cache, and don't
+  /// validate the input files of those module files again in this session.
+  ///
+  /// Unlike \c ModulesValidateOncePerBuildSession, this also skips the user
+  /// input files, and it costs one read of the module cache per compilation
+  /// rather than a stat per module file.
+  unsigned ModulesShareSessionValidation : 1;
+
+  /// \brief If true, an input file whose modification time changed but whose
+  /// size did not is only considered changed if its contents changed.
+  unsigned ValidateASTInputFilesContent : 1;
+
   /// \brief Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
@@ -184,16 +207,27 @@ public:
 
   unsigned ModulesHashContent : 1;
 
+  /// \brief Whether implicitly built module files are stored by content in
+  /// the module cache, so that identical ones share their storage.
+  unsigned ModulesCacheDedup : 1;
+
+  /// \brief Whether to record how the module cache was used in it.
+  unsigned ModulesCacheStats : 1;
+
   HeaderSearchOptions(StringRef _Sysroot = "/")
       : Sysroot(_Sysroot), ModuleFormat("raw"), DisableModuleHash(0),
         ImplicitModuleMaps(0), ModuleMapFileHomeIsCwd(0),
         ModuleCachePruneInterval(7 * 24 * 60 * 60),
-        ModuleCachePruneAfter(31 * 24 * 60 * 60), BuildSessionTimestamp(0),
+        ModuleCachePruneAfter(31 * 24 * 60 * 60), ModuleBuildThreads(0),
+        ModuleCacheMaxSize(0), BuildSessionTimestamp(0),
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
+        ModulesShareSessionValidation(false),
+        ValidateASTInputFilesContent(false),
         ModulesValidateSystemHeaders(false), UseDebugInfo(false),
-        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false) {}
+        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false),
+        ModulesCacheDedup(false), ModulesCacheStats(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
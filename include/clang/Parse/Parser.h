@@ -297,6 +297,15 @@ public:
   ///
   void Initialize();
 
+  /// \brief Parse the body of a function that was skipped, and whose tokens
+  /// were retained, while Sema::SkipNonMainFileFunctionBodies was set.
+  ///
+  /// This can be used after the translation unit has been parsed, as long as
+  /// the preprocessor and Sema used to parse it are still alive.
+  ///
+  /// \returns true if \p FD has a body afterwards.
+  bool ParseSkippedFunctionBody(FunctionDecl *FD);
+
   /// Parse the first top-level declaration in a translation unit.
   bool ParseFirstTopLevelDecl(DeclGroupPtrTy &Result);
 
@@ -1944,8 +1953,11 @@ private:
   /// \brief When in code-completion, skip parsing of the function/method body
   /// unless the body contains the code-completion point.
   ///
+  /// If Sema::SkipNonMainFileFunctionBodies is set, the tokens of the skipped
+  /// body of \p D are retained so that it can be parsed later.
+  ///
   /// \returns true if the function body was skipped.
-  bool trySkippingFunctionBody();
+  bool trySkippingFunctionBody(Decl *D);
 
   bool ParseImplicitInt(DeclSpec &DS, CXXScopeSpec *SS,
                         const ParsedTemplateInfo &TemplateInfo,
@@ -28,6 +28,7 @@ class ExternalPreprocessorSource;
 class NamedDecl;
 class Preprocessor;
 class Scope;
+class UnqualifiedLookupCache;
   
 /// IdentifierResolver - Keeps track of shadowed decls on enclosing
 /// scopes.  It manages the shadowing chains of declaration names and
@@ -170,12 +171,17 @@ public:
   /// \returns true if the declaration was added, false otherwise.
   bool tryAddTopLevelDecl(NamedDecl *D, DeclarationName Name);
   
+  /// \brief Set the cache of lookup results to invalidate whenever the
+  /// declarations with a name change.
+  void setLookupCache(UnqualifiedLookupCache *Cache) { LookupCache = Cache; }
+
   explicit IdentifierResolver(Preprocessor &PP);
   ~IdentifierResolver();
 
 private:
   const LangOptions &LangOpt;
   Preprocessor &PP;
+  UnqualifiedLookupCache *LookupCache = nullptr;
   
   class IdDeclInfoMap;
   IdDeclInfoMap *IdDeclInfos;
@@ -295,12 +295,20 @@ public:
            (isForExternalRedeclaration() && ND->isExternallyDeclarable());
   }
 
+  /// \brief Determine whether this lookup is permitted to see all hidden
+  /// declarations.
+  bool isAllowingHidden() const { return AllowHidden; }
+
   /// Sets whether tag declarations should be hidden by non-tag
   /// declarations during resolution.  The default is true.
   void setHideTags(bool Hide) {
     HideTags = Hide;
   }
 
+  /// Determine whether tag declarations are hidden by non-tag declarations
+  /// during resolution.
+  bool isHidingTags() const { return HideTags; }
+
   bool isAmbiguous() const {
     return getResultKind() == Ambiguous;
   }
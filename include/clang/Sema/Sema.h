@@ -181,7 +181,9 @@ namespace clang {
   class TypedefNameDecl;
   class TypeLoc;
   class TypoCorrectionConsumer;
+  class TypoCorrectionIndex;
   class UnqualifiedId;
+  class UnqualifiedLookupCache;
   class UnresolvedLookupExpr;
   class UnresolvedMemberExpr;
   class UnresolvedSetImpl;
@@ -624,6 +626,15 @@ public:
       LateParsedTemplateMapT;
   LateParsedTemplateMapT LateParsedTemplateMap;
 
+  /// \brief Whether only the bodies of functions outside of the main file may
+  /// be skipped, in which case their tokens are kept in
+  /// SkippedFunctionBodies so that they can be parsed on demand.
+  bool SkipNonMainFileFunctionBodies;
+
+  /// \brief The tokens of function bodies skipped while
+  /// SkipNonMainFileFunctionBodies is set, keyed by function.
+  LateParsedTemplateMapT SkippedFunctionBodies;
+
   /// \brief Callback to the parser to parse templated functions when needed.
   typedef void LateTemplateParserCB(void *P, LateParsedTemplate &LPT);
   typedef void LateTemplateParserCleanupCB(void *P);
@@ -1211,6 +1222,9 @@ public:
 
   void PrintStats() const;
 
+  /// \brief Return the total memory used by Sema's side tables.
+  size_t getSideTableAllocatedMemory() const;
+
   /// \brief Helper class that creates diagnostics with optional
   /// template instantiation stacks.
   ///
@@ -3096,6 +3110,23 @@ public:
 
 private:
   bool CppLookupName(LookupResult &R, Scope *S);
+  bool CppLookupNameUncached(LookupResult &R, Scope *S);
+
+  /// \brief Cached results of CppLookupName, used by
+  /// -fcache-unqualified-lookup.
+  std::unique_ptr<UnqualifiedLookupCache> UnqualifiedLookups;
+
+  /// \brief Forget all cached unqualified lookup results, after a change that
+  /// can affect the lookup of any name.
+  void invalidateUnqualifiedLookups();
+
+  /// \brief Forget the cached results of unqualified lookups from \p S,
+  /// which is being popped.
+  void invalidateUnqualifiedLookupsFrom(Scope *S);
+
+  /// \brief Index of the identifiers in the translation unit, used to find
+  /// candidates for unqualified typo correction.
+  std::unique_ptr<TypoCorrectionIndex> TypoIndex;
 
   struct TypoExprState {
     std::unique_ptr<TypoCorrectionConsumer> Consumer;
@@ -5805,6 +5836,8 @@ public:
   void MarkAsLateParsedTemplate(FunctionDecl *FD, Decl *FnD,
                                 CachedTokens &Toks);
   void UnmarkAsLateParsedTemplate(FunctionDecl *FD);
+  void MarkAsSkippedFunctionBody(FunctionDecl *FD, Decl *FnD,
+                                 CachedTokens &Toks);
   bool IsInsideALocalClassWithinATemplateFunction();
 
   Decl *ActOnStaticAssertDeclaration(SourceLocation StaticAssertLoc,
@@ -7485,6 +7518,24 @@ public:
   /// \brief The number of typos corrected by CorrectTypo.
   unsigned TyposCorrected;
 
+  /// \brief Statistics on the cost of typo correction.
+  struct TypoCorrectionStats {
+    /// The number of typos that were not corrected because of
+    /// -fspell-checking-limit or -ftypo-correction-budget.
+    unsigned NumOverLimit = 0;
+    unsigned NumOverBudget = 0;
+
+    /// The number of edit distances computed.
+    uint64_t NumEditDistances = 0;
+
+    /// The time spent looking for corrections, in nanoseconds.
+    uint64_t Time = 0;
+  } TypoCorrectionCost;
+
+  /// \brief Whether the time allowed for typo correction by
+  /// -ftypo-correction-budget has been used up.
+  bool isTypoCorrectionBudgetExhausted() const;
+
   typedef llvm::SmallSet<SourceLocation, 2> SrcLocSet;
   typedef llvm::DenseMap<IdentifierInfo *, SrcLocSet> IdentifierSourceLocations;
 
@@ -364,7 +364,10 @@ namespace serialization {
     /// inside the control block.
     enum InputFileRecordTypes {
       /// \brief An input file.
-      INPUT_FILE = 1
+      INPUT_FILE = 1,
+
+      /// \brief A hash of the contents of the preceding input file.
+      INPUT_FILE_HASH
     };
 
     /// \brief Record types that occur within the AST block itself.
@@ -54,6 +54,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Bitcode/BitstreamReader.h"
@@ -959,6 +960,47 @@ private:
   /// in the chain.
   unsigned TotalNumStatements = 0;
 
+  /// \brief The number of function and method bodies that have been attached
+  /// to declarations without being read, the number of those that have since
+  /// been read, and the number of statements they contained.
+  unsigned NumLazyBodies = 0;
+  unsigned NumLazyBodiesRead = 0;
+  unsigned NumBodyStatementsRead = 0;
+
+  /// \brief The number of bodies that were not attached because the function
+  /// already had a definition from another module.
+  unsigned NumMergedBodies = 0;
+
+  /// \brief The number of lists of constructor initializers that have been
+  /// seen, and the number of those that have been read.
+  unsigned NumLazyCtorInitializers = 0;
+  unsigned NumCtorInitializersRead = 0;
+
+  /// \brief The number of module files whose input files were validated,
+  /// and the number of those that were trusted instead, because they had been
+  /// validated earlier in the build session.
+  unsigned NumModuleFilesValidated = 0;
+  unsigned NumModuleFilesTrusted = 0;
+
+  /// \brief The number of input files that were validated, and the number
+  /// of those that were found to be unchanged by their contents after their
+  /// modification time changed.
+  unsigned NumInputFilesValidated = 0;
+  unsigned NumInputFilesMatchedByContent = 0;
+
+  /// \brief The time spent validating input files, in nanoseconds.
+  uint64_t InputFileValidationTime = 0;
+
+  /// \brief Whether the list of the module files validated in this build
+  /// session has been read from the module cache, and whether the module
+  /// cache has a list for this session.
+  bool ReadSessionValidations = false;
+  bool SessionValidationsAreCurrent = false;
+
+  /// \brief The signatures of the module files validated in this build
+  /// session.
+  llvm::StringSet<> SessionValidations;
+
   /// \brief The number of macros de-serialized from the chain.
   unsigned NumMacrosRead = 0;
 
@@ -1189,6 +1231,9 @@ private:
     bool Overridden;
     bool Transient;
     bool TopLevelModuleMap;
+
+    /// A hash of the contents of the file, or 0 if none was recorded.
+    uint64_t ContentHash;
   };
 
   /// \brief Reads the stored information about an input file.
@@ -1278,6 +1323,18 @@ private:
                                ASTReaderListener *Listener,
                                bool ValidateDiagnosticOptions);
 
+  /// Read the list of the module files validated in this build session.
+  void readSessionValidations();
+
+  /// Whether the input files of \p F were validated earlier in this build
+  /// session, by this or another compilation, with
+  /// -fmodules-share-session-validation.
+  bool wasValidatedInSession(const ModuleFile &F);
+
+  /// Record in the module cache that the input files of the module files
+  /// in \p Loaded were validated in this build session.
+  void recordSessionValidations(ArrayRef<ImportedModule> Loaded);
+
   ASTReadResult ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities);
   ASTReadResult ReadExtensionBlock(ModuleFile &F);
   void ReadModuleOffsetMap(ModuleFile &F) const;
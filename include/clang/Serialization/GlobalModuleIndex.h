@@ -10,7 +10,8 @@
 // This file defines the GlobalModuleIndex class, which manages a global index
 // containing all of the identifiers known to the various modules within a given
 // subdirectory of the module cache. It is used to improve the performance of
-// queries such as "do any modules know about this identifier?"
+// queries such as "do any modules know about this identifier?" and "which
+// modules declare something with this name?"
 //
 //===----------------------------------------------------------------------===//
 #ifndef LLVM_CLANG_SERIALIZATION_GLOBALMODULEINDEX_H
@@ -70,6 +71,14 @@ class GlobalModuleIndex {
   /// GlobalModuleIndex.
   void *IdentifierIndex;
 
+  /// \brief The hash table mapping the hashes of declaration names to the
+  /// module files whose declaration context lookup tables contain them.
+  ///
+  /// This pointer actually points to a DeclNameIndexTable object,
+  /// but that type is only accessible within the implementation of
+  /// GlobalModuleIndex.
+  void *DeclNameIndex;
+
   /// \brief Information about a given module file.
   struct ModuleInfo {
     ModuleInfo() : File(), Size(), ModTime() { }
@@ -115,6 +124,13 @@ class GlobalModuleIndex {
   /// \brief The number of identifier lookup hits, where we recognize the
   /// identifier.
   unsigned NumIdentifierLookupHits;
+
+  /// \brief The number of declaration name lookups we performed.
+  unsigned NumDeclNameLookups;
+
+  /// \brief The number of module files that declaration name lookups found,
+  /// in total.
+  unsigned NumDeclNameLookupModuleFiles;
   
   /// \brief Internal constructor. Use \c readIndex() to read an index.
   explicit GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
@@ -179,6 +195,27 @@ public:
   /// \returns true if the identifier is known to the index, false otherwise.
   bool lookupIdentifier(StringRef Name, HitSet &Hits);
 
+  /// \brief Look for all of the module files whose declaration context lookup
+  /// tables contain a name with the given hash.
+  ///
+  /// \param NameHash The hash of the declaration name, as stored in the
+  /// lookup tables of module files.
+  ///
+  /// \param Hits Will be populated with the set of module files that may
+  /// declare something with this name in some declaration context. Module
+  /// files that the index does not know about (see \c hasModuleFile) are not
+  /// included, and may declare it as well.
+  ///
+  /// \returns true if the index has information about declaration names,
+  /// false otherwise.
+  bool lookupDeclName(unsigned NameHash, HitSet &Hits);
+
+  /// \brief Determine whether the index has up-to-date information about the
+  /// given loaded module file.
+  bool hasModuleFile(ModuleFile *File) const {
+    return ModulesByFile.count(File);
+  }
+
   /// \brief Note that the given module file has been loaded.
   ///
   /// \returns false if the global module index has information about this
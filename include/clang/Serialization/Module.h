@@ -224,6 +224,10 @@ public:
   /// The time is specified in seconds since the start of the Epoch.
   uint64_t InputFilesValidationTimestamp = 0;
 
+  /// \brief Whether all of the input files were validated when this module
+  /// file was loaded.
+  bool AllInputFilesValidated = false;
+
   // === Source Locations ===
 
   /// \brief Cursor used to read source location entries.
@@ -243,7 +247,8 @@ public:
   const uint32_t *SLocEntryOffsets = nullptr;
 
   /// \brief SLocEntries that we're going to preload.
-  SmallVector<uint64_t, 4> PreloadSLocEntries;
+  const uint32_t *PreloadSLocEntries = nullptr;
+  unsigned NumPreloadSLocEntries = 0;
 
   /// \brief Remapping table for source locations in this module.
   ContinuousRangeMap<uint32_t, int, 2> SLocRemap;
@@ -19,21 +19,74 @@
 #include "clang/AST/Type.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 using namespace clang;
 
+// Heap memory used by APValues. The bytes in use are always tracked, so that
+// freeing memory allocated before statistics were enabled cannot make them
+// negative; the rest is only tracked once statistics are enabled. Modules may
+// be built on several threads at once, so the counters are atomic.
+static std::atomic<bool> StatisticsEnabled(false);
+static std::atomic<uint64_t> NumAllocations(0);
+static std::atomic<uint64_t> BytesAllocated(0);
+static std::atomic<int64_t> LiveBytes(0);
+static std::atomic<int64_t> PeakLiveBytes(0);
+
+static void noteAllocation(size_t Bytes) {
+  int64_t Live =
+      LiveBytes.fetch_add(Bytes, std::memory_order_relaxed) + int64_t(Bytes);
+  if (!StatisticsEnabled.load(std::memory_order_relaxed))
+    return;
+  NumAllocations.fetch_add(1, std::memory_order_relaxed);
+  BytesAllocated.fetch_add(Bytes, std::memory_order_relaxed);
+  int64_t Peak = PeakLiveBytes.load(std::memory_order_relaxed);
+  while (Live > Peak &&
+         !PeakLiveBytes.compare_exchange_weak(Peak, Live,
+                                              std::memory_order_relaxed))
+    ;
+}
+
+static void noteDeallocation(size_t Bytes) {
+  LiveBytes.fetch_sub(Bytes, std::memory_order_relaxed);
+}
+
+void APValue::EnableStatistics() {
+  StatisticsEnabled = true;
+}
+
+void APValue::PrintStats() {
+  llvm::errs() << "\n*** APValue Stats:\n";
+  llvm::errs() << "  sizeof(APValue) = " << sizeof(APValue) << " bytes\n";
+  llvm::errs() << "  " << NumAllocations.load() << " heap allocations, "
+               << BytesAllocated.load() << " bytes total\n";
+  llvm::errs() << "  " << PeakLiveBytes.load() << " bytes peak heap usage\n";
+  llvm::errs() << "  " << LiveBytes.load() << " bytes still in use\n";
+}
+
 namespace {
   struct LVBase {
     llvm::PointerIntPair<APValue::LValueBase, 1, bool> BaseAndIsOnePastTheEnd;
     CharUnits Offset;
     unsigned PathLength;
-    unsigned CallIndex;
-    bool IsNullPtr;
+    /// Keeping the null pointer flag in the same word as the call index
+    /// leaves room for an inline path entry. The base has only one spare bit
+    /// on hosts where expressions are 4-byte aligned.
+    unsigned CallIndex : 31;
+    unsigned IsNullPtr : 1;
+
+    void setBase(APValue::LValueBase B, bool IsOnePastTheEnd, bool IsNull) {
+      BaseAndIsOnePastTheEnd.setPointerAndInt(B, IsOnePastTheEnd);
+      IsNullPtr = IsNull;
+    }
+    bool isOnePastTheEnd() const { return BaseAndIsOnePastTheEnd.getInt(); }
+    bool isNullPtr() const { return IsNullPtr; }
   };
 }
 
 struct APValue::LV : LVBase {
   static const unsigned InlinePathSpace =
       (DataSize - sizeof(LVBase)) / sizeof(LValuePathEntry);
+  static_assert(InlinePathSpace >= 1, "no room for an inline path entry");
 
   /// Path - The sequence of base classes, fields and array indices to follow to
   /// walk from Base to the subobject. When performing GCC-style folding, there
@@ -49,11 +102,15 @@ struct APValue::LV : LVBase {
   void resizePath(unsigned Length) {
     if (Length == PathLength)
       return;
-    if (hasPathPtr())
+    if (hasPathPtr()) {
       delete [] PathPtr;
+      noteDeallocation(PathLength * sizeof(LValuePathEntry));
+    }
     PathLength = Length;
-    if (hasPathPtr())
+    if (hasPathPtr()) {
       PathPtr = new LValuePathEntry[Length];
+      noteAllocation(Length * sizeof(LValuePathEntry));
+    }
   }
 
   bool hasPath() const { return PathLength != (unsigned)-1; }
@@ -87,11 +144,15 @@ struct APValue::MemberPointerData : MemberPointerBase {
   void resizePath(unsigned Length) {
     if (Length == PathLength)
       return;
-    if (hasPathPtr())
+    if (hasPathPtr()) {
       delete [] PathPtr;
+      noteDeallocation(PathLength * sizeof(PathElem));
+    }
     PathLength = Length;
-    if (hasPathPtr())
+    if (hasPathPtr()) {
       PathPtr = new PathElem[Length];
+      noteAllocation(Length * sizeof(PathElem));
+    }
   }
 
   bool hasPathPtr() const { return PathLength > InlinePathSpace; }
@@ -104,21 +165,37 @@ struct APValue::MemberPointerData : MemberPointerBase {
 
 // FIXME: Reduce the malloc traffic here.
 
+APValue::Vec::~Vec() {
+  delete[] Elts;
+  noteDeallocation(NumElts * sizeof(APValue));
+}
+
 APValue::Arr::Arr(unsigned NumElts, unsigned Size) :
   Elts(new APValue[NumElts + (NumElts != Size ? 1 : 0)]),
-  NumElts(NumElts), ArrSize(Size) {}
-APValue::Arr::~Arr() { delete [] Elts; }
+  NumElts(NumElts), ArrSize(Size) {
+  noteAllocation((NumElts + (NumElts != Size ? 1 : 0)) * sizeof(APValue));
+}
+APValue::Arr::~Arr() {
+  delete [] Elts;
+  noteDeallocation((NumElts + (NumElts != ArrSize ? 1 : 0)) * sizeof(APValue));
+}
 
 APValue::StructData::StructData(unsigned NumBases, unsigned NumFields) :
   Elts(new APValue[NumBases+NumFields]),
-  NumBases(NumBases), NumFields(NumFields) {}
+  NumBases(NumBases), NumFields(NumFields) {
+  noteAllocation((NumBases + NumFields) * sizeof(APValue));
+}
 APValue::StructData::~StructData() {
   delete [] Elts;
+  noteDeallocation((NumBases + NumFields) * sizeof(APValue));
 }
 
-APValue::UnionData::UnionData() : Field(nullptr), Value(new APValue) {}
+APValue::UnionData::UnionData() : Field(nullptr), Value(new APValue) {
+  noteAllocation(sizeof(APValue));
+}
 APValue::UnionData::~UnionData () {
   delete Value;
+  noteDeallocation(sizeof(APValue));
 }
 
 APValue::APValue(const APValue &RHS) : Kind(Uninitialized) {
@@ -195,8 +272,10 @@ void APValue::DestroyDataAndMakeUninit() {
     ((Vec*)(char*)Data.buffer)->~Vec();
   else if (Kind == ComplexInt)
     ((ComplexAPSInt*)(char*)Data.buffer)->~ComplexAPSInt();
-  else if (Kind == ComplexFloat)
-    ((ComplexAPFloat*)(char*)Data.buffer)->~ComplexAPFloat();
+  else if (Kind == ComplexFloat) {
+    delete *(ComplexAPFloat**)(char*)Data.buffer;
+    noteDeallocation(sizeof(ComplexAPFloat));
+  }
   else if (Kind == LValue)
     ((LV*)(char*)Data.buffer)->~LV();
   else if (Kind == Array)
@@ -221,17 +300,12 @@ bool APValue::needsCleanup() const {
   case Union:
   case Array:
   case Vector:
+  case ComplexFloat:
     return true;
   case Int:
     return getInt().needsCleanup();
   case Float:
     return getFloat().needsCleanup();
-  case ComplexFloat:
-    assert(getComplexFloatImag().needsCleanup() ==
-               getComplexFloatReal().needsCleanup() &&
-           "In _Complex float types, real and imaginary values always have the "
-           "same size.");
-    return getComplexFloatReal().needsCleanup();
   case ComplexInt:
     assert(getComplexIntImag().needsCleanup() ==
                getComplexIntReal().needsCleanup() &&
@@ -557,7 +631,7 @@ const APValue::LValueBase APValue::getLValueBase() const {
 
 bool APValue::isLValueOnePastTheEnd() const {
   assert(isLValue() && "Invalid accessor");
-  return ((const LV*)(const void*)Data.buffer)->BaseAndIsOnePastTheEnd.getInt();
+  return ((const LV*)(const void*)Data.buffer)->isOnePastTheEnd();
 }
 
 CharUnits &APValue::getLValueOffset() {
@@ -583,19 +657,18 @@ unsigned APValue::getLValueCallIndex() const {
 
 bool APValue::isNullPointer() const {
   assert(isLValue() && "Invalid usage");
-  return ((const LV*)(const char*)Data.buffer)->IsNullPtr;
+  return ((const LV*)(const char*)Data.buffer)->isNullPtr();
 }
 
 void APValue::setLValue(LValueBase B, const CharUnits &O, NoLValuePath,
                         unsigned CallIndex, bool IsNullPtr) {
   assert(isLValue() && "Invalid accessor");
   LV &LVal = *((LV*)(char*)Data.buffer);
-  LVal.BaseAndIsOnePastTheEnd.setPointer(B);
-  LVal.BaseAndIsOnePastTheEnd.setInt(false);
+  LVal.setBase(B, /*IsOnePastTheEnd=*/false, IsNullPtr);
   LVal.Offset = O;
+  assert(CallIndex < (1U << 31) && "call index out of range");
   LVal.CallIndex = CallIndex;
   LVal.resizePath((unsigned)-1);
-  LVal.IsNullPtr = IsNullPtr;
 }
 
 void APValue::setLValue(LValueBase B, const CharUnits &O,
@@ -603,13 +676,12 @@ void APValue::setLValue(LValueBase B, const CharUnits &O,
                         unsigned CallIndex, bool IsNullPtr) {
   assert(isLValue() && "Invalid accessor");
   LV &LVal = *((LV*)(char*)Data.buffer);
-  LVal.BaseAndIsOnePastTheEnd.setPointer(B);
-  LVal.BaseAndIsOnePastTheEnd.setInt(IsOnePastTheEnd);
+  LVal.setBase(B, IsOnePastTheEnd, IsNullPtr);
   LVal.Offset = O;
+  assert(CallIndex < (1U << 31) && "call index out of range");
   LVal.CallIndex = CallIndex;
   LVal.resizePath(Path.size());
   memcpy(LVal.getPath(), Path.data(), Path.size() * sizeof(LValuePathEntry));
-  LVal.IsNullPtr = IsNullPtr;
 }
 
 const ValueDecl *APValue::getMemberPointerDecl() const {
@@ -633,6 +705,23 @@ ArrayRef<const CXXRecordDecl*> APValue::getMemberPointerPath() const {
   return llvm::makeArrayRef(MPD.getPath(), MPD.PathLength);
 }
 
+void APValue::setVector(const APValue *E, unsigned N) {
+  assert(isVector() && "Invalid accessor");
+  Vec &V = *((Vec*)(char*)Data.buffer);
+  V.Elts = new APValue[N];
+  V.NumElts = N;
+  noteAllocation(N * sizeof(APValue));
+  for (unsigned i = 0; i != N; ++i)
+    V.Elts[i] = E[i];
+}
+
+void APValue::MakeComplexFloat() {
+  assert(isUninit() && "Bad state change");
+  *(ComplexAPFloat**)(char*)Data.buffer = new ComplexAPFloat();
+  noteAllocation(sizeof(ComplexAPFloat));
+  Kind = ComplexFloat;
+}
+
 void APValue::MakeLValue() {
   assert(isUninit() && "Bad state change");
   static_assert(sizeof(LV) <= DataSize, "LV too big");
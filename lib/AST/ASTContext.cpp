@@ -12,7 +12,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/AST/ASTContext.h"
+#include "ASTMemoryAccounting.h"
 #include "CXXABI.h"
+#include "ConstexprCallCache.h"
+#include "ConstexprInterpreter.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
@@ -761,6 +764,11 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
 }
 
 ASTContext::~ASTContext() {
+  if (MemoryAccounting && Decl::getMemoryAccountingContext() == this) {
+    Decl::setMemoryAccountingContext(OuterMemoryAccountingContext);
+    Stmt::setMemoryAccountingContext(OuterMemoryAccountingContext);
+  }
+
   ReleaseParentMapEntries();
 
   // Release the DenseMaps associated with DeclContext objects.
@@ -878,6 +886,22 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  // Declaration context lookup tables.
+  unsigned NumLookupTables = 0, NumLookupNames = 0, NumLookupBuckets = 0;
+  for (StoredDeclsMap *Map = LastSDM.getPointer(); Map;
+       Map = Map->Previous.getPointer()) {
+    ++NumLookupTables;
+    NumLookupNames += Map->size();
+    NumLookupBuckets += Map->getNumBuckets();
+  }
+  llvm::errs() << NumLookupTables << " declaration lookup tables, with "
+               << NumLookupNames << " names in " << NumLookupBuckets
+               << " buckets (" << getDeclContextLookupTableMemory()
+               << " bytes)\n";
+
+  if (ConstexprCalls)
+    ConstexprCalls->PrintStats();
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -9311,6 +9335,54 @@ VTableContextBase *ASTContext::getVTableContext() {
   return VTContext.get();
 }
 
+ConstexprInterpreter &ASTContext::getConstexprInterpreter() {
+  if (!ConstexprInterp)
+    ConstexprInterp.reset(new ConstexprInterpreter(*this));
+  return *ConstexprInterp;
+}
+
+ConstexprCallCache &ASTContext::getConstexprCallCache() {
+  if (!ConstexprCalls)
+    ConstexprCalls.reset(new ConstexprCallCache());
+  return *ConstexprCalls;
+}
+
+void ASTContext::enableMemoryAccounting() {
+  if (MemoryAccounting)
+    return;
+  MemoryAccounting.reset(new ASTMemoryAccounting());
+  OuterMemoryAccountingContext = Decl::getMemoryAccountingContext();
+  Decl::setMemoryAccountingContext(this);
+  Stmt::setMemoryAccountingContext(this);
+}
+
+void ASTContext::noteAllocation(const void *Mem, size_t Size) const {
+  MemoryAccounting->noteAllocation(Mem, Size, Types);
+}
+
+void ASTContext::noteNodeConstructed(const Decl *D) const {
+  MemoryAccounting->noteNode(ASTMemoryAccounting::NC_Decl, D, Types);
+}
+
+void ASTContext::noteNodeConstructed(const Stmt *S) const {
+  MemoryAccounting->noteNode(ASTMemoryAccounting::NC_Stmt, S, Types);
+}
+
+void ASTContext::printMemoryReport(
+    raw_ostream &OS, bool JSON,
+    ArrayRef<std::pair<StringRef, size_t>> Tables) const {
+  assert(MemoryAccounting && "memory accounting is not enabled");
+  SmallVector<std::pair<StringRef, size_t>, 8> AllTables;
+  AllTables.push_back({"ASTContext side tables",
+                       getSideTableAllocatedMemory()});
+  AllTables.push_back({"DeclContext lookup tables",
+                       getDeclContextLookupTableMemory()});
+  AllTables.push_back({"Identifiers", Idents.getAllocator().getTotalMemory()});
+  AllTables.push_back({"Selectors", Selectors.getTotalMemory()});
+  AllTables.append(Tables.begin(), Tables.end());
+  MemoryAccounting->print(OS, JSON, *this, AllTables);
+}
+
 MangleContext *ASTContext::createMangleContext() {
   switch (Target->getCXXABI().getKind()) {
   case TargetCXXABI::GenericAArch64:
@@ -9330,6 +9402,14 @@ MangleContext *ASTContext::createMangleContext() {
 
 CXXABI::~CXXABI() {}
 
+size_t ASTContext::getDeclContextLookupTableMemory() const {
+  size_t Bytes = 0;
+  for (StoredDeclsMap *Map = LastSDM.getPointer(); Map;
+       Map = Map->Previous.getPointer())
+    Bytes += sizeof(StoredDeclsMap) + Map->getMemorySize();
+  return Bytes;
+}
+
 size_t ASTContext::getSideTableAllocatedMemory() const {
   return ASTRecordLayouts.getMemorySize() +
          llvm::capacity_in_bytes(ObjCLayouts) +
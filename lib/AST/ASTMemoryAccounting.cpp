@@ -0,0 +1,236 @@
+//===--- ASTMemoryAccounting.cpp - Attribute AST memory to nodes ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ASTContext memory report.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ASTMemoryAccounting.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclBase.h"
+#include "clang/AST/Stmt.h"
+#include "clang/AST/Type.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+void ASTMemoryAccounting::addNewTypes(ArrayRef<Type *> Types) {
+  // Types are created by allocating them and then adding them to the list,
+  // so a new type owns the most recent allocation.
+  for (; NumTypesSeen < Types.size(); ++NumTypesSeen) {
+    const Type *T = Types[NumTypesSeen];
+    addNode(NC_Type, T, T == LastMem);
+  }
+}
+
+void ASTMemoryAccounting::addNode(NodeCategory Category, const void *Node,
+                                  bool OwnsLast) {
+  NodeRecord R = {Node, Category, 0, 0};
+  if (OwnsLast) {
+    // The allocation was charged to the previous node when it was made.
+    if (Nodes.empty())
+      InitialBytes -= LastSize;
+    else
+      Nodes.back().AuxBytes -= LastSize;
+    R.OwnBytes = LastSize;
+    LastMem = nullptr;
+    LastSize = 0;
+  }
+  Nodes.push_back(R);
+}
+
+void ASTMemoryAccounting::noteAllocation(const void *Mem, size_t Size,
+                                         ArrayRef<Type *> Types) {
+  addNewTypes(Types);
+
+  ++NumAllocations;
+  TotalBytes += Size;
+  if (Nodes.empty())
+    InitialBytes += Size;
+  else
+    Nodes.back().AuxBytes += Size;
+  LastMem = Mem;
+  LastSize = Size;
+}
+
+void ASTMemoryAccounting::noteNode(NodeCategory Category, const void *Node,
+                                   ArrayRef<Type *> Types) {
+  addNewTypes(Types);
+
+  // Nodes are constructed at the start of their allocation, or just after a
+  // small prefix for declarations. Anything else was not allocated by the
+  // context (some statements are built on the stack), or its memory has
+  // already been charged to something else.
+  const char *Start = static_cast<const char *>(LastMem);
+  const char *P = static_cast<const char *>(Node);
+  if (Start && P >= Start && P < Start + LastSize)
+    addNode(Category, Node, /*OwnsLast=*/true);
+}
+
+namespace {
+struct KindTotal {
+  StringRef Category;
+  std::string Name;
+  size_t Count = 0;
+  size_t OwnBytes = 0;
+  size_t AuxBytes = 0;
+
+  size_t getBytes() const { return OwnBytes + AuxBytes; }
+};
+
+struct FileTotal {
+  StringRef Name;
+  size_t Bytes;
+};
+} // end anonymous namespace
+
+static StringRef getCategoryName(ASTMemoryAccounting::NodeCategory Category) {
+  switch (Category) {
+  case ASTMemoryAccounting::NC_Decl: return "Decl";
+  case ASTMemoryAccounting::NC_Stmt: return "Stmt";
+  case ASTMemoryAccounting::NC_Type: return "Type";
+  }
+  llvm_unreachable("unknown node category");
+}
+
+/// Write \p Str as a JSON string literal.
+static void printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << llvm::format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void ASTMemoryAccounting::print(
+    raw_ostream &OS, bool JSON, const ASTContext &Ctx,
+    ArrayRef<std::pair<StringRef, size_t>> Tables) {
+  addNewTypes(Ctx.getTypes());
+
+  const SourceManager &SM = Ctx.getSourceManager();
+  std::vector<KindTotal> Kinds;
+  llvm::DenseMap<std::pair<unsigned, const char *>, unsigned> KindIndex;
+  llvm::StringMap<size_t> FileBytes;
+  FileBytes["<none>"] = InitialBytes;
+
+  // Types have no location of their own, so charge them to the file of the
+  // node that was created before them.
+  StringRef File = "<none>";
+  for (const NodeRecord &R : Nodes) {
+    const char *Name;
+    SourceLocation Loc;
+    switch (R.Category) {
+    case NC_Decl: {
+      const Decl *D = static_cast<const Decl *>(R.Node);
+      Name = D->getDeclKindName();
+      Loc = D->getLocation();
+      break;
+    }
+    case NC_Stmt: {
+      const Stmt *S = static_cast<const Stmt *>(R.Node);
+      Name = S->getStmtClassName();
+      Loc = S->getLocStart();
+      break;
+    }
+    case NC_Type:
+      Name = static_cast<const Type *>(R.Node)->getTypeClassName();
+      break;
+    }
+
+    auto Key = std::make_pair(unsigned(R.Category), Name);
+    auto It = KindIndex.insert({Key, Kinds.size()});
+    if (It.second) {
+      Kinds.emplace_back();
+      Kinds.back().Category = getCategoryName(R.Category);
+      Kinds.back().Name = Name;
+      if (R.Category != NC_Stmt)
+        Kinds.back().Name += Kinds.back().Category;
+    }
+    KindTotal &K = Kinds[It.first->second];
+    ++K.Count;
+    K.OwnBytes += R.OwnBytes;
+    K.AuxBytes += R.AuxBytes;
+
+    if (R.Category != NC_Type) {
+      File = "<none>";
+      if (Loc.isValid()) {
+        StringRef Filename = SM.getFilename(SM.getExpansionLoc(Loc));
+        File = Filename.empty() ? "<scratch space>" : Filename;
+      }
+    }
+    FileBytes[File] += R.OwnBytes + R.AuxBytes;
+  }
+
+  std::sort(Kinds.begin(), Kinds.end(),
+            [](const KindTotal &A, const KindTotal &B) {
+              return A.getBytes() > B.getBytes();
+            });
+  std::vector<FileTotal> Files;
+  for (const auto &F : FileBytes)
+    if (F.second)
+      Files.push_back({F.first(), F.second});
+  std::sort(Files.begin(), Files.end(),
+            [](const FileTotal &A, const FileTotal &B) {
+              return A.Bytes > B.Bytes;
+            });
+
+  size_t SlabBytes = Ctx.getASTAllocatedMemory();
+
+  if (JSON) {
+    OS << "{\n  \"allocated\": " << TotalBytes
+       << ",\n  \"allocations\": " << NumAllocations
+       << ",\n  \"slabs\": " << SlabBytes << ",\n  \"kinds\": [";
+    for (unsigned I = 0, N = Kinds.size(); I != N; ++I) {
+      const KindTotal &K = Kinds[I];
+      OS << (I ? ",\n" : "\n") << "    {\"kind\": ";
+      printJSONString(OS, K.Name);
+      OS << ", \"category\": \"" << K.Category << "\", \"count\": " << K.Count
+         << ", \"bytes\": " << K.getBytes() << ", \"own\": " << K.OwnBytes
+         << ", \"aux\": " << K.AuxBytes << "}";
+    }
+    OS << "\n  ],\n  \"files\": [";
+    for (unsigned I = 0, N = Files.size(); I != N; ++I) {
+      OS << (I ? ",\n" : "\n") << "    {\"file\": ";
+      printJSONString(OS, Files[I].Name);
+      OS << ", \"bytes\": " << Files[I].Bytes << "}";
+    }
+    OS << "\n  ],\n  \"tables\": [";
+    for (unsigned I = 0, N = Tables.size(); I != N; ++I) {
+      OS << (I ? ",\n" : "\n") << "    {\"table\": ";
+      printJSONString(OS, Tables[I].first);
+      OS << ", \"bytes\": " << Tables[I].second << "}";
+    }
+    OS << "\n  ]\n}\n";
+    return;
+  }
+
+  OS << "\n*** AST Memory Report:\n";
+  OS << "  " << TotalBytes << " bytes in " << NumAllocations
+     << " allocations (" << SlabBytes << " bytes of slabs)\n";
+  OS << "\n  By node kind (node bytes + bytes allocated with it):\n";
+  for (const KindTotal &K : Kinds)
+    OS << llvm::format("  %12zu  %8zu ", K.getBytes(), K.Count) << K.Name
+       << " (" << K.OwnBytes << " + " << K.AuxBytes << ")\n";
+  OS << "\n  By file:\n";
+  for (const FileTotal &F : Files)
+    OS << llvm::format("  %12zu  ", F.Bytes) << F.Name << "\n";
+  OS << "\n  Other tables:\n";
+  for (const auto &T : Tables)
+    OS << llvm::format("  %12zu  ", T.second) << T.first << "\n";
+}
@@ -0,0 +1,85 @@
+//===--- ASTMemoryAccounting.h - Attribute AST memory to nodes --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides the bookkeeping behind ASTContext::enableMemoryAccounting(),
+// which attributes every allocation made through ASTContext::Allocate() to the
+// kind of AST node that caused it and to the file that node came from.
+//
+// Each declaration, statement and type is charged for its own allocation.
+// Anything else allocated from the context (template argument lists,
+// parameter arrays, attributes, and so on) is charged to the node created
+// most recently before it, which is almost always the node that owns it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_ASTMEMORYACCOUNTING_H
+#define LLVM_CLANG_LIB_AST_ASTMEMORYACCOUNTING_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <utility>
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class Type;
+
+class ASTMemoryAccounting {
+public:
+  enum NodeCategory { NC_Decl, NC_Stmt, NC_Type };
+
+  /// \brief Note an allocation of \p Size bytes at \p Mem.
+  ///
+  /// \param Types The context's list of types, so that types created since
+  /// the last allocation can be matched up with their memory.
+  void noteAllocation(const void *Mem, size_t Size, ArrayRef<Type *> Types);
+
+  /// \brief Note that the node \p Node is being constructed.
+  void noteNode(NodeCategory Category, const void *Node,
+                ArrayRef<Type *> Types);
+
+  /// \brief Print the report. \p Tables lists the sizes of other tables
+  /// that are not allocated from the context.
+  void print(raw_ostream &OS, bool JSON, const ASTContext &Ctx,
+             ArrayRef<std::pair<StringRef, size_t>> Tables);
+
+private:
+  struct NodeRecord {
+    const void *Node;
+    NodeCategory Category;
+    /// The size of the node itself, including any trailing objects.
+    size_t OwnBytes;
+    /// The size of the other allocations made before the next node.
+    size_t AuxBytes;
+  };
+
+  void addNode(NodeCategory Category, const void *Node, bool OwnsLast);
+  void addNewTypes(ArrayRef<Type *> Types);
+
+  std::vector<NodeRecord> Nodes;
+
+  /// The most recent allocation, which has not yet been claimed by a node.
+  const void *LastMem = nullptr;
+  size_t LastSize = 0;
+
+  /// The number of types in the context's list that have been recorded.
+  size_t NumTypesSeen = 0;
+
+  size_t NumAllocations = 0;
+  size_t TotalBytes = 0;
+
+  /// Bytes allocated before the first node.
+  size_t InitialBytes = 0;
+};
+
+} // end namespace clang
+
+#endif
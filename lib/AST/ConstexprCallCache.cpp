@@ -0,0 +1,153 @@
+//===--- ConstexprCallCache.cpp - Memoized constexpr calls ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cache of constexpr function call results.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprCallCache.h"
+#include "clang/AST/Decl.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+/// Add a plain value to \p ID. Returns false if \p V contains a pointer,
+/// reference, member pointer or label difference, none of which can be
+/// compared without knowing what they point into.
+static bool profileValue(llvm::FoldingSetNodeID &ID, const APValue &V) {
+  ID.AddInteger(V.getKind());
+  switch (V.getKind()) {
+  case APValue::Uninitialized:
+    return true;
+
+  case APValue::Int:
+    V.getInt().Profile(ID);
+    return true;
+
+  case APValue::Float:
+    ID.AddPointer(&V.getFloat().getSemantics());
+    V.getFloat().Profile(ID);
+    return true;
+
+  case APValue::ComplexInt:
+    V.getComplexIntReal().Profile(ID);
+    V.getComplexIntImag().Profile(ID);
+    return true;
+
+  case APValue::ComplexFloat:
+    ID.AddPointer(&V.getComplexFloatReal().getSemantics());
+    V.getComplexFloatReal().Profile(ID);
+    V.getComplexFloatImag().Profile(ID);
+    return true;
+
+  case APValue::Vector:
+    ID.AddInteger(V.getVectorLength());
+    for (unsigned I = 0, N = V.getVectorLength(); I != N; ++I)
+      if (!profileValue(ID, V.getVectorElt(I)))
+        return false;
+    return true;
+
+  case APValue::Array:
+    ID.AddInteger(V.getArraySize());
+    ID.AddInteger(V.getArrayInitializedElts());
+    for (unsigned I = 0, N = V.getArrayInitializedElts(); I != N; ++I)
+      if (!profileValue(ID, V.getArrayInitializedElt(I)))
+        return false;
+    ID.AddBoolean(V.hasArrayFiller());
+    return !V.hasArrayFiller() || profileValue(ID, V.getArrayFiller());
+
+  case APValue::Struct:
+    ID.AddInteger(V.getStructNumBases());
+    for (unsigned I = 0, N = V.getStructNumBases(); I != N; ++I)
+      if (!profileValue(ID, V.getStructBase(I)))
+        return false;
+    ID.AddInteger(V.getStructNumFields());
+    for (unsigned I = 0, N = V.getStructNumFields(); I != N; ++I)
+      if (!profileValue(ID, V.getStructField(I)))
+        return false;
+    return true;
+
+  case APValue::Union:
+    ID.AddPointer(V.getUnionField());
+    return !V.getUnionField() || profileValue(ID, V.getUnionValue());
+
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
+void ConstexprCallCache::Entry::Profile(llvm::FoldingSetNodeID &ID) const {
+  for (unsigned I = 0, N = Key.getSize(); I != N; ++I)
+    ID.AddInteger(Key.getData()[I]);
+}
+
+bool ConstexprCallCache::profileCall(llvm::FoldingSetNodeID &ID,
+                                     const FunctionDecl *FD, unsigned EvalMode,
+                                     ArrayRef<APValue> Args) {
+  ID.AddPointer(FD->getCanonicalDecl());
+  ID.AddInteger(EvalMode);
+  ID.AddInteger(Args.size());
+  for (const APValue &Arg : Args)
+    if (!profileValue(ID, Arg))
+      return false;
+  return true;
+}
+
+bool ConstexprCallCache::isCacheableValue(const APValue &V) {
+  llvm::FoldingSetNodeID Scratch;
+  return profileValue(Scratch, V);
+}
+
+const ConstexprCallCache::Entry *
+ConstexprCallCache::lookup(const llvm::FoldingSetNodeID &ID,
+                           unsigned StepsLeft, unsigned DepthLeft) {
+  ++NumLookups;
+  void *InsertPos;
+  Entry *E = Entries.FindNodeOrInsertPos(ID, InsertPos);
+  if (!E || E->Steps > StepsLeft || E->Depth > DepthLeft)
+    return nullptr;
+  ++NumHits;
+  NumStepsSaved += E->Steps;
+  return E;
+}
+
+void ConstexprCallCache::insert(const llvm::FoldingSetNodeID &ID,
+                                const APValue &Result, unsigned Steps,
+                                unsigned Depth) {
+  // Evaluation is deterministic, so if the call has already been cached (for
+  // instance, because an earlier lookup exceeded the limits) there is nothing
+  // new to record.
+  void *InsertPos;
+  if (Entries.FindNodeOrInsertPos(ID, InsertPos))
+    return;
+
+  Entry *E = new (EntryAllocator.Allocate()) Entry;
+  E->Key = ID.Intern(KeyAllocator);
+  E->Result = Result;
+  E->Steps = Steps;
+  E->Depth = Depth;
+  Entries.InsertNode(E, InsertPos);
+  ++NumEntries;
+}
+
+void ConstexprCallCache::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Call Cache Stats:\n";
+  llvm::errs() << "  " << NumEntries << " cached call results\n";
+  llvm::errs() << "  " << NumHits << "/" << NumLookups
+               << " lookups hit the cache\n";
+  llvm::errs() << "  " << NumUncacheable << " calls could not be cached\n";
+  llvm::errs() << "  " << NumStepsSaved << " evaluation steps saved\n";
+  llvm::errs() << "  "
+               << KeyAllocator.getTotalMemory() +
+                      NumEntries * sizeof(Entry)
+               << " bytes used\n";
+}
@@ -0,0 +1,93 @@
+//===--- ConstexprCallCache.h - Memoized constexpr calls --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides a cache of the results of constexpr function calls, keyed on
+// the callee, the evaluation mode and the argument values. Only calls whose
+// arguments and result are plain values (no pointers or references) are
+// cached, and the constant evaluator only inserts results for calls that
+// could not have observed anything other than their arguments.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
+
+namespace clang {
+
+class FunctionDecl;
+
+/// Memoizes the results of constexpr function calls within an ASTContext.
+class ConstexprCallCache {
+public:
+  /// A cached call result.
+  struct Entry : llvm::FoldingSetNode {
+    llvm::FoldingSetNodeIDRef Key;
+
+    /// The value returned by the call.
+    APValue Result;
+
+    /// The number of evaluation steps the call took.
+    unsigned Steps;
+
+    /// The deepest level of nested calls the call made, counting the call
+    /// itself as 1.
+    unsigned Depth;
+
+    void Profile(llvm::FoldingSetNodeID &ID) const;
+  };
+
+  /// \brief Compute the cache key for a call to \p FD with arguments \p Args,
+  /// evaluated in the given mode.
+  ///
+  /// \returns false if the call cannot be cached because one of its arguments
+  /// refers to an object.
+  static bool profileCall(llvm::FoldingSetNodeID &ID, const FunctionDecl *FD,
+                          unsigned EvalMode, ArrayRef<APValue> Args);
+
+  /// \brief Determine whether \p V is a plain value that can be stored in the
+  /// cache.
+  static bool isCacheableValue(const APValue &V);
+
+  /// \brief Look up a previously-cached result for the call with key \p ID.
+  ///
+  /// Only returns an entry whose evaluation fits in the given limits, so that
+  /// a cache hit never succeeds where re-evaluating the call would have failed.
+  const Entry *lookup(const llvm::FoldingSetNodeID &ID, unsigned StepsLeft,
+                      unsigned DepthLeft);
+
+  /// \brief Record the result of a successful call.
+  void insert(const llvm::FoldingSetNodeID &ID, const APValue &Result,
+              unsigned Steps, unsigned Depth);
+
+  /// \brief Note that a call was evaluated but could not be cached.
+  void noteUncacheable() { ++NumUncacheable; }
+
+  void PrintStats() const;
+
+private:
+  llvm::FoldingSet<Entry> Entries;
+  llvm::SpecificBumpPtrAllocator<Entry> EntryAllocator;
+  llvm::BumpPtrAllocator KeyAllocator;
+
+  unsigned NumEntries = 0;
+  unsigned NumLookups = 0;
+  unsigned NumHits = 0;
+  unsigned NumUncacheable = 0;
+  uint64_t NumStepsSaved = 0;
+};
+
+} // end namespace clang
+
+#endif
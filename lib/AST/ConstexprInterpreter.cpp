@@ -0,0 +1,1129 @@
+//===--- ConstexprInterpreter.cpp - Bytecode constexpr evaluation ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a bytecode compiler and stack-based interpreter for
+// constexpr functions whose parameters, locals and return value are all of
+// integral or enumeration type, no wider than 64 bits.
+//
+// The interpreter is only ever an accelerator for the AST evaluator in
+// ExprConstant.cpp: it must never accept a call that the AST evaluator would
+// reject, and it must produce exactly the same value for every call that it
+// does accept. To that end:
+//
+//  * Anything that the AST evaluator would diagnose, even with a note that
+//    does not stop evaluation (overflow, out-of-range shifts, division by
+//    zero, running out of steps or call depth), makes the interpreter give up
+//    and leaves the call to be re-evaluated by the AST evaluator, which then
+//    produces the usual diagnostics.
+//
+//  * One 'Step' instruction is executed each time the AST evaluator would call
+//    EvalInfo::nextStep, i.e. once for every statement executed, so the two
+//    evaluators agree on when -fconstexpr-steps is exceeded.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprInterpreter.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <vector>
+
+using namespace clang;
+
+namespace {
+
+/// The representation of an integral type in the bytecode. Values are always
+/// stored in an int64_t, truncated to Width bits and then sign- or
+/// zero-extended according to Signed.
+struct IntType {
+  unsigned Width = 0;
+  bool Signed = false;
+  bool IsBool = false;
+
+  bool operator==(const IntType &RHS) const {
+    return Width == RHS.Width && Signed == RHS.Signed && IsBool == RHS.IsBool;
+  }
+  bool operator!=(const IntType &RHS) const { return !(*this == RHS); }
+};
+
+enum class Opcode : uint8_t {
+  Const,    ///< Push Operand.
+  GetLocal, ///< Push local slot Operand.
+  SetLocal, ///< Pop into local slot Operand.
+  Dup,      ///< Duplicate the top of the stack.
+  Swap,     ///< Swap the two values on the top of the stack.
+  Pop,      ///< Discard the top of the stack.
+  Cast,     ///< Convert the top of the stack to Ty.
+  Neg,
+  Not,
+  LNot,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Rem,
+  Shl,
+  Shr,
+  And,
+  Or,
+  Xor,
+  LT,
+  GT,
+  LE,
+  GE,
+  EQ,
+  NE,
+  Jmp,  ///< Jump to instruction Operand.
+  Jz,   ///< Pop, and jump to instruction Operand if zero.
+  Jnz,  ///< Pop, and jump to instruction Operand if non-zero.
+  Call, ///< Call Callees[Operand] with arguments from the stack.
+  Ret,  ///< Pop the return value and return.
+  Step, ///< Consume one evaluation step.
+  Trap  ///< Fail evaluation.
+};
+
+/// A single bytecode instruction. Arithmetic and comparison instructions
+/// operate on values of type Ty; shifts additionally record the signedness of
+/// their right-hand operand.
+struct Instr {
+  Opcode Op;
+  bool RHSSigned;
+  IntType Ty;
+  int64_t Operand;
+};
+
+} // end anonymous namespace
+
+/// The compiled form of a constexpr function.
+class ConstexprInterpreter::Function {
+public:
+  unsigned NumParams = 0;
+  unsigned NumLocals = 0;
+  SmallVector<IntType, 4> ParamTypes;
+  IntType ReturnType;
+  std::vector<Instr> Code;
+  std::vector<const FunctionDecl *> Callees;
+};
+
+/// Truncate \p V to the width of \p T and re-extend it.
+static int64_t normalize(IntType T, uint64_t V) {
+  if (T.IsBool)
+    return V != 0;
+  if (T.Width == 64)
+    return V;
+  uint64_t Mask = (uint64_t(1) << T.Width) - 1;
+  V &= Mask;
+  if (T.Signed && (V >> (T.Width - 1)))
+    V |= ~Mask;
+  return V;
+}
+
+/// Convert \p V to type \p T, extending or truncating it as
+/// HandleIntToIntCast would.
+static int64_t fromAPSInt(const llvm::APSInt &V, IntType T) {
+  return normalize(T, V.extOrTrunc(T.Width).getZExtValue());
+}
+
+static int64_t minSignedValue(IntType T) {
+  return T.Width == 64 ? INT64_MIN : -(int64_t(1) << (T.Width - 1));
+}
+
+namespace {
+
+/// Lowers the body of a constexpr function to bytecode.
+class Compiler {
+  typedef ConstexprInterpreter::Function Function;
+
+  ASTContext &Ctx;
+  Function &F;
+
+  struct Local {
+    unsigned Slot;
+    IntType Ty;
+    bool IsConst;
+  };
+  llvm::DenseMap<const VarDecl *, Local> Locals;
+
+  struct LoopTargets {
+    SmallVector<size_t, 4> Breaks;
+    SmallVector<size_t, 4> Continues;
+  };
+  SmallVector<LoopTargets, 4> Loops;
+
+public:
+  Compiler(ASTContext &Ctx, Function &F) : Ctx(Ctx), F(F) {}
+
+  bool compileFunction(const FunctionDecl *FD, const Stmt *Body);
+
+private:
+  size_t emit(Opcode Op, IntType Ty = IntType(), int64_t Operand = 0,
+              bool RHSSigned = false) {
+    F.Code.push_back({Op, RHSSigned, Ty, Operand});
+    return F.Code.size() - 1;
+  }
+  void emitCast(IntType From, IntType To) {
+    if (From != To)
+      emit(Opcode::Cast, To);
+  }
+  size_t here() const { return F.Code.size(); }
+  void patch(size_t Jump, size_t Target) { F.Code[Jump].Operand = Target; }
+  void patch(ArrayRef<size_t> Jumps, size_t Target) {
+    for (size_t J : Jumps)
+      patch(J, Target);
+  }
+
+  bool getIntType(QualType T, IntType &Ty);
+  bool addLocal(const VarDecl *VD, Local &L);
+  const Local *getLocal(const Expr *E);
+
+  bool compileStmt(const Stmt *S);
+  bool compileVarDecl(const VarDecl *VD);
+  bool compileCond(const VarDecl *CondVar, const Expr *Cond);
+  bool compileBreakOrContinue(bool IsBreak);
+
+  bool compileRValue(const Expr *E, IntType &Ty);
+  bool compileLValue(const Expr *E, const Local *&L);
+  bool compileDiscarded(const Expr *E);
+  bool compileCast(const CastExpr *E, IntType Ty);
+  bool compileUnaryOperator(const UnaryOperator *E, IntType Ty);
+  bool compileBinaryOperator(const BinaryOperator *E, IntType Ty);
+  bool compileIncDec(const UnaryOperator *E, const Local *&L);
+  bool compileAssignment(const BinaryOperator *E, const Local *&L);
+  bool compileCall(const CallExpr *E, IntType Ty);
+  bool compileVarRead(const DeclRefExpr *E, IntType Ty);
+  void compileConstant(const llvm::APSInt &V, IntType Ty) {
+    emit(Opcode::Const, Ty, fromAPSInt(V, Ty));
+  }
+};
+
+} // end anonymous namespace
+
+bool Compiler::getIntType(QualType T, IntType &Ty) {
+  if (T.isNull() || T.isVolatileQualified() || T->isDependentType() ||
+      !T->isIntegralOrEnumerationType())
+    return false;
+  if (const EnumType *ET = T->getAs<EnumType>())
+    if (!ET->getDecl()->isComplete())
+      return false;
+  unsigned Width = Ctx.getIntWidth(T);
+  if (Width == 0 || Width > 64)
+    return false;
+  Ty.Width = Width;
+  Ty.Signed = T->isSignedIntegerOrEnumerationType();
+  Ty.IsBool = T->isBooleanType();
+  return true;
+}
+
+bool Compiler::addLocal(const VarDecl *VD, Local &L) {
+  if (!VD->hasLocalStorage() || !getIntType(VD->getType(), L.Ty))
+    return false;
+  L.Slot = F.NumLocals++;
+  L.IsConst = VD->getType().isConstQualified();
+  Locals[VD] = L;
+  return true;
+}
+
+const Compiler::Local *Compiler::getLocal(const Expr *E) {
+  const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens());
+  if (!DRE || DRE->refersToEnclosingVariableOrCapture())
+    return nullptr;
+  const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  if (!VD)
+    return nullptr;
+  auto It = Locals.find(VD);
+  return It == Locals.end() ? nullptr : &It->second;
+}
+
+bool Compiler::compileFunction(const FunctionDecl *FD, const Stmt *Body) {
+  if (FD->isVariadic() || !getIntType(FD->getReturnType(), F.ReturnType))
+    return false;
+
+  for (const ParmVarDecl *PVD : FD->parameters()) {
+    Local L;
+    if (!addLocal(PVD, L))
+      return false;
+    F.ParamTypes.push_back(L.Ty);
+  }
+  F.NumParams = FD->getNumParams();
+
+  if (!compileStmt(Body))
+    return false;
+
+  // Flowing off the end of a function with a non-void return type.
+  emit(Opcode::Trap);
+  return true;
+}
+
+bool Compiler::compileStmt(const Stmt *S) {
+  emit(Opcode::Step);
+
+  switch (S->getStmtClass()) {
+  default:
+    if (const Expr *E = dyn_cast<Expr>(S))
+      return compileDiscarded(E);
+    return false;
+
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const Stmt *Child : cast<CompoundStmt>(S)->body())
+      if (!compileStmt(Child))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      // Declarations other than variables have no effect on evaluation.
+      if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+        if (!compileVarDecl(VD))
+          return false;
+    }
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *RetExpr = cast<ReturnStmt>(S)->getRetValue();
+    IntType Ty;
+    if (!RetExpr || !compileRValue(RetExpr, Ty))
+      return false;
+    emitCast(Ty, F.ReturnType);
+    emit(Opcode::Ret);
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+  case Stmt::ContinueStmtClass:
+    return compileBreakOrContinue(isa<BreakStmt>(S));
+
+  case Stmt::IfStmtClass: {
+    const IfStmt *IS = cast<IfStmt>(S);
+    if (IS->getInit() && !compileStmt(IS->getInit()))
+      return false;
+    if (!compileCond(IS->getConditionVariable(), IS->getCond()))
+      return false;
+    size_t ToElse = emit(Opcode::Jz);
+    if (IS->getThen() && !compileStmt(IS->getThen()))
+      return false;
+    if (!IS->getElse()) {
+      patch(ToElse, here());
+      return true;
+    }
+    size_t ToEnd = emit(Opcode::Jmp);
+    patch(ToElse, here());
+    if (!compileStmt(IS->getElse()))
+      return false;
+    patch(ToEnd, here());
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const WhileStmt *WS = cast<WhileStmt>(S);
+    size_t Cond = here();
+    if (!compileCond(WS->getConditionVariable(), WS->getCond()))
+      return false;
+    size_t ToEnd = emit(Opcode::Jz);
+    Loops.emplace_back();
+    if (!compileStmt(WS->getBody()))
+      return false;
+    emit(Opcode::Jmp, IntType(), Cond);
+    LoopTargets Targets = Loops.pop_back_val();
+    patch(Targets.Continues, Cond);
+    patch(ToEnd, here());
+    patch(Targets.Breaks, here());
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const DoStmt *DS = cast<DoStmt>(S);
+    size_t Body = here();
+    Loops.emplace_back();
+    if (!compileStmt(DS->getBody()))
+      return false;
+    LoopTargets Targets = Loops.pop_back_val();
+    patch(Targets.Continues, here());
+    if (!compileCond(nullptr, DS->getCond()))
+      return false;
+    emit(Opcode::Jnz, IntType(), Body);
+    patch(Targets.Breaks, here());
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const ForStmt *FS = cast<ForStmt>(S);
+    if (FS->getInit() && !compileStmt(FS->getInit()))
+      return false;
+    size_t Cond = here();
+    size_t ToEnd = 0;
+    if (FS->getCond()) {
+      if (!compileCond(FS->getConditionVariable(), FS->getCond()))
+        return false;
+      ToEnd = emit(Opcode::Jz);
+    }
+    Loops.emplace_back();
+    if (!compileStmt(FS->getBody()))
+      return false;
+    LoopTargets Targets = Loops.pop_back_val();
+    patch(Targets.Continues, here());
+    if (FS->getInc() && !compileDiscarded(FS->getInc()))
+      return false;
+    emit(Opcode::Jmp, IntType(), Cond);
+    if (FS->getCond())
+      patch(ToEnd, here());
+    patch(Targets.Breaks, here());
+    return true;
+  }
+  }
+}
+
+bool Compiler::compileVarDecl(const VarDecl *VD) {
+  // Compile the initializer before adding the variable, so that a use of the
+  // variable in its own initializer is rejected.
+  const Expr *Init = VD->getInit();
+  IntType InitTy;
+  Local L;
+  if (!Init || !compileRValue(Init, InitTy) || !addLocal(VD, L))
+    return false;
+  emitCast(InitTy, L.Ty);
+  emit(Opcode::SetLocal, IntType(), L.Slot);
+  return true;
+}
+
+bool Compiler::compileCond(const VarDecl *CondVar, const Expr *Cond) {
+  if (CondVar && !compileVarDecl(CondVar))
+    return false;
+  IntType Ty;
+  return compileRValue(Cond, Ty);
+}
+
+bool Compiler::compileBreakOrContinue(bool IsBreak) {
+  if (Loops.empty())
+    return false;
+  size_t Jump = emit(Opcode::Jmp);
+  (IsBreak ? Loops.back().Breaks : Loops.back().Continues).push_back(Jump);
+  return true;
+}
+
+bool Compiler::compileRValue(const Expr *E, IntType &Ty) {
+  if (E->isValueDependent() || !E->isRValue() ||
+      !getIntType(E->getType(), Ty))
+    return false;
+  E = E->IgnoreParens();
+
+  if (const IntegerLiteral *IL = dyn_cast<IntegerLiteral>(E)) {
+    compileConstant(llvm::APSInt(IL->getValue(), !Ty.Signed), Ty);
+    return true;
+  }
+  if (const CharacterLiteral *CL = dyn_cast<CharacterLiteral>(E)) {
+    emit(Opcode::Const, Ty, normalize(Ty, CL->getValue()));
+    return true;
+  }
+  if (const CXXBoolLiteralExpr *BL = dyn_cast<CXXBoolLiteralExpr>(E)) {
+    emit(Opcode::Const, Ty, normalize(Ty, BL->getValue()));
+    return true;
+  }
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(DRE->getDecl());
+    if (!ECD)
+      return false;
+    llvm::APSInt Val = ECD->getInitVal();
+    Val.setIsSigned(Ty.Signed);
+    compileConstant(Val, Ty);
+    return true;
+  }
+  if (isa<UnaryExprOrTypeTraitExpr>(E)) {
+    llvm::APSInt Val;
+    if (!E->isIntegerConstantExpr(Val, Ctx))
+      return false;
+    compileConstant(Val, Ty);
+    return true;
+  }
+  if (const SubstNonTypeTemplateParmExpr *SNTTP =
+          dyn_cast<SubstNonTypeTemplateParmExpr>(E))
+    return compileRValue(SNTTP->getReplacement(), Ty);
+  if (const CXXDefaultArgExpr *DAE = dyn_cast<CXXDefaultArgExpr>(E))
+    return compileRValue(DAE->getExpr(), Ty);
+  if (const ExprWithCleanups *EWC = dyn_cast<ExprWithCleanups>(E))
+    return compileRValue(EWC->getSubExpr(), Ty);
+  if (isa<ImplicitValueInitExpr>(E)) {
+    emit(Opcode::Const, Ty, 0);
+    return true;
+  }
+  if (const InitListExpr *ILE = dyn_cast<InitListExpr>(E)) {
+    if (ILE->getNumInits() == 0) {
+      emit(Opcode::Const, Ty, 0);
+      return true;
+    }
+    IntType InitTy;
+    return ILE->getNumInits() == 1 &&
+           compileRValue(ILE->getInit(0), InitTy) && InitTy == Ty;
+  }
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    return compileCast(CE, Ty);
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    return compileUnaryOperator(UO, Ty);
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    return compileBinaryOperator(BO, Ty);
+  if (const ConditionalOperator *CO = dyn_cast<ConditionalOperator>(E)) {
+    IntType CondTy, TrueTy, FalseTy;
+    if (!compileRValue(CO->getCond(), CondTy))
+      return false;
+    size_t ToFalse = emit(Opcode::Jz);
+    if (!compileRValue(CO->getTrueExpr(), TrueTy))
+      return false;
+    emitCast(TrueTy, Ty);
+    size_t ToEnd = emit(Opcode::Jmp);
+    patch(ToFalse, here());
+    if (!compileRValue(CO->getFalseExpr(), FalseTy))
+      return false;
+    emitCast(FalseTy, Ty);
+    patch(ToEnd, here());
+    return true;
+  }
+  // Only plain calls; member, operator and literal-operator calls have their
+  // own subclasses.
+  if (E->getStmtClass() == Stmt::CallExprClass)
+    return compileCall(cast<CallExpr>(E), Ty);
+
+  return false;
+}
+
+bool Compiler::compileVarRead(const DeclRefExpr *E, IntType Ty) {
+  if (const Local *L = getLocal(E)) {
+    emit(Opcode::GetLocal, IntType(), L->Slot);
+    emitCast(L->Ty, Ty);
+    return true;
+  }
+
+  // A global constant. These checks mirror the ones the AST evaluator makes
+  // before reading the value of a variable outside the current evaluation.
+  const VarDecl *VD = dyn_cast<VarDecl>(E->getDecl());
+  if (!VD || VD->hasLocalStorage() || E->refersToEnclosingVariableOrCapture() ||
+      isa<VarTemplateSpecializationDecl>(VD))
+    return false;
+  QualType T = VD->getType();
+  if (!VD->isConstexpr() && !T.isConstQualified())
+    return false;
+  const VarDecl *InitDecl = nullptr;
+  const Expr *Init = VD->getAnyInitializer(InitDecl);
+  if (!Init || Init->isValueDependent() || InitDecl->isWeak())
+    return false;
+  const APValue *Value = InitDecl->evaluateValue();
+  if (!Value || !Value->isInt() || !InitDecl->checkInitIsICE())
+    return false;
+  compileConstant(Value->getInt(), Ty);
+  return true;
+}
+
+bool Compiler::compileCast(const CastExpr *E, IntType Ty) {
+  const Expr *SubExpr = E->getSubExpr();
+  IntType SubTy;
+
+  switch (E->getCastKind()) {
+  default:
+    return false;
+
+  case CK_LValueToRValue: {
+    if (SubExpr->getType().isVolatileQualified())
+      return false;
+    if (const DeclRefExpr *DRE =
+            dyn_cast<DeclRefExpr>(SubExpr->IgnoreParens()))
+      return compileVarRead(DRE, Ty);
+    // An assignment or pre-increment used as a value.
+    const Local *L;
+    if (!compileLValue(SubExpr, L))
+      return false;
+    emit(Opcode::GetLocal, IntType(), L->Slot);
+    emitCast(L->Ty, Ty);
+    return true;
+  }
+
+  case CK_NoOp:
+  case CK_IntegralCast:
+  case CK_IntegralToBoolean:
+    // Conversions to bool must test against zero rather than truncate, which
+    // only CK_IntegralToBoolean does.
+    if (Ty.IsBool && E->getCastKind() == CK_IntegralCast)
+      return false;
+    if (!compileRValue(SubExpr, SubTy))
+      return false;
+    emitCast(SubTy, Ty);
+    return true;
+  }
+}
+
+bool Compiler::compileUnaryOperator(const UnaryOperator *E, IntType Ty) {
+  IntType SubTy;
+  switch (E->getOpcode()) {
+  default:
+    return false;
+
+  case UO_Plus:
+  case UO_Extension:
+    if (!compileRValue(E->getSubExpr(), SubTy))
+      return false;
+    emitCast(SubTy, Ty);
+    return true;
+
+  case UO_Minus:
+  case UO_Not:
+    if (!compileRValue(E->getSubExpr(), SubTy) || SubTy != Ty)
+      return false;
+    emit(E->getOpcode() == UO_Minus ? Opcode::Neg : Opcode::Not, Ty);
+    return true;
+
+  case UO_LNot:
+    if (!compileRValue(E->getSubExpr(), SubTy))
+      return false;
+    emit(Opcode::LNot, Ty);
+    return true;
+
+  case UO_PreInc:
+  case UO_PreDec: {
+    // Only reachable in C, where these are rvalues.
+    const Local *L;
+    if (!compileIncDec(E, L))
+      return false;
+    emit(Opcode::GetLocal, IntType(), L->Slot);
+    emitCast(L->Ty, Ty);
+    return true;
+  }
+
+  case UO_PostInc:
+  case UO_PostDec: {
+    const Local *L = getLocal(E->getSubExpr());
+    if (!L || L->IsConst || L->Ty.IsBool || L->Ty != Ty)
+      return false;
+    emit(Opcode::GetLocal, IntType(), L->Slot);
+    emit(Opcode::Dup);
+    emit(Opcode::Const, Ty, 1);
+    emit(E->getOpcode() == UO_PostInc ? Opcode::Add : Opcode::Sub, Ty);
+    emit(Opcode::SetLocal, IntType(), L->Slot);
+    return true;
+  }
+  }
+}
+
+bool Compiler::compileBinaryOperator(const BinaryOperator *E, IntType Ty) {
+  BinaryOperatorKind Op = E->getOpcode();
+
+  if (E->isAssignmentOp()) {
+    // Only reachable in C, where assignments are rvalues.
+    const Local *L;
+    if (!compileAssignment(E, L))
+      return false;
+    emit(Opcode::GetLocal, IntType(), L->Slot);
+    emitCast(L->Ty, Ty);
+    return true;
+  }
+
+  IntType LHSTy, RHSTy;
+  if (Op == BO_Comma)
+    return compileDiscarded(E->getLHS()) && compileRValue(E->getRHS(), RHSTy) &&
+           RHSTy == Ty;
+
+  if (Op == BO_LAnd || Op == BO_LOr) {
+    Opcode Skip = Op == BO_LAnd ? Opcode::Jz : Opcode::Jnz;
+    if (!compileRValue(E->getLHS(), LHSTy))
+      return false;
+    size_t ShortCircuit = emit(Skip);
+    if (!compileRValue(E->getRHS(), RHSTy))
+      return false;
+    emit(Opcode::LNot, Ty);
+    emit(Opcode::LNot, Ty);
+    size_t ToEnd = emit(Opcode::Jmp);
+    patch(ShortCircuit, here());
+    emit(Opcode::Const, Ty, Op == BO_LOr);
+    patch(ToEnd, here());
+    return true;
+  }
+
+  if (!compileRValue(E->getLHS(), LHSTy) || !compileRValue(E->getRHS(), RHSTy))
+    return false;
+
+  Opcode Code;
+  switch (Op) {
+  default:
+    return false;
+  case BO_Shl:
+  case BO_Shr:
+    if (LHSTy != Ty)
+      return false;
+    emit(Op == BO_Shl ? Opcode::Shl : Opcode::Shr, Ty, 0, RHSTy.Signed);
+    return true;
+  case BO_Mul: Code = Opcode::Mul; break;
+  case BO_Div: Code = Opcode::Div; break;
+  case BO_Rem: Code = Opcode::Rem; break;
+  case BO_Add: Code = Opcode::Add; break;
+  case BO_Sub: Code = Opcode::Sub; break;
+  case BO_And: Code = Opcode::And; break;
+  case BO_Xor: Code = Opcode::Xor; break;
+  case BO_Or:  Code = Opcode::Or; break;
+  case BO_LT:  Code = Opcode::LT; break;
+  case BO_GT:  Code = Opcode::GT; break;
+  case BO_LE:  Code = Opcode::LE; break;
+  case BO_GE:  Code = Opcode::GE; break;
+  case BO_EQ:  Code = Opcode::EQ; break;
+  case BO_NE:  Code = Opcode::NE; break;
+  }
+
+  // The usual arithmetic conversions have been applied to both operands.
+  if (LHSTy != RHSTy)
+    return false;
+  if (E->isComparisonOp()) {
+    // Comparisons operate on the operand type and produce 0 or 1.
+    emit(Code, LHSTy);
+    return true;
+  }
+  if (LHSTy != Ty)
+    return false;
+  emit(Code, Ty);
+  return true;
+}
+
+bool Compiler::compileLValue(const Expr *E, const Local *&L) {
+  E = E->IgnoreParens();
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    return BO->isAssignmentOp() && compileAssignment(BO, L);
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    return (UO->getOpcode() == UO_PreInc || UO->getOpcode() == UO_PreDec) &&
+           compileIncDec(UO, L);
+  L = getLocal(E);
+  return L != nullptr;
+}
+
+bool Compiler::compileIncDec(const UnaryOperator *E, const Local *&L) {
+  // The AST evaluator handles bool increments specially; leave them to it.
+  L = getLocal(E->getSubExpr());
+  if (!L || L->IsConst || L->Ty.IsBool)
+    return false;
+  emit(Opcode::GetLocal, IntType(), L->Slot);
+  emit(Opcode::Const, L->Ty, 1);
+  emit(E->isIncrementOp() ? Opcode::Add : Opcode::Sub, L->Ty);
+  emit(Opcode::SetLocal, IntType(), L->Slot);
+  return true;
+}
+
+bool Compiler::compileAssignment(const BinaryOperator *E, const Local *&L) {
+  L = getLocal(E->getLHS());
+  if (!L || L->IsConst)
+    return false;
+
+  // The right-hand side is evaluated before the left-hand side is read.
+  IntType RHSTy;
+  if (!compileRValue(E->getRHS(), RHSTy))
+    return false;
+
+  if (E->getOpcode() == BO_Assign) {
+    emitCast(RHSTy, L->Ty);
+    emit(Opcode::SetLocal, IntType(), L->Slot);
+    return true;
+  }
+
+  // Compound assignment: convert the left-hand side to the computation type,
+  // perform the operation, and convert back. Conversions back to bool
+  // truncate in the AST evaluator, so leave those to it.
+  const CompoundAssignOperator *CAO = cast<CompoundAssignOperator>(E);
+  IntType CompTy;
+  if (L->Ty.IsBool || !getIntType(CAO->getComputationLHSType(), CompTy))
+    return false;
+
+  Opcode Code;
+  bool IsShift = false;
+  switch (CAO->getOpcode()) {
+  default:
+    return false;
+  case BO_MulAssign: Code = Opcode::Mul; break;
+  case BO_DivAssign: Code = Opcode::Div; break;
+  case BO_RemAssign: Code = Opcode::Rem; break;
+  case BO_AddAssign: Code = Opcode::Add; break;
+  case BO_SubAssign: Code = Opcode::Sub; break;
+  case BO_AndAssign: Code = Opcode::And; break;
+  case BO_XorAssign: Code = Opcode::Xor; break;
+  case BO_OrAssign:  Code = Opcode::Or; break;
+  case BO_ShlAssign: Code = Opcode::Shl; IsShift = true; break;
+  case BO_ShrAssign: Code = Opcode::Shr; IsShift = true; break;
+  }
+  if (!IsShift && RHSTy != CompTy)
+    return false;
+
+  emit(Opcode::GetLocal, IntType(), L->Slot);
+  emitCast(L->Ty, CompTy);
+  emit(Opcode::Swap);
+  emit(Code, CompTy, 0, RHSTy.Signed);
+  emitCast(CompTy, L->Ty);
+  emit(Opcode::SetLocal, IntType(), L->Slot);
+  return true;
+}
+
+bool Compiler::compileDiscarded(const Expr *E) {
+  E = E->IgnoreParens();
+
+  if (const ExprWithCleanups *EWC = dyn_cast<ExprWithCleanups>(E))
+    return compileDiscarded(EWC->getSubExpr());
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return compileDiscarded(CE->getSubExpr());
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) && compileDiscarded(BO->getRHS());
+
+  // Increments and assignments, whether lvalues (C++) or rvalues (C), are
+  // compiled without reading back the stored value.
+  const Local *L;
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    if (UO->isIncrementDecrementOp())
+      return compileIncDec(UO, L);
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    if (BO->isAssignmentOp())
+      return compileAssignment(BO, L);
+
+  if (E->isGLValue())
+    return compileLValue(E, L);
+
+  IntType Ty;
+  if (!compileRValue(E, Ty))
+    return false;
+  emit(Opcode::Pop);
+  return true;
+}
+
+bool Compiler::compileCall(const CallExpr *E, IntType Ty) {
+  const Expr *Callee = E->getCallee()->IgnoreParenImpCasts();
+  const FunctionDecl *FD = E->getDirectCallee();
+  if (!isa<DeclRefExpr>(Callee) || !FD || FD->getBuiltinID() ||
+      FD->isVariadic() || E->getNumArgs() != FD->getNumParams())
+    return false;
+  if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD))
+    if (!MD->isStatic())
+      return false;
+
+  IntType ReturnTy;
+  if (!getIntType(FD->getReturnType(), ReturnTy) || ReturnTy != Ty)
+    return false;
+
+  for (unsigned I = 0, N = E->getNumArgs(); I != N; ++I) {
+    IntType ParamTy, ArgTy;
+    if (!getIntType(FD->getParamDecl(I)->getType(), ParamTy) ||
+        !compileRValue(E->getArg(I), ArgTy))
+      return false;
+    emitCast(ArgTy, ParamTy);
+  }
+
+  // The callee is compiled lazily when the call is first executed, since its
+  // definition may not have been parsed yet.
+  emit(Opcode::Call, IntType(), F.Callees.size());
+  F.Callees.push_back(FD);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Interpreter
+//===----------------------------------------------------------------------===//
+
+ConstexprInterpreter::ConstexprInterpreter(ASTContext &Ctx) : Ctx(Ctx) {}
+
+ConstexprInterpreter::~ConstexprInterpreter() {}
+
+const ConstexprInterpreter::Function *
+ConstexprInterpreter::getFunction(const FunctionDecl *FD) {
+  FD = FD->getCanonicalDecl();
+  auto Known = Functions.find(FD);
+  if (Known != Functions.end())
+    return Known->second.get();
+
+  // Don't cache anything for a function that has not been defined yet.
+  const FunctionDecl *Definition = nullptr;
+  const Stmt *Body = FD->getBody(Definition);
+  if (!Body)
+    return nullptr;
+
+  std::unique_ptr<Function> F(new Function);
+  if (!Definition->isConstexpr() || Definition->isInvalidDecl() ||
+      Definition->isDependentContext() ||
+      !Compiler(Ctx, *F).compileFunction(Definition, Body))
+    F.reset();
+
+  // Compilation may have evaluated the initializers of global constants,
+  // which can re-enter the interpreter; keep whatever entry is already there.
+  return Functions.insert(std::make_pair(FD, std::move(F)))
+      .first->second.get();
+}
+
+bool ConstexprInterpreter::evaluateCall(const FunctionDecl *FD,
+                                        ArrayRef<APValue> Args,
+                                        unsigned &StepsLeft,
+                                        unsigned DepthLeft, APValue &Result,
+                                        unsigned &CallDepth) {
+  const Function *F = getFunction(FD);
+  if (!F || Args.size() != F->NumParams)
+    return false;
+
+  SmallVector<int64_t, 8> ArgValues;
+  for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+    if (!Args[I].isInt())
+      return false;
+    ArgValues.push_back(fromAPSInt(Args[I].getInt(), F->ParamTypes[I]));
+  }
+
+  // Compiling a callee can evaluate the initializer of a global constant,
+  // which may re-enter the interpreter, so preserve the outer depth watermark.
+  unsigned SavedMinDepthLeft = MinDepthLeft;
+  MinDepthLeft = DepthLeft;
+  int64_t Value;
+  bool Success = run(*F, ArgValues, StepsLeft, DepthLeft, Value);
+  CallDepth = DepthLeft - MinDepthLeft + 1;
+  MinDepthLeft = SavedMinDepthLeft;
+  if (!Success)
+    return false;
+
+  IntType Ty = F->ReturnType;
+  Result = APValue(llvm::APSInt(llvm::APInt(Ty.Width, Value, Ty.Signed),
+                                !Ty.Signed));
+  return true;
+}
+
+/// Perform a checked arithmetic operation, returning false on signed
+/// overflow or division by zero.
+static bool evalArith(Opcode Op, IntType Ty, int64_t LHS, int64_t RHS,
+                      int64_t &Result) {
+  uint64_t ULHS = LHS, URHS = RHS;
+
+  if (!Ty.Signed) {
+    switch (Op) {
+    case Opcode::Add: Result = normalize(Ty, ULHS + URHS); return true;
+    case Opcode::Sub: Result = normalize(Ty, ULHS - URHS); return true;
+    case Opcode::Mul: Result = normalize(Ty, ULHS * URHS); return true;
+    case Opcode::Div:
+    case Opcode::Rem:
+      if (!URHS)
+        return false;
+      Result = normalize(Ty, Op == Opcode::Div ? ULHS / URHS : ULHS % URHS);
+      return true;
+    default:
+      llvm_unreachable("not an arithmetic opcode");
+    }
+  }
+
+  switch (Op) {
+  case Opcode::Add:
+  case Opcode::Sub: {
+    uint64_t Wrapped = Op == Opcode::Add ? ULHS + URHS : ULHS - URHS;
+    if (Ty.Width == 64) {
+      int64_t R = Wrapped;
+      bool Overflow = Op == Opcode::Add ? ((LHS ^ R) & (RHS ^ R)) < 0
+                                        : ((LHS ^ RHS) & (LHS ^ R)) < 0;
+      Result = R;
+      return !Overflow;
+    }
+    // Narrower operands cannot overflow int64_t.
+    Result = Wrapped;
+    return normalize(Ty, Result) == Result;
+  }
+  case Opcode::Mul:
+    if (Ty.Width > 32) {
+      bool Overflow;
+      llvm::APInt R = llvm::APInt(64, ULHS).smul_ov(llvm::APInt(64, URHS),
+                                                    Overflow);
+      Result = R.getSExtValue();
+      return !Overflow && normalize(Ty, Result) == Result;
+    }
+    Result = LHS * RHS;
+    return normalize(Ty, Result) == Result;
+  case Opcode::Div:
+  case Opcode::Rem:
+    if (!RHS || (RHS == -1 && LHS == minSignedValue(Ty)))
+      return false;
+    Result = Op == Opcode::Div ? LHS / RHS : LHS % RHS;
+    return true;
+  default:
+    llvm_unreachable("not an arithmetic opcode");
+  }
+}
+
+/// Perform a shift, returning false for any shift that is not a core constant
+/// expression.
+static bool evalShift(const Instr &I, int64_t LHS, int64_t RHS,
+                      int64_t &Result) {
+  if (I.RHSSigned && RHS < 0)
+    return false;
+  if (uint64_t(RHS) >= I.Ty.Width)
+    return false;
+  unsigned SA = RHS;
+  uint64_t ULHS = LHS;
+
+  if (I.Op == Opcode::Shr) {
+    // Values are kept sign-extended, so this only needs an arithmetic shift
+    // for signed types and a logical shift otherwise.
+    Result = I.Ty.Signed ? (LHS < 0 ? ~(~ULHS >> SA) : ULHS >> SA)
+                         : ULHS >> SA;
+    return true;
+  }
+
+  if (I.Ty.Signed) {
+    if (LHS < 0)
+      return false;
+    // The result must fit in the corresponding unsigned type.
+    if (SA && (ULHS >> (I.Ty.Width - SA)))
+      return false;
+  }
+  Result = normalize(I.Ty, ULHS << SA);
+  return true;
+}
+
+static bool evalCompare(const Instr &I, int64_t LHS, int64_t RHS) {
+  uint64_t ULHS = LHS, URHS = RHS;
+  bool Signed = I.Ty.Signed;
+  switch (I.Op) {
+  case Opcode::LT: return Signed ? LHS < RHS : ULHS < URHS;
+  case Opcode::GT: return Signed ? LHS > RHS : ULHS > URHS;
+  case Opcode::LE: return Signed ? LHS <= RHS : ULHS <= URHS;
+  case Opcode::GE: return Signed ? LHS >= RHS : ULHS >= URHS;
+  case Opcode::EQ: return LHS == RHS;
+  case Opcode::NE: return LHS != RHS;
+  default:
+    llvm_unreachable("not a comparison opcode");
+  }
+}
+
+bool ConstexprInterpreter::run(const Function &F, ArrayRef<int64_t> Args,
+                               unsigned &StepsLeft, unsigned DepthLeft,
+                               int64_t &Result) {
+  MinDepthLeft = std::min(MinDepthLeft, DepthLeft);
+  SmallVector<int64_t, 16> Locals(F.NumLocals, 0);
+  std::copy(Args.begin(), Args.end(), Locals.begin());
+  SmallVector<int64_t, 16> Stack;
+
+  auto Pop = [&]() { return Stack.pop_back_val(); };
+
+  for (size_t PC = 0;;) {
+    const Instr &I = F.Code[PC++];
+    switch (I.Op) {
+    case Opcode::Const:
+      Stack.push_back(I.Operand);
+      break;
+    case Opcode::GetLocal:
+      Stack.push_back(Locals[I.Operand]);
+      break;
+    case Opcode::SetLocal:
+      Locals[I.Operand] = Pop();
+      break;
+    case Opcode::Dup:
+      Stack.push_back(Stack.back());
+      break;
+    case Opcode::Swap:
+      std::swap(Stack[Stack.size() - 1], Stack[Stack.size() - 2]);
+      break;
+    case Opcode::Pop:
+      Stack.pop_back();
+      break;
+    case Opcode::Cast:
+      Stack.back() = normalize(I.Ty, Stack.back());
+      break;
+
+    case Opcode::Neg: {
+      int64_t V = Stack.back();
+      if (I.Ty.Signed && V == minSignedValue(I.Ty))
+        return false;
+      Stack.back() = normalize(I.Ty, 0 - uint64_t(V));
+      break;
+    }
+    case Opcode::Not:
+      Stack.back() = normalize(I.Ty, ~uint64_t(Stack.back()));
+      break;
+    case Opcode::LNot:
+      Stack.back() = Stack.back() == 0;
+      break;
+
+    case Opcode::Add:
+    case Opcode::Sub:
+    case Opcode::Mul:
+    case Opcode::Div:
+    case Opcode::Rem: {
+      int64_t RHS = Pop();
+      if (!evalArith(I.Op, I.Ty, Stack.back(), RHS, Stack.back()))
+        return false;
+      break;
+    }
+    case Opcode::Shl:
+    case Opcode::Shr: {
+      int64_t RHS = Pop();
+      if (!evalShift(I, Stack.back(), RHS, Stack.back()))
+        return false;
+      break;
+    }
+    case Opcode::And: {
+      int64_t RHS = Pop();
+      Stack.back() &= RHS;
+      break;
+    }
+    case Opcode::Or: {
+      int64_t RHS = Pop();
+      Stack.back() |= RHS;
+      break;
+    }
+    case Opcode::Xor: {
+      int64_t RHS = Pop();
+      Stack.back() ^= RHS;
+      break;
+    }
+    case Opcode::LT:
+    case Opcode::GT:
+    case Opcode::LE:
+    case Opcode::GE:
+    case Opcode::EQ:
+    case Opcode::NE: {
+      int64_t RHS = Pop();
+      Stack.back() = evalCompare(I, Stack.back(), RHS);
+      break;
+    }
+
+    case Opcode::Jmp:
+      PC = I.Operand;
+      break;
+    case Opcode::Jz:
+      if (Pop() == 0)
+        PC = I.Operand;
+      break;
+    case Opcode::Jnz:
+      if (Pop() != 0)
+        PC = I.Operand;
+      break;
+
+    case Opcode::Call: {
+      const Function *Callee = getFunction(F.Callees[I.Operand]);
+      if (!Callee || !DepthLeft)
+        return false;
+      unsigned NumArgs = Callee->NumParams;
+      int64_t Value;
+      if (!run(*Callee, makeArrayRef(Stack).take_back(NumArgs), StepsLeft,
+               DepthLeft - 1, Value))
+        return false;
+      Stack.resize(Stack.size() - NumArgs);
+      Stack.push_back(Value);
+      break;
+    }
+    case Opcode::Ret:
+      Result = Pop();
+      return true;
+
+    case Opcode::Step:
+      if (!StepsLeft)
+        return false;
+      --StepsLeft;
+      break;
+    case Opcode::Trap:
+      return false;
+    }
+  }
+}
@@ -0,0 +1,79 @@
+//===--- ConstexprInterpreter.h - Bytecode constexpr evaluation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides a compact bytecode compiler and interpreter for the subset of
+// constexpr functions that only manipulate integral values. Functions are
+// compiled once per ASTContext and can then be called repeatedly without
+// re-walking their ASTs. Anything outside the supported subset is rejected
+// when compiling, and any evaluation that would need a diagnostic fails at run
+// time, so callers must always be prepared to fall back to the AST evaluator.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+
+namespace clang {
+
+class ASTContext;
+class FunctionDecl;
+
+/// Compiles integral constexpr functions to bytecode and evaluates calls to
+/// them.
+class ConstexprInterpreter {
+public:
+  class Function;
+
+  explicit ConstexprInterpreter(ASTContext &Ctx);
+  ~ConstexprInterpreter();
+
+  /// \brief Evaluate a call to \p FD with the already-evaluated arguments
+  /// \p Args.
+  ///
+  /// \param StepsLeft The remaining evaluation step budget. Every statement
+  /// executed consumes one step, exactly as in the AST evaluator.
+  /// \param DepthLeft The number of further nested calls that may be made.
+  /// \param CallDepth Set to the deepest level of nested calls made, counting
+  /// this call as 1.
+  ///
+  /// \returns true and sets \p Result if the call was evaluated. Returns false
+  /// if the function cannot be compiled, or if evaluation hit anything that
+  /// the AST evaluator would diagnose; in that case \p Result and
+  /// \p StepsLeft are unspecified.
+  bool evaluateCall(const FunctionDecl *FD, ArrayRef<APValue> Args,
+                    unsigned &StepsLeft, unsigned DepthLeft, APValue &Result,
+                    unsigned &CallDepth);
+
+private:
+  /// \brief Return the compiled form of \p FD, or null if it is outside the
+  /// supported subset.
+  const Function *getFunction(const FunctionDecl *FD);
+
+  bool run(const Function &F, ArrayRef<int64_t> Args, unsigned &StepsLeft,
+           unsigned DepthLeft, int64_t &Result);
+
+  ASTContext &Ctx;
+
+  /// \brief The smallest DepthLeft seen by run() in the current evaluation.
+  unsigned MinDepthLeft = 0;
+
+  /// \brief Compiled functions, keyed by canonical declaration. A null entry
+  /// records a function that cannot be compiled.
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<Function>> Functions;
+};
+
+} // end namespace clang
+
+#endif
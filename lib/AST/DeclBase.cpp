@@ -166,6 +166,27 @@ void Decl::EnableStatistics() {
   StatisticsEnabled = true;
 }
 
+/// The context that the memory of declarations created on this thread is
+/// attributed to by its memory report, if any.
+static LLVM_THREAD_LOCAL const ASTContext *DeclMemoryAccountingContext =
+    nullptr;
+
+bool Decl::MemoryAccountingEnabled = false;
+void Decl::setMemoryAccountingContext(const ASTContext *Ctx) {
+  DeclMemoryAccountingContext = Ctx;
+  if (Ctx)
+    MemoryAccountingEnabled = true;
+}
+
+const ASTContext *Decl::getMemoryAccountingContext() {
+  return DeclMemoryAccountingContext;
+}
+
+void Decl::noteConstructed(const Decl *D) {
+  if (DeclMemoryAccountingContext)
+    DeclMemoryAccountingContext->noteNodeConstructed(D);
+}
+
 void Decl::PrintStats() {
   llvm::errs() << "\n*** Decl Stats:\n";
 
@@ -1264,6 +1285,7 @@ ExternalASTSource::SetNoExternalVisibleDeclsForName(const DeclContext *DC,
     DC->reconcileExternalVisibleStorage();
 
   (*Map)[Name].removeExternalDecls();
+  Context.notifyDeclLookupChanged(Name);
 
   return DeclContext::lookup_result();
 }
@@ -1314,6 +1336,7 @@ ExternalASTSource::SetExternalVisibleDeclsForName(const DeclContext *DC,
     }
   }
 
+  Context.notifyDeclLookupChanged(Name);
   return List.getLookupResult();
 }
 
@@ -1368,6 +1391,8 @@ void DeclContext::removeDecl(Decl *D) {
     // Remove only decls that have a name
     if (!ND->getDeclName()) return;
 
+    getParentASTContext().notifyDeclLookupChanged(ND->getDeclName());
+
     auto *DC = D->getDeclContext();
     do {
       StoredDeclsMap *Map = DC->getPrimaryContext()->LookupPtr;
@@ -1394,6 +1419,11 @@ void DeclContext::addHiddenDecl(Decl *D) {
     FirstDecl = LastDecl = D;
   }
 
+  // A lazily-built lookup table may pick this declaration up later.
+  if (NamedDecl *ND = dyn_cast<NamedDecl>(D))
+    if (isLookupContext())
+      getParentASTContext().notifyDeclLookupChanged(ND->getDeclName());
+
   // Notify a C++ record declaration that we've added a member, so it can
   // update its class-specific state.
   if (CXXRecordDecl *Record = dyn_cast<CXXRecordDecl>(this))
@@ -1477,6 +1507,19 @@ StoredDeclsMap *DeclContext::buildLookup() {
       return LookupPtr;
   }
 
+  // Size the table for every declaration up front, rather than growing it
+  // repeatedly while adding the members of a large namespace or enum. This
+  // overestimates when there are redeclarations or unnamed declarations, but
+  // only by a bounded factor.
+  unsigned NumDecls = LookupPtr ? LookupPtr->size() : 0;
+  for (auto *DC : Contexts)
+    NumDecls += std::distance(DC->noload_decls_begin(), DC->noload_decls_end());
+  if (NumDecls > 16) {
+    if (!LookupPtr)
+      CreateStoredDeclsMap(getParentASTContext());
+    LookupPtr->reserve(NumDecls);
+  }
+
   for (auto *DC : Contexts)
     buildLookupImpl(DC, hasExternalVisibleStorage());
 
@@ -1713,6 +1756,8 @@ void DeclContext::makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
   if (shouldBeHidden(D))
     return;
 
+  getParentASTContext().notifyDeclLookupChanged(D->getDeclName());
+
   // If we already have a lookup data structure, perform the insertion into
   // it. If we might have externally-stored decls with this name, look them
   // up and perform the insertion. If this decl was declared outside its
@@ -1834,6 +1879,49 @@ void ASTContext::ReleaseDeclContextMaps() {
   StoredDeclsMap::DestroyAll(LastSDM.getPointer(), LastSDM.getInt());
 }
 
+StoredDeclsMap::StoredDeclsMap() : Buckets(getInlineBuckets()) {
+  for (unsigned I = 0; I != NumInlineBuckets; ++I)
+    new (&Buckets[I]) value_type(DeclarationName::getEmptyMarker(),
+                                 StoredDeclsList());
+}
+
+StoredDeclsMap::~StoredDeclsMap() {
+  for (unsigned I = 0; I != NumBuckets; ++I)
+    Buckets[I].~value_type();
+  if (!isSmall())
+    operator delete(Buckets);
+}
+
+void StoredDeclsMap::grow(unsigned MinBuckets) {
+  unsigned NewNumBuckets = llvm::PowerOf2Ceil(MinBuckets);
+  if (NewNumBuckets <= NumBuckets)
+    return;
+
+  value_type *OldBuckets = Buckets;
+  unsigned OldNumBuckets = NumBuckets;
+  bool WasSmall = isSmall();
+
+  Buckets = static_cast<value_type *>(
+      operator new(sizeof(value_type) * NewNumBuckets));
+  NumBuckets = NewNumBuckets;
+  Log2NumBuckets = llvm::Log2_32(NewNumBuckets);
+  for (unsigned I = 0; I != NewNumBuckets; ++I)
+    new (&Buckets[I]) value_type(DeclarationName::getEmptyMarker(),
+                                 StoredDeclsList());
+
+  for (unsigned I = 0; I != OldNumBuckets; ++I) {
+    value_type &Old = OldBuckets[I];
+    if (!isEmptyKey(Old.first)) {
+      value_type *Bucket = lookupBucket(Old.first);
+      Bucket->first = Old.first;
+      Bucket->second = std::move(Old.second);
+    }
+    Old.~value_type();
+  }
+  if (!WasSmall)
+    operator delete(OldBuckets);
+}
+
 void StoredDeclsMap::DestroyAll(StoredDeclsMap *Map, bool Dependent) {
   while (Map) {
     // Advance the iteration before we invalidate memory.
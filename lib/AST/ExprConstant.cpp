@@ -33,6 +33,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprCallCache.h"
+#include "ConstexprInterpreter.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -572,6 +574,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// DeepestCallStackDepth - The largest value CallStackDepth has reached.
+    /// Used to record how deep a memoized call went.
+    unsigned DeepestCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -636,6 +642,18 @@ namespace {
     /// \brief Whether or not we're currently speculatively evaluating.
     bool IsSpeculativelyEvaluating;
 
+    /// UnmemoizableEvents - The number of times evaluation has done something
+    /// that makes the result of the calls in progress depend on more than
+    /// their arguments: producing a diagnostic, hitting a side-effect or
+    /// undefined behavior, or accessing an object whose initializer is being
+    /// evaluated.
+    unsigned UnmemoizableEvents;
+
+    /// AddressUses - The number of times evaluation has compared, subtracted
+    /// or offset a pointer, making its result depend on where the objects
+    /// involved are.
+    unsigned AddressUses;
+
     enum EvaluationMode {
       /// Evaluate as a constant expression. Stop if we find that the expression
       /// is not a constant expression.
@@ -703,13 +721,13 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), DeepestCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
         EvaluatingDeclValue(nullptr), HasActiveDiagnostic(false),
         HasFoldFailureDiagnostic(false), IsSpeculativelyEvaluating(false),
-        EvalMode(Mode) {}
+        UnmemoizableEvents(0), AddressUses(0), EvalMode(Mode) {}
 
     void setEvaluatingDecl(APValue::LValueBase Base, APValue &Value) {
       EvaluatingDecl = Base;
@@ -746,6 +764,12 @@ namespace {
       return (Frame->Index == CallIndex) ? Frame : nullptr;
     }
 
+    /// Note that the result of the calls in progress must not be memoized.
+    void noteUnmemoizable() { ++UnmemoizableEvents; }
+
+    /// Note that a pointer was compared, subtracted or offset.
+    void noteAddressUse() { ++AddressUses; }
+
     bool nextStep(const Stmt *S) {
       if (!StepsLeft) {
         FFDiag(S->getLocStart(), diag::note_constexpr_step_limit_exceeded);
@@ -821,12 +845,14 @@ namespace {
     FFDiag(SourceLocation Loc,
           diag::kind DiagId = diag::note_invalid_subexpr_in_const_expr,
           unsigned ExtraNotes = 0) {
+      noteUnmemoizable();
       return Diag(Loc, DiagId, ExtraNotes, false);
     }
     
     OptionalDiagnostic FFDiag(const Expr *E, diag::kind DiagId
                               = diag::note_invalid_subexpr_in_const_expr,
                             unsigned ExtraNotes = 0) {
+      noteUnmemoizable();
       if (EvalStatus.Diag)
         return Diag(E->getExprLoc(), DiagId, ExtraNotes, /*IsCCEDiag*/false);
       HasActiveDiagnostic = false;
@@ -841,6 +867,7 @@ namespace {
     OptionalDiagnostic CCEDiag(SourceLocation Loc, diag::kind DiagId
                                  = diag::note_invalid_subexpr_in_const_expr,
                                unsigned ExtraNotes = 0) {
+      noteUnmemoizable();
       // Don't override a previous diagnostic. Don't bother collecting
       // diagnostics if we're evaluating for overflow.
       if (!EvalStatus.Diag || !EvalStatus.Diag->empty()) {
@@ -891,6 +918,7 @@ namespace {
     /// Note that we have had a side-effect, and determine whether we should
     /// keep evaluating.
     bool noteSideEffect() {
+      noteUnmemoizable();
       EvalStatus.HasSideEffects = true;
       return keepEvaluatingAfterSideEffect();
     }
@@ -917,6 +945,7 @@ namespace {
     /// that we can evaluate past it (such as signed overflow or floating-point
     /// division by zero.)
     bool noteUndefinedBehavior() {
+      noteUnmemoizable();
       EvalStatus.HasUndefinedBehavior = true;
       return keepEvaluatingAfterUndefinedBehavior();
     }
@@ -1152,6 +1181,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.DeepestCallStackDepth =
+      std::max(Info.DeepestCallStackDepth, Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -2448,6 +2479,7 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // If we're currently evaluating the initializer of this declaration, use that
   // in-flight value.
   if (Info.EvaluatingDecl.dyn_cast<const ValueDecl*>() == VD) {
+    Info.noteUnmemoizable();
     Result = Info.EvaluatingDeclValue;
     return true;
   }
@@ -3057,6 +3089,7 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
         // OK, we can read and modify an object if we're in the process of
         // evaluating its initializer, because its lifetime began in this
         // evaluation.
+        Info.noteUnmemoizable();
       } else if (AK != AK_Read) {
         // All the remaining cases only permit reading.
         Info.FFDiag(E, diag::note_constexpr_modify_global);
@@ -3139,6 +3172,8 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
           Info.Note(MTE->getExprLoc(), diag::note_constexpr_temporary_here);
           return CompleteObject();
         }
+        if (VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())
+          Info.noteUnmemoizable();
 
         BaseVal = Info.Ctx.getMaterializedTemporaryValue(MTE, false);
         assert(BaseVal && "got reference to unevaluated temporary");
@@ -3336,6 +3371,7 @@ struct CompoundAssignSubobjectHandler {
     if (Opcode == BO_Sub)
       negateAsSigned(Offset);
 
+    Info.noteAddressUse();
     LValue LVal;
     LVal.setFrom(Info.Ctx, Subobj);
     if (!HandleLValueArrayAdjustment(Info, E, LVal, PointeeType, Offset))
@@ -3488,6 +3524,7 @@ struct IncDecSubobjectHandler {
       return false;
     }
 
+    Info.noteAddressUse();
     LValue LVal;
     LVal.setFrom(Info.Ctx, Subobj);
     if (!HandleLValueArrayAdjustment(Info, E, LVal, PointeeType,
@@ -4251,19 +4288,15 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
-/// Evaluate a function call.
-static bool HandleFunctionCall(SourceLocation CallLoc,
-                               const FunctionDecl *Callee, const LValue *This,
-                               ArrayRef<const Expr*> Args, const Stmt *Body,
-                               EvalInfo &Info, APValue &Result,
-                               const LValue *ResultSlot) {
-  ArgVector ArgValues(Args.size());
-  if (!EvaluateArgs(Args, ArgValues, Info))
-    return false;
-
-  if (!Info.CheckCallLimit(CallLoc))
-    return false;
-
+/// Evaluate a function call by walking its body, once the arguments have been
+/// evaluated and the call limit checked.
+static bool HandleFunctionCallInAST(SourceLocation CallLoc,
+                                    const FunctionDecl *Callee,
+                                    const LValue *This,
+                                    ArrayRef<const Expr *> Args,
+                                    ArgVector &ArgValues, const Stmt *Body,
+                                    EvalInfo &Info, APValue &Result,
+                                    const LValue *ResultSlot) {
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -4305,6 +4338,136 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   return ESR == ESR_Returned;
 }
 
+/// Evaluate a function call whose arguments have been evaluated, using the
+/// bytecode interpreter if it is enabled and can handle the call.
+static bool HandleFunctionCallBody(SourceLocation CallLoc,
+                                   const FunctionDecl *Callee,
+                                   const LValue *This,
+                                   ArrayRef<const Expr *> Args,
+                                   ArgVector &ArgValues, const Stmt *Body,
+                                   EvalInfo &Info, APValue &Result,
+                                   const LValue *ResultSlot) {
+  // Try the bytecode interpreter first. It gives up, rather than diagnosing,
+  // on anything outside its subset, in which case we walk the AST instead.
+  const LangOptions &LangOpts = Info.getLangOpts();
+  if (LangOpts.ConstexprBytecode && !This &&
+      !Info.checkingPotentialConstantExpression()) {
+    ConstexprInterpreter &Interp = Info.Ctx.getConstexprInterpreter();
+    unsigned DepthLeft = LangOpts.ConstexprCallDepth - Info.CallStackDepth;
+    unsigned StepsLeft = Info.StepsLeft;
+    unsigned CallDepth;
+    APValue BytecodeResult;
+    if (Interp.evaluateCall(Callee, ArgValues, StepsLeft, DepthLeft,
+                            BytecodeResult, CallDepth)) {
+      if (!LangOpts.ConstexprBytecodeVerify) {
+        Info.StepsLeft = StepsLeft;
+        Info.DeepestCallStackDepth = std::max(Info.DeepestCallStackDepth,
+                                              Info.CallStackDepth + CallDepth);
+        Result = std::move(BytecodeResult);
+        return true;
+      }
+
+      unsigned StepsBefore = Info.StepsLeft;
+      bool Success = HandleFunctionCallInAST(CallLoc, Callee, This, Args,
+                                             ArgValues, Body, Info, Result,
+                                             ResultSlot);
+      const APSInt &Value = BytecodeResult.getInt();
+      if (!Success || !Result.isInt() ||
+          !APSInt::isSameValue(Result.getInt(), Value) ||
+          StepsLeft != Info.StepsLeft) {
+        DiagnosticBuilder DB = Info.Ctx.getDiagnostics().Report(
+            CallLoc, diag::err_constexpr_bytecode_mismatch);
+        DB << Callee << Value.toString(10) << (StepsBefore - StepsLeft)
+           << (Success && Result.isInt());
+        if (Success && Result.isInt())
+          DB << Result.getInt().toString(10) << (StepsBefore - Info.StepsLeft);
+      }
+      return Success;
+    }
+  }
+
+  return HandleFunctionCallInAST(CallLoc, Callee, This, Args, ArgValues, Body,
+                                 Info, Result, ResultSlot);
+}
+
+/// Determine whether the result of a call evaluated in the current state
+/// could be reused by a later evaluation of the same call.
+static bool canMemoizeCall(const EvalInfo &Info) {
+  switch (Info.EvalMode) {
+  case EvalInfo::EM_ConstantExpression:
+  case EvalInfo::EM_ConstantExpressionUnevaluated:
+  case EvalInfo::EM_ConstantFold:
+  case EvalInfo::EM_IgnoreSideEffects:
+    break;
+  case EvalInfo::EM_PotentialConstantExpression:
+  case EvalInfo::EM_PotentialConstantExpressionUnevaluated:
+  case EvalInfo::EM_EvaluateForOverflow:
+  case EvalInfo::EM_OffsetFold:
+    return false;
+  }
+  // After an unmodeled side-effect, and while speculatively evaluating, local
+  // state is less accessible than it would be in a fresh evaluation.
+  return !Info.IsSpeculativelyEvaluating && !Info.EvalStatus.HasSideEffects;
+}
+
+/// Evaluate a function call.
+static bool HandleFunctionCall(SourceLocation CallLoc,
+                               const FunctionDecl *Callee, const LValue *This,
+                               ArrayRef<const Expr*> Args, const Stmt *Body,
+                               EvalInfo &Info, APValue &Result,
+                               const LValue *ResultSlot) {
+  ArgVector ArgValues(Args.size());
+  if (!EvaluateArgs(Args, ArgValues, Info))
+    return false;
+
+  if (!Info.CheckCallLimit(CallLoc))
+    return false;
+
+  // Reuse the result of an identical earlier call if there is one. A cached
+  // result still consumes the steps and call depth the original evaluation
+  // needed, so this never succeeds where re-evaluating would fail.
+  const LangOptions &LangOpts = Info.getLangOpts();
+  ConstexprCallCache *Cache = nullptr;
+  llvm::FoldingSetNodeID CallID;
+  if (LangOpts.ConstexprCallCache && !This && canMemoizeCall(Info)) {
+    Cache = &Info.Ctx.getConstexprCallCache();
+    unsigned DepthLeft = LangOpts.ConstexprCallDepth - Info.CallStackDepth + 1;
+    if (!ConstexprCallCache::profileCall(CallID, Callee, Info.EvalMode,
+                                         ArgValues)) {
+      Cache->noteUncacheable();
+      Cache = nullptr;
+    } else if (const ConstexprCallCache::Entry *Cached =
+                   Cache->lookup(CallID, Info.StepsLeft, DepthLeft)) {
+      Info.StepsLeft -= Cached->Steps;
+      Info.DeepestCallStackDepth = std::max(
+          Info.DeepestCallStackDepth, Info.CallStackDepth + Cached->Depth);
+      Result = Cached->Result;
+      return true;
+    }
+  }
+
+  unsigned StepsBefore = Info.StepsLeft;
+  unsigned EventsBefore = Info.UnmemoizableEvents;
+  unsigned OuterDeepest = Info.DeepestCallStackDepth;
+  Info.DeepestCallStackDepth = Info.CallStackDepth;
+
+  bool Success = HandleFunctionCallBody(CallLoc, Callee, This, Args, ArgValues,
+                                        Body, Info, Result, ResultSlot);
+
+  unsigned Depth = Info.DeepestCallStackDepth - Info.CallStackDepth;
+  Info.DeepestCallStackDepth = std::max(OuterDeepest,
+                                        Info.DeepestCallStackDepth);
+
+  if (Cache) {
+    if (Success && Info.UnmemoizableEvents == EventsBefore &&
+        ConstexprCallCache::isCacheableValue(Result))
+      Cache->insert(CallID, Result, StepsBefore - Info.StepsLeft, Depth);
+    else
+      Cache->noteUncacheable();
+  }
+  return Success;
+}
+
 /// Evaluate a constructor call.
 static bool HandleConstructorCall(const Expr *E, const LValue &This,
                                   APValue *ArgValues,
@@ -5349,6 +5512,11 @@ bool LValueExprEvaluator::VisitArraySubscriptExpr(const ArraySubscriptExpr *E) {
   if (!EvaluateInteger(E->getIdx(), Index, Info))
     return false;
 
+  // Subscripting an array stays within that array, but subscripting a pointer
+  // can reach anything around the object it points to.
+  if (!E->getBase()->IgnoreParenImpCasts()->getType()->isArrayType())
+    Info.noteAddressUse();
+
   return Success &&
          HandleLValueArrayAdjustment(Info, E, Result, E->getType(), Index);
 }
@@ -5654,6 +5822,7 @@ bool PointerExprEvaluator::VisitBinaryOperator(const BinaryOperator *E) {
   if (E->getOpcode() == BO_Sub)
     negateAsSigned(Offset);
 
+  Info.noteAddressUse();
   QualType Pointee = PExp->getType()->castAs<PointerType>()->getPointeeType();
   return HandleLValueArrayAdjustment(Info, E, Result, Pointee, Offset);
 }
@@ -6787,6 +6956,53 @@ static bool EvaluateArray(const Expr *E, const LValue &This,
   return ArrayExprEvaluator(Info, This, Result).Visit(E);
 }
 
+namespace {
+/// Running a non-trivial initializer for each element of a large array usually
+/// stores the same value over and over. This watches the evaluation of the
+/// initializer for one element, and if the value cannot have depended on
+/// which element it was computed for, uses it as the array filler for all the
+/// remaining elements rather than evaluating and storing it again for each.
+class ArrayFillerSharing {
+  EvalInfo &Info;
+  unsigned StepsLeft;
+  unsigned UnmemoizableEvents;
+  unsigned AddressUses;
+
+public:
+  /// Start watching the evaluation of an element's initializer.
+  explicit ArrayFillerSharing(EvalInfo &Info)
+      : Info(Info), StepsLeft(Info.StepsLeft),
+        UnmemoizableEvents(Info.UnmemoizableEvents),
+        AddressUses(Info.AddressUses) {}
+
+  /// Having evaluated the last initialized element of \p Array, try to make
+  /// its value the array filler. The steps the remaining elements would have
+  /// taken to evaluate are still charged, so this never succeeds where
+  /// evaluating each element would have failed.
+  bool share(APValue &Array) {
+    // The value must be a plain value, and we must not have done arithmetic
+    // or comparisons on pointers (which could reach or identify this
+    // element), hit anything worth diagnosing, or touched the variable being
+    // initialized along the way.
+    unsigned Index = Array.getArrayInitializedElts() - 1;
+    if (!Array.hasArrayFiller() ||
+        Info.UnmemoizableEvents != UnmemoizableEvents ||
+        Info.AddressUses != AddressUses ||
+        !ConstexprCallCache::isCacheableValue(
+            Array.getArrayInitializedElt(Index)))
+      return false;
+
+    uint64_t Steps = StepsLeft - Info.StepsLeft;
+    uint64_t Remaining = Array.getArraySize() - Index - 1;
+    if (Steps * Remaining > Info.StepsLeft)
+      return false;
+    Info.StepsLeft -= Steps * Remaining;
+    Array.getArrayFiller() = Array.getArrayInitializedElt(Index);
+    return true;
+  }
+};
+} // end anonymous namespace
+
 bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
   const ConstantArrayType *CAT = Info.Ctx.getAsConstantArrayType(E->getType());
   if (!CAT)
@@ -6817,8 +7033,13 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
 
   // If the initializer might depend on the array index, run it for each
   // array element. For now, just whitelist non-class value-initialization.
-  if (NumEltsToInit != NumElts && !isa<ImplicitValueInitExpr>(FillerExpr))
-    NumEltsToInit = NumElts;
+  // Otherwise, start by running it for the first element only, in the hope
+  // that its value can be shared with the rest.
+  bool ShareFiller = false;
+  if (NumEltsToInit != NumElts && !isa<ImplicitValueInitExpr>(FillerExpr)) {
+    ShareFiller = NumElts - NumEltsToInit > 1 && canMemoizeCall(Info);
+    NumEltsToInit = ShareFiller ? NumEltsToInit + 1 : NumElts;
+  }
 
   Result = APValue(APValue::UninitArray(), NumEltsToInit, NumElts);
 
@@ -6836,6 +7057,7 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
   for (unsigned Index = 0; Index != NumEltsToInit; ++Index) {
     const Expr *Init =
         Index < E->getNumInits() ? E->getInit(Index) : FillerExpr;
+    ArrayFillerSharing Sharing(Info);
     if (!EvaluateInPlace(Result.getArrayInitializedElt(Index),
                          Info, Subobject, Init) ||
         !HandleLValueArrayAdjustment(Info, Init, Subobject,
@@ -6844,6 +7066,17 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
         return false;
       Success = false;
     }
+
+    if (ShareFiller && Index + 1 == NumEltsToInit) {
+      ShareFiller = false;
+      if (Success && Result.getArrayInitializedElts() == NumEltsToInit &&
+          Sharing.share(Result))
+        return true;
+      // No luck; evaluate the initializer for the remaining elements too.
+      if (Result.hasArrayFiller())
+        expandArray(Result, NumElts - 1);
+      NumEltsToInit = NumElts;
+    }
   }
 
   if (!Result.hasArrayFiller())
@@ -6903,22 +7136,41 @@ bool ArrayExprEvaluator::VisitCXXConstructExpr(const CXXConstructExpr *E,
       HadZeroInit && Value->hasArrayFiller() ? Value->getArrayFiller()
                                              : APValue();
 
-    *Value = APValue(APValue::UninitArray(), N, N);
+    // If the constructor takes no arguments, start by constructing only the
+    // first element, in the hope that its value can be shared with the rest.
+    bool ShareFiller = N > 1 && E->getNumArgs() == 0 && canMemoizeCall(Info);
+    unsigned NumEltsToInit = ShareFiller ? 1 : N;
+    *Value = APValue(APValue::UninitArray(), NumEltsToInit, N);
 
-    if (HadZeroInit)
-      for (unsigned I = 0; I != N; ++I)
+    if (HadZeroInit) {
+      for (unsigned I = 0; I != NumEltsToInit; ++I)
         Value->getArrayInitializedElt(I) = Filler;
+      if (Value->hasArrayFiller())
+        Value->getArrayFiller() = Filler;
+    }
 
     // Initialize the elements.
     LValue ArrayElt = Subobject;
     ArrayElt.addArray(Info, E, CAT);
-    for (unsigned I = 0; I != N; ++I)
+    for (unsigned I = 0; I != NumEltsToInit; ++I) {
+      ArrayFillerSharing Sharing(Info);
       if (!VisitCXXConstructExpr(E, ArrayElt, &Value->getArrayInitializedElt(I),
                                  CAT->getElementType()) ||
           !HandleLValueArrayAdjustment(Info, E, ArrayElt,
                                        CAT->getElementType(), 1))
         return false;
 
+      if (ShareFiller) {
+        ShareFiller = false;
+        if (Value->getArrayInitializedElts() == 1 && Sharing.share(*Value))
+          return true;
+        // No luck; construct the remaining elements too.
+        if (Value->hasArrayFiller())
+          expandArray(*Value, N - 1);
+        NumEltsToInit = N;
+      }
+    }
+
     return true;
   }
 
@@ -7595,6 +7847,9 @@ static bool determineEndOffset(EvalInfo &Info, SourceLocation ExprLoc,
 /// is to be treated as an Error in IntExprEvaluator.
 static bool tryEvaluateBuiltinObjectSize(const Expr *E, unsigned Type,
                                          EvalInfo &Info, uint64_t &Size) {
+  // The result depends on where the pointer points within its object.
+  Info.noteAddressUse();
+
   // Determine the denoted object.
   LValue LVal;
   {
@@ -8476,6 +8731,8 @@ bool IntExprEvaluator::VisitBinaryOperator(const BinaryOperator *E) {
       if (!EvaluatePointer(E->getRHS(), RHSValue, Info) || !LHSOK)
         return false;
 
+      Info.noteAddressUse();
+
       // Reject differing bases from the normal codepath; we special-case
       // comparisons to null.
       if (!HasSameBase(LHSValue, RHSValue)) {
@@ -2915,6 +2915,95 @@ void MicrosoftRecordLayoutBuilder::computeVtorDispSet(
   }
 }
 
+/// The size of the cache lines that -Rpadded-layout reports fields crossing.
+static const uint64_t CacheLineSize = 64;
+
+/// Report, for -Rpadded-layout, how much of \p RD is padding, the order of
+/// its fields that would make it smallest, and the fields that cross a cache
+/// line boundary when it starts on one.
+static void diagnoseRecordLayout(const ASTContext &Context,
+                                 const RecordDecl *RD,
+                                 const ASTRecordLayout &Layout) {
+  if (RD->isUnion() || RD->getLocation().isInvalid() || RD->field_empty())
+    return;
+  // The layout of records in system headers is not the user's to change.
+  if (Context.getSourceManager().isInSystemHeader(RD->getLocation()))
+    return;
+  // The fields of these records cannot simply be moved around.
+  if (RD->hasAttr<PackedAttr>() || RD->hasAttr<MaxFieldAlignmentAttr>())
+    return;
+  if (const auto *CXXRD = dyn_cast<CXXRecordDecl>(RD))
+    if (CXXRD->getNumVBases() || CXXRD->isLambda())
+      return;
+
+  struct FieldInfo {
+    const FieldDecl *FD;
+    uint64_t Offset, Size, Align;
+  };
+  SmallVector<FieldInfo, 16> Fields;
+  uint64_t FieldsSize = 0;
+  for (const FieldDecl *FD : RD->fields()) {
+    // Only whole bytes can be accounted for.
+    if (FD->isBitField() || FD->getType()->isIncompleteArrayType())
+      return;
+    uint64_t Offset = Layout.getFieldOffset(FD->getFieldIndex());
+    if (Offset % Context.getCharWidth())
+      return;
+    FieldInfo Info = {FD, Offset / Context.getCharWidth(),
+                      uint64_t(Context.getTypeSizeInChars(FD->getType())
+                                   .getQuantity()),
+                      uint64_t(Context.getDeclAlign(FD).getQuantity())};
+    Fields.push_back(Info);
+    FieldsSize += Info.Size;
+  }
+
+  QualType Type = Context.getTypeDeclType(RD);
+  for (const FieldInfo &Field : Fields) {
+    if (Field.Size > CacheLineSize || !Field.Size)
+      continue;
+    if (Field.Offset / CacheLineSize ==
+        (Field.Offset + Field.Size - 1) / CacheLineSize)
+      continue;
+    Context.getDiagnostics().Report(Field.FD->getLocation(),
+                                    diag::remark_padded_layout_cache_line)
+        << Field.FD << unsigned(Field.Offset) << Type
+        << unsigned(CacheLineSize);
+  }
+
+  // Bases and the vtable pointer come before the fields.
+  uint64_t Start = Fields.front().Offset;
+  uint64_t Size = Layout.getSize().getQuantity();
+  if (Size <= Start + FieldsSize)
+    return;
+
+  // Placing the fields by decreasing alignment leaves no padding between
+  // them, since the size of a type is a multiple of its alignment.
+  SmallVector<FieldInfo, 16> Sorted(Fields.begin(), Fields.end());
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const FieldInfo &LHS, const FieldInfo &RHS) {
+                     return LHS.Align > RHS.Align;
+                   });
+  uint64_t SortedSize = Start;
+  for (const FieldInfo &Field : Sorted)
+    SortedSize = llvm::alignTo(SortedSize, Field.Align) + Field.Size;
+  SortedSize = llvm::alignTo(SortedSize, Layout.getAlignment().getQuantity());
+
+  std::string Order;
+  llvm::raw_string_ostream OrderOS(Order);
+  for (const FieldInfo &Field : Sorted) {
+    if (&Field != Sorted.begin())
+      OrderOS << ", ";
+    OrderOS << '\'' << Field.FD->getName() << '\'';
+  }
+  OrderOS.flush();
+
+  Context.getDiagnostics().Report(RD->getLocation(),
+                                  diag::remark_padded_layout)
+      << getPaddingDiagFromTagKind(RD->getTagKind()) << Type << unsigned(Size)
+      << unsigned(Size - Start - FieldsSize) << (SortedSize < Size) << Order
+      << unsigned(SortedSize);
+}
+
 /// getASTRecordLayout - Get or compute information about the layout of the
 /// specified record (struct/union/class), which indicates its size and field
 /// position information.
@@ -2998,6 +3087,10 @@ ASTContext::getASTRecordLayout(const RecordDecl *D) const {
 
   ASTRecordLayouts[D] = NewEntry;
 
+  if (!getDiagnostics().isIgnored(diag::remark_padded_layout,
+                                  D->getLocation()))
+    diagnoseRecordLayout(*this, D, *NewEntry);
+
   if (getLangOpts().DumpRecordLayouts) {
     llvm::outs() << "\n*** Dumping AST Record Layout\n";
     DumpRecordLayout(D, llvm::outs(), getLangOpts().DumpRecordLayoutsSimple);
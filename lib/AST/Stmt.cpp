@@ -109,6 +109,23 @@ void Stmt::EnableStatistics() {
   StatisticsEnabled = true;
 }
 
+/// The context that the memory of statements created on this thread is
+/// attributed to by its memory report, if any.
+static LLVM_THREAD_LOCAL const ASTContext *StmtMemoryAccountingContext =
+    nullptr;
+
+bool Stmt::MemoryAccountingEnabled = false;
+void Stmt::setMemoryAccountingContext(const ASTContext *Ctx) {
+  StmtMemoryAccountingContext = Ctx;
+  if (Ctx)
+    MemoryAccountingEnabled = true;
+}
+
+void Stmt::noteConstructed(const Stmt *S) {
+  if (StmtMemoryAccountingContext)
+    StmtMemoryAccountingContext->noteNodeConstructed(S);
+}
+
 Stmt *Stmt::IgnoreImplicit() {
   Stmt *s = this;
 
@@ -11,6 +11,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
@@ -27,19 +28,27 @@
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticHandler.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/LTO/LTOBackend.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -55,9 +64,12 @@
 #include "llvm/Transforms/ObjCARC.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include <memory>
+#include <mutex>
 using namespace clang;
 using namespace llvm;
 
@@ -66,6 +78,45 @@ namespace {
 // Default filename used for profile generation.
 static constexpr StringLiteral DefaultProfileGenName = "default_%m.profraw";
 
+/// Forwards the diagnostics of a partition of the module, which is optimized
+/// in an LLVMContext of its own, to the context of the module, whose handler
+/// reports them and which writes the optimization record.
+class PartitionDiagnosticHandler final : public DiagnosticHandler {
+public:
+  PartitionDiagnosticHandler(LLVMContext &ModuleCtx, std::mutex &Lock)
+      : ModuleCtx(ModuleCtx), Lock(Lock) {}
+
+  bool handleDiagnostics(const DiagnosticInfo &DI) override {
+    // The partitions are optimized concurrently.
+    std::lock_guard<std::mutex> Guard(Lock);
+    ModuleCtx.diagnose(DI);
+    return true;
+  }
+
+  // Remarks that are only written to the optimization record are filtered
+  // out by the handler of the module's context.
+  bool isAnalysisRemarkEnabled(StringRef PassName) const override {
+    return ModuleCtx.getDiagnosticsOutputFile() ||
+           ModuleCtx.getDiagHandlerPtr()->isAnalysisRemarkEnabled(PassName);
+  }
+  bool isMissedOptRemarkEnabled(StringRef PassName) const override {
+    return ModuleCtx.getDiagnosticsOutputFile() ||
+           ModuleCtx.getDiagHandlerPtr()->isMissedOptRemarkEnabled(PassName);
+  }
+  bool isPassedOptRemarkEnabled(StringRef PassName) const override {
+    return ModuleCtx.getDiagnosticsOutputFile() ||
+           ModuleCtx.getDiagHandlerPtr()->isPassedOptRemarkEnabled(PassName);
+  }
+  bool isAnyRemarkEnabled() const override {
+    return ModuleCtx.getDiagnosticsOutputFile() ||
+           ModuleCtx.getDiagHandlerPtr()->isAnyRemarkEnabled();
+  }
+
+private:
+  LLVMContext &ModuleCtx;
+  std::mutex &Lock;
+};
+
 class EmitAssemblyHelper {
   DiagnosticsEngine &Diags;
   const HeaderSearchOptions &HSOpts;
@@ -103,6 +154,31 @@ class EmitAssemblyHelper {
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS);
 
+  /// Whether the optimization pipeline may be run separately over partitions
+  /// of the module when performing \p Action.
+  bool canPartitionModule(BackendAction Action) const;
+
+  /// Split the module into CodeGenOpts.CodeGenPartitions partitions, run the
+  /// optimization pipeline over them on up to CodeGenOpts.CodeGenThreads
+  /// threads, or one per core by default, and link the results back together
+  /// in the context of the module.
+  ///
+  /// \return The optimized module, or null if the partitions could not be
+  /// linked back together.
+  std::unique_ptr<Module> RunPartitionedOptimizationPipeline();
+
+  /// Add to \p Hash what, other than the bitcode of a partition, decides how
+  /// the optimization pipeline transforms it.
+  ///
+  /// \return False if that could not be determined, e.g. because a profile
+  /// could not be read, in which case the cache is not used.
+  bool hashCodeGenCacheOptions(MD5 &Hash) const;
+
+  /// Compute the name of the file in CodeGenOpts.CodeGenCachePath that holds
+  /// the optimized form of the partition whose bitcode is \p Bitcode, given
+  /// the hash \p OptionsHash of the options.
+  std::string getCodeGenCacheFile(MD5 OptionsHash, StringRef Bitcode) const;
+
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags,
                      const HeaderSearchOptions &HeaderSearchOpts,
@@ -614,6 +690,8 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
     InstrProfOptions Options;
     Options.NoRedZone = CodeGenOpts.DisableRedZone;
     Options.InstrProfileOutput = CodeGenOpts.InstrProfileOutput;
+    Options.DoCounterPromotion =
+        CodeGenOpts.getCoverageCounters() == CodeGenOptions::CoverageCountersFast;
     MPM.add(createInstrProfilingLegacyPass(Options));
   }
   if (CodeGenOpts.hasProfileIRInstr()) {
@@ -633,6 +711,25 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
   PMBuilder.populateModulePassManager(MPM);
 }
 
+static void
+runOptimizationPasses(Module &M, legacy::FunctionPassManager &PerFunctionPasses,
+                      legacy::PassManager &PerModulePasses) {
+  {
+    PrettyStackTraceString CrashInfo("Per-function optimization");
+
+    PerFunctionPasses.doInitialization();
+    for (Function &F : M)
+      if (!F.isDeclaration())
+        PerFunctionPasses.run(F);
+    PerFunctionPasses.doFinalization();
+  }
+
+  {
+    PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    PerModulePasses.run(M);
+  }
+}
+
 static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
   SmallVector<const char *, 16> BackendArgs;
   BackendArgs.push_back("clang"); // Fake program name.
@@ -702,6 +799,281 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+bool EmitAssemblyHelper::canPartitionModule(BackendAction Action) const {
+  if ((CodeGenOpts.CodeGenPartitions <= 1 &&
+       CodeGenOpts.CodeGenCachePath.empty()) ||
+      CodeGenOpts.DisableLLVMPasses)
+    return false;
+
+  // Machine code and bitcode for the LTO pre-link step may be produced from
+  // the relinked module, since the bitcode is optimized again at link time
+  // with the whole program in view; other IR output should reflect the module
+  // as a whole.
+  if (Action != Backend_EmitAssembly && Action != Backend_EmitObj &&
+      !(Action == Backend_EmitBC && CodeGenOpts.PrepareForLTO))
+    return false;
+
+  // Instrumentation passes emit per-module side files and constructors, which
+  // would be duplicated across the partitions.
+  if (CodeGenOpts.EmitGcovArcs || CodeGenOpts.EmitGcovNotes ||
+      CodeGenOpts.hasProfileClangInstr() || CodeGenOpts.hasProfileIRInstr() ||
+      !LangOpts.Sanitize.empty() || CodeGenOpts.SanitizeCoverageType ||
+      CodeGenOpts.SanitizeCoverageIndirectCalls ||
+      CodeGenOpts.SanitizeCoverageTraceCmp)
+    return false;
+
+  return true;
+}
+
+bool EmitAssemblyHelper::hashCodeGenCacheOptions(MD5 &Hash) const {
+  // The bitcode records the version of LLVM that wrote it, and the target
+  // features of each function. Add what else decides how the optimization
+  // pipeline transforms it.
+  Hash.update(getClangFullVersion());
+  Hash.update(TargetOpts.Triple);
+  Hash.update(TargetOpts.CPU);
+  Hash.update(TargetOpts.ABI);
+  for (const std::string &Feature : TargetOpts.Features)
+    Hash.update(Feature);
+  uint8_t Opts[] = {uint8_t(CodeGenOpts.OptimizationLevel),
+                    uint8_t(CodeGenOpts.OptimizeSize),
+                    uint8_t(CodeGenOpts.getInlining()),
+                    uint8_t(CodeGenOpts.UnrollLoops),
+                    uint8_t(CodeGenOpts.RerollLoops),
+                    uint8_t(CodeGenOpts.VectorizeLoop),
+                    uint8_t(CodeGenOpts.VectorizeSLP),
+                    uint8_t(CodeGenOpts.MergeFunctions),
+                    uint8_t(CodeGenOpts.SimplifyLibCalls),
+                    uint8_t(CodeGenOpts.PrepareForLTO),
+                    uint8_t(CodeGenOpts.EmitSummaryIndex),
+                    uint8_t(CodeGenOpts.getVecLib()),
+                    uint8_t(CodeGenOpts.DisableLifetimeMarkers),
+                    uint8_t(CodeGenOpts.DebugInfoForProfiling),
+                    uint8_t(LangOpts.ObjCAutoRefCount),
+                    uint8_t(LangOpts.CoroutinesTS)};
+  Hash.update(Opts);
+
+  // Options passed with -mllvm may change any of the passes. Hash each with
+  // its terminator, so that the boundaries between them are kept.
+  Hash.update(CodeGenOpts.LimitFloatPrecision);
+  for (const std::string &BackendOption : CodeGenOpts.BackendOptions)
+    Hash.update(StringRef(BackendOption.c_str(), BackendOption.size() + 1));
+
+  // The profiles and symbol rewrite maps read by the pipeline are identified
+  // by their contents, not by their names.
+  auto HashFile = [&](bool Used, StringRef Path) {
+    Hash.update(uint8_t(Used));
+    if (!Used)
+      return true;
+    auto Buffer = MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                        /*RequiresNullTerminator=*/false);
+    if (!Buffer)
+      return false;
+    Hash.update((*Buffer)->getBuffer());
+    return true;
+  };
+  if (!HashFile(CodeGenOpts.hasProfileIRUse(),
+                CodeGenOpts.ProfileInstrumentUsePath) ||
+      !HashFile(!CodeGenOpts.SampleProfileFile.empty(),
+                CodeGenOpts.SampleProfileFile))
+    return false;
+  for (const std::string &MapFile : CodeGenOpts.RewriteMapFiles)
+    if (!HashFile(/*Used=*/true, MapFile))
+      return false;
+  return true;
+}
+
+std::string EmitAssemblyHelper::getCodeGenCacheFile(MD5 OptionsHash,
+                                                    StringRef Bitcode) const {
+  OptionsHash.update(Bitcode);
+  MD5::MD5Result Digest;
+  OptionsHash.final(Digest);
+
+  // Name the files the way pruneCache expects.
+  SmallString<32> FileName("llvmcache-");
+  FileName += Digest.digest();
+  SmallString<128> Path(CodeGenOpts.CodeGenCachePath);
+  llvm::sys::path::append(Path, FileName);
+  return Path.str();
+}
+
+std::unique_ptr<Module>
+EmitAssemblyHelper::RunPartitionedOptimizationPipeline() {
+  unsigned NumPartitions = CodeGenOpts.CodeGenPartitions;
+  // Each thread has its own context and target machine, so by default there
+  // are no more of them than there are cores.
+  unsigned NumThreads = CodeGenOpts.CodeGenThreads
+                            ? CodeGenOpts.CodeGenThreads
+                            : std::max(1U, heavyweight_hardware_concurrency());
+  NumThreads = std::min(NumThreads, NumPartitions);
+  std::string ModuleID = TheModule->getModuleIdentifier();
+
+  // A linkonce definition may only be used from another partition, in which
+  // case the partition defining it would drop it as unused. Make such
+  // definitions weak until the partitions have been linked back together.
+  std::unique_ptr<Module> Clone = CloneModule(TheModule);
+  StringMap<GlobalValue::LinkageTypes> LinkOnceLinkages;
+  for (GlobalValue &GV : Clone->global_values()) {
+    if (GV.isDeclaration() || !GV.hasLinkOnceLinkage() || !GV.hasName() ||
+        GV.use_empty())
+      continue;
+    LinkOnceLinkages[GV.getName()] = GV.getLinkage();
+    GV.setLinkage(GV.hasLinkOnceODRLinkage() ? GlobalValue::WeakODRLinkage
+                                             : GlobalValue::WeakAnyLinkage);
+  }
+
+  // The partitions are optimized in their own LLVMContexts, so hand them over
+  // as bitcode.
+  std::vector<SmallString<0>> Partitions;
+  SplitModule(std::move(Clone), NumPartitions,
+              [&](std::unique_ptr<Module> MPart) {
+                // Partitions that do not own an appending global such as
+                // llvm.global_ctors are left with a declaration of it, which
+                // cannot be linked against the definition.
+                for (auto I = MPart->global_begin(), E = MPart->global_end();
+                     I != E;) {
+                  GlobalVariable &GV = *I++;
+                  if (GV.isDeclaration() && GV.use_empty())
+                    GV.eraseFromParent();
+                }
+                Partitions.emplace_back();
+                raw_svector_ostream BCOS(Partitions.back());
+                WriteBitcodeToFile(MPart.get(), BCOS);
+              },
+              /*PreserveLocals=*/true);
+
+  // Partitions that are unchanged since an earlier compilation are not
+  // optimized again; their optimized bitcode is read from the cache.
+  std::vector<SmallString<0>> Optimized(Partitions.size());
+  std::vector<std::string> CacheFiles;
+  unsigned NumCached = 0;
+  MD5 OptionsHash;
+  bool UseCache = !CodeGenOpts.CodeGenCachePath.empty() &&
+                  hashCodeGenCacheOptions(OptionsHash);
+  if (UseCache) {
+    for (unsigned I = 0, E = Partitions.size(); I != E; ++I) {
+      CacheFiles.push_back(getCodeGenCacheFile(OptionsHash, Partitions[I]));
+      auto Buffer = MemoryBuffer::getFile(CacheFiles.back(), /*FileSize=*/-1,
+                                          /*RequiresNullTerminator=*/false);
+      if (!Buffer)
+        continue;
+      Optimized[I] = (*Buffer)->getBuffer();
+      ++NumCached;
+    }
+  }
+
+  {
+    std::mutex DiagLock;
+    ThreadPool Pool(NumThreads);
+    for (unsigned I = 0, E = Partitions.size(); I != E; ++I) {
+      if (!Optimized[I].empty())
+        continue;
+      Pool.async([&, I] {
+        LLVMContext Ctx;
+        LLVMContext &ModuleCtx = TheModule->getContext();
+        Ctx.setDiagnosticHandler(
+            llvm::make_unique<PartitionDiagnosticHandler>(ModuleCtx, DiagLock));
+        Ctx.setDiagnosticsHotnessRequested(
+            ModuleCtx.getDiagnosticsHotnessRequested());
+        Ctx.setDiagnosticsHotnessThreshold(
+            ModuleCtx.getDiagnosticsHotnessThreshold());
+        Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+            MemoryBufferRef(Partitions[I].str(), ModuleID), Ctx);
+        if (!MOrErr) {
+          consumeError(MOrErr.takeError());
+          return;
+        }
+        Module &M = **MOrErr;
+
+        // Each partition needs its own TargetMachine, which caches subtargets
+        // and is not safe to share between threads.
+        EmitAssemblyHelper PartitionHelper(Diags, HSOpts, CodeGenOpts,
+                                           TargetOpts, LangOpts, &M);
+        PartitionHelper.CreateTargetMachine(/*MustCreateTM=*/false);
+        if (PartitionHelper.TM)
+          M.setDataLayout(PartitionHelper.TM->createDataLayout());
+
+        legacy::PassManager PerModulePasses;
+        PerModulePasses.add(createTargetTransformInfoWrapperPass(
+            PartitionHelper.getTargetIRAnalysis()));
+
+        legacy::FunctionPassManager PerFunctionPasses(&M);
+        PerFunctionPasses.add(createTargetTransformInfoWrapperPass(
+            PartitionHelper.getTargetIRAnalysis()));
+
+        PartitionHelper.CreatePasses(PerModulePasses, PerFunctionPasses);
+        runOptimizationPasses(M, PerFunctionPasses, PerModulePasses);
+
+        raw_svector_ostream BCOS(Optimized[I]);
+        WriteBitcodeToFile(&M, BCOS);
+      });
+    }
+    Pool.wait();
+  }
+
+  if (llvm::any_of(Optimized,
+                   [](const SmallString<0> &BC) { return BC.empty(); }))
+    return nullptr;
+
+  if (UseCache) {
+    Diags.Report(diag::remark_fe_codegen_cache)
+        << NumCached << unsigned(Partitions.size())
+        << CodeGenOpts.CodeGenCachePath;
+
+    // Write each new entry to a temporary file first, so that concurrent
+    // compilations never read one that is only partly written.
+    if (NumCached != Partitions.size() &&
+        !llvm::sys::fs::create_directories(CodeGenOpts.CodeGenCachePath)) {
+      for (unsigned I = 0, E = Partitions.size(); I != E; ++I) {
+        if (llvm::sys::fs::exists(CacheFiles[I]))
+          continue;
+        int FD;
+        SmallString<128> TempFile;
+        if (llvm::sys::fs::createUniqueFile(CacheFiles[I] + "-%%%%%%%%.tmp", FD,
+                                            TempFile))
+          continue;
+        {
+          raw_fd_ostream OS(FD, /*shouldClose=*/true);
+          OS << Optimized[I];
+        }
+        if (llvm::sys::fs::rename(TempFile, CacheFiles[I]))
+          llvm::sys::fs::remove(TempFile);
+      }
+    }
+    pruneCache(CodeGenOpts.CodeGenCachePath, CachePruningPolicy());
+  }
+
+  // Link the optimized partitions back into a single module, in the context
+  // whose diagnostic handler reports backend diagnostics.
+  auto Linked = llvm::make_unique<Module>(ModuleID, TheModule->getContext());
+  Linked->setDataLayout(TheModule->getDataLayout());
+  Linked->setTargetTriple(TheModule->getTargetTriple());
+  Linker L(*Linked);
+  for (const SmallString<0> &BC : Optimized) {
+    Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(BC.str(), ModuleID), TheModule->getContext());
+    if (!MOrErr) {
+      consumeError(MOrErr.takeError());
+      return nullptr;
+    }
+    if (L.linkInModule(std::move(*MOrErr)))
+      return nullptr;
+  }
+
+  for (const auto &Entry : LinkOnceLinkages)
+    if (GlobalValue *GV = Linked->getNamedValue(Entry.getKey()))
+      if (!GV->isDeclaration())
+        GV->setLinkage(Entry.getValue());
+
+  // Drop the linkonce definitions that are no longer used now that their
+  // users have been optimized.
+  legacy::PassManager CleanupPasses;
+  CleanupPasses.add(createGlobalDCEPass());
+  CleanupPasses.run(*Linked);
+
+  return Linked;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
@@ -718,6 +1090,12 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   if (TM)
     TheModule->setDataLayout(TM->createDataLayout());
 
+  // When the module is partitioned, code or bitcode is generated for the
+  // module linked back together from the optimized partitions.
+  std::unique_ptr<Module> PartitionedModule;
+  if (canPartitionModule(Action))
+    PartitionedModule = RunPartitionedOptimizationPipeline();
+
   legacy::PassManager PerModulePasses;
   PerModulePasses.add(
       createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
@@ -732,6 +1110,11 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   CodeGenPasses.add(
       createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
 
+  // The partitioned module has already been optimized, so its bitcode is
+  // written by the passes that run on it rather than by the per-module passes.
+  legacy::PassManager &WriterPasses =
+      PartitionedModule ? CodeGenPasses : PerModulePasses;
+
   std::unique_ptr<raw_fd_ostream> ThinLinkOS;
 
   switch (Action) {
@@ -751,11 +1134,11 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
           return;
         }
       }
-      PerModulePasses.add(
+      WriterPasses.add(
           createWriteThinLTOBitcodePass(*OS, ThinLinkOS.get()));
     }
     else
-      PerModulePasses.add(
+      WriterPasses.add(
           createBitcodeWriterPass(*OS, CodeGenOpts.EmitLLVMUseLists));
     break;
 
@@ -774,25 +1157,12 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   // Run passes. For now we do all passes at once, but eventually we
   // would like to have the option of streaming code generation.
-
-  {
-    PrettyStackTraceString CrashInfo("Per-function optimization");
-
-    PerFunctionPasses.doInitialization();
-    for (Function &F : *TheModule)
-      if (!F.isDeclaration())
-        PerFunctionPasses.run(F);
-    PerFunctionPasses.doFinalization();
-  }
-
-  {
-    PrettyStackTraceString CrashInfo("Per-module optimization passes");
-    PerModulePasses.run(*TheModule);
-  }
+  if (!PartitionedModule)
+    runOptimizationPasses(*TheModule, PerFunctionPasses, PerModulePasses);
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    CodeGenPasses.run(PartitionedModule ? *PartitionedModule : *TheModule);
   }
 }
 
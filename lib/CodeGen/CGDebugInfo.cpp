@@ -1861,8 +1861,31 @@ static bool hasExplicitMemberDefinition(CXXRecordDecl::method_iterator I,
   return false;
 }
 
+/// Return true if an object of the class can only be created by calling one of
+/// its constructors, so that its debug info can be emitted along with them.
+static bool canUseTypeHoming(const CXXRecordDecl *RD) {
+  // Microsoft debuggers don't resolve type information across DLL boundaries.
+  if (isClassOrMethodDLLImport(RD))
+    return false;
+
+  // Lambdas and aggregates are created without calling a constructor, and so
+  // can classes that are trivially or constant-expression constructible.
+  if (RD->isLambda() || RD->isAggregate() ||
+      RD->hasTrivialDefaultConstructor() ||
+      RD->hasConstexprNonCopyMoveConstructor())
+    return false;
+
+  // A class whose constructors are all deleted, except for copying and
+  // moving, never has one of them emitted.
+  for (const CXXConstructorDecl *Ctor : RD->ctors())
+    if (!Ctor->isCopyOrMoveConstructor() && !Ctor->isDeleted())
+      return true;
+  return false;
+}
+
 static bool shouldOmitDefinition(codegenoptions::DebugInfoKind DebugKind,
-                                 bool DebugTypeExtRefs, const RecordDecl *RD,
+                                 bool DebugTypeExtRefs, bool DebugTypeHoming,
+                                 const RecordDecl *RD,
                                  const LangOptions &LangOpts) {
   if (DebugTypeExtRefs && isDefinedInClangModule(RD->getDefinition()))
     return true;
@@ -1895,6 +1918,12 @@ static bool shouldOmitDefinition(codegenoptions::DebugInfoKind DebugKind,
       !isClassOrMethodDLLImport(CXXDecl))
     return true;
 
+  // With type homing, only emit complete debug info for a class that needs a
+  // constructor call when one of its constructors is emitted.
+  if (DebugTypeHoming && CXXDecl->hasDefinition() &&
+      canUseTypeHoming(CXXDecl->getDefinition()))
+    return true;
+
   TemplateSpecializationKind Spec = TSK_Undeclared;
   if (const auto *SD = dyn_cast<ClassTemplateSpecializationDecl>(RD))
     Spec = SD->getSpecializationKind();
@@ -1908,7 +1937,9 @@ static bool shouldOmitDefinition(codegenoptions::DebugInfoKind DebugKind,
 }
 
 void CGDebugInfo::completeRequiredType(const RecordDecl *RD) {
-  if (shouldOmitDefinition(DebugKind, DebugTypeExtRefs, RD, CGM.getLangOpts()))
+  if (shouldOmitDefinition(DebugKind, DebugTypeExtRefs,
+                           CGM.getCodeGenOpts().DebugTypeHoming, RD,
+                           CGM.getLangOpts()))
     return;
 
   QualType Ty = CGM.getContext().getRecordType(RD);
@@ -1920,7 +1951,8 @@ void CGDebugInfo::completeRequiredType(const RecordDecl *RD) {
 llvm::DIType *CGDebugInfo::CreateType(const RecordType *Ty) {
   RecordDecl *RD = Ty->getDecl();
   llvm::DIType *T = cast_or_null<llvm::DIType>(getTypeOrNull(QualType(Ty, 0)));
-  if (T || shouldOmitDefinition(DebugKind, DebugTypeExtRefs, RD,
+  if (T || shouldOmitDefinition(DebugKind, DebugTypeExtRefs,
+                                CGM.getCodeGenOpts().DebugTypeHoming, RD,
                                 CGM.getLangOpts())) {
     if (!T)
       T = getOrCreateRecordFwdDecl(Ty, getDeclContextDescriptor(RD));
@@ -3187,6 +3219,19 @@ void CGDebugInfo::EmitFunctionStart(GlobalDecl GD, SourceLocation Loc,
   const Decl *D = GD.getDecl();
   bool HasDecl = (D != nullptr);
 
+  // A class whose debug info is homed with its constructors is defined by the
+  // translation units that emit one, and retained even if nothing else there
+  // refers to it.
+  if (CGM.getCodeGenOpts().DebugTypeHoming &&
+      DebugKind > codegenoptions::DebugLineTablesOnly)
+    if (const auto *Ctor = dyn_cast_or_null<CXXConstructorDecl>(D))
+      if (!Ctor->getParent()->isDynamicClass() &&
+          canUseTypeHoming(Ctor->getParent())) {
+        completeClassData(Ctor->getParent());
+        RetainedTypes.push_back(
+            CGM.getContext().getRecordType(Ctor->getParent()).getAsOpaquePtr());
+      }
+
   llvm::DINode::DIFlags Flags = llvm::DINode::FlagZero;
   llvm::DIFile *Unit = getOrCreateFile(Loc);
   llvm::DIScope *FDContext = Unit;
@@ -4145,9 +4190,31 @@ void CGDebugInfo::finalize() {
     if (auto MD = TypeCache[RT])
       DBuilder.retainType(cast<llvm::DIType>(MD));
 
+  for (const auto &P : TypeCache) {
+    auto *CT = dyn_cast_or_null<llvm::DICompositeType>(P.second.get());
+    if (!CT || (CT->getTag() != llvm::dwarf::DW_TAG_structure_type &&
+                CT->getTag() != llvm::dwarf::DW_TAG_class_type &&
+                CT->getTag() != llvm::dwarf::DW_TAG_union_type))
+      continue;
+    if (CT->isForwardDecl()) {
+      ++NumRecordDeclarations;
+    } else {
+      ++NumRecordDefinitions;
+      NumRecordMembers += CT->getElements().size();
+    }
+  }
+
   DBuilder.finalize();
 }
 
+void CGDebugInfo::PrintStats() const {
+  llvm::errs() << "\n*** Debug Info Stats:\n";
+  llvm::errs() << "  " << NumRecordDefinitions << " record types defined, with "
+               << NumRecordMembers << " members\n";
+  llvm::errs() << "  " << NumRecordDeclarations
+               << " record types only declared\n";
+}
+
 void CGDebugInfo::EmitExplicitCastType(QualType Ty) {
   if (CGM.getCodeGenOpts().getDebugInfo() < codegenoptions::LimitedDebugInfo)
     return;
@@ -79,6 +79,12 @@ class CGDebugInfo {
   /// Cache of previously constructed Types.
   llvm::DenseMap<const void *, llvm::TrackingMDRef> TypeCache;
 
+  /// Counts of the record types in the finalized debug info, for
+  /// -print-stats.
+  unsigned NumRecordDefinitions = 0;
+  unsigned NumRecordDeclarations = 0;
+  unsigned NumRecordMembers = 0;
+
   llvm::SmallDenseMap<llvm::StringRef, llvm::StringRef> DebugPrefixMap;
 
   struct ObjCInterfaceCacheEntry {
@@ -309,6 +315,9 @@ public:
 
   void finalize();
 
+  /// Print the size of the debug info emitted for this module.
+  void PrintStats() const;
+
   /// Module debugging: Support for building PCMs.
   /// @{
   /// Set the main CU's DwoId field to \p Signature.
@@ -3318,6 +3318,20 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
         E->getExprLoc());
     EltBaseInfo = ArrayLV.getBaseInfo();
     EltTBAAInfo = CGM.getTBAAInfoForSubobject(ArrayLV, E->getType());
+
+    // An element of an array member is part of the enclosing struct. Describe
+    // the access relative to it, at the offset of the array, so that it does
+    // not alias the other members; each element shares the path of the first,
+    // so elements of the same array still alias each other. Character arrays
+    // are left alone, since they are commonly used as storage for objects of
+    // other types, and so are vectors, which are may-alias as members.
+    if (CGM.getCodeGenOpts().StructPathTBAAArrays &&
+        ArrayLV.getTBAAInfo().BaseType && EltTBAAInfo.AccessType &&
+        !EltTBAAInfo.isMayAlias() && !E->getType()->isVectorType() &&
+        EltTBAAInfo.AccessType != CGM.getTBAATypeInfo(getContext().CharTy)) {
+      EltTBAAInfo.BaseType = ArrayLV.getTBAAInfo().BaseType;
+      EltTBAAInfo.Offset = ArrayLV.getTBAAInfo().Offset;
+    }
   } else {
     // The base must be a pointer; emit it with an estimate of its alignment.
     Addr = EmitPointerWithAlignment(E->getBase(), &EltBaseInfo, &EltTBAAInfo);
@@ -15,6 +15,7 @@
 #include "CGDebugInfo.h"
 #include "CodeGenModule.h"
 #include "TargetInfo.h"
+#include "clang/AST/DeclTemplate.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/PrettyStackTrace.h"
@@ -915,6 +916,188 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S,
   EmitBlock(LoopExit.getBlock(), true);
 }
 
+namespace {
+/// What might make the iterations of a range-based for loop depend on each
+/// other, in the order of the remark_loop_hint_not_parallel selector.
+enum RangeForDependence {
+  RFD_Range,
+  RFD_Call,
+  RFD_Indirect,
+  RFD_OuterVariable,
+  RFD_Volatile,
+  RFD_Unanalyzed,
+  RFD_None
+};
+
+/// Finds what might make the iterations of a range-based for loop depend on
+/// each other, for -fderive-loop-hints.
+///
+/// Each iteration binds the loop variable to a distinct element of an array,
+/// 'std::array', or 'std::vector'. An iteration that accesses memory only
+/// through the loop variable and the variables it declares, and otherwise
+/// only reads the values of local variables declared outside of the loop,
+/// neither reads nor writes memory that another iteration writes.
+class RangeForDependenceFinder {
+public:
+  explicit RangeForDependenceFinder(const CXXForRangeStmt &S) : S(S) {}
+
+  /// Find the first dependence in the loop, or RFD_None. If the range has a
+  /// size known at compile time, set \p NumElements to it.
+  RangeForDependence find(Optional<uint64_t> &NumElements);
+
+private:
+  RangeForDependence checkRange(Optional<uint64_t> &NumElements);
+  RangeForDependence addVar(const VarDecl *VD);
+  RangeForDependence visit(const Stmt *St);
+
+  /// Whether \p E accesses the current element, as '*__begin'.
+  bool isElementAccess(const Expr *E) const;
+
+  const CXXForRangeStmt &S;
+
+  /// The variables declared by the loop, including the loop variable.
+  llvm::SmallPtrSet<const VarDecl *, 8> LoopVars;
+};
+} // end anonymous namespace
+
+RangeForDependence
+RangeForDependenceFinder::checkRange(Optional<uint64_t> &NumElements) {
+  QualType RangeTy = S.getRangeInit()->getType().getCanonicalType();
+  if (const auto *CAT = dyn_cast<ConstantArrayType>(RangeTy)) {
+    NumElements = CAT->getSize().getZExtValue();
+    return RFD_None;
+  }
+
+  // The iterators of the standard containers are trusted to be pointers to
+  // the elements, or thin wrappers around them.
+  const auto *Spec = dyn_cast_or_null<ClassTemplateSpecializationDecl>(
+      RangeTy->getAsCXXRecordDecl());
+  if (!Spec || !Spec->isInStdNamespace() || !Spec->getIdentifier())
+    return RFD_Range;
+  const TemplateArgumentList &Args = Spec->getTemplateArgs();
+  if (Spec->getName() == "array" && Args.size() == 2 &&
+      Args[1].getKind() == TemplateArgument::Integral) {
+    NumElements = Args[1].getAsIntegral().getZExtValue();
+    return RFD_None;
+  }
+  // The elements of 'std::vector<bool>' are bits, accessed through proxies.
+  if (Spec->getName() == "vector" && Args.size() >= 1 &&
+      Args[0].getKind() == TemplateArgument::Type &&
+      !Args[0].getAsType()->isBooleanType())
+    return RFD_None;
+  return RFD_Range;
+}
+
+RangeForDependence RangeForDependenceFinder::addVar(const VarDecl *VD) {
+  // A static local keeps its value from one iteration to the next.
+  if (!VD->hasLocalStorage())
+    return RFD_OuterVariable;
+  if (VD->getType().isVolatileQualified())
+    return RFD_Volatile;
+  if (const CXXRecordDecl *RD =
+          VD->getType()->getBaseElementTypeUnsafe()->getAsCXXRecordDecl())
+    if (RD->hasDefinition() && !RD->hasTrivialDestructor())
+      return RFD_Call;
+  LoopVars.insert(VD);
+  return RFD_None;
+}
+
+bool RangeForDependenceFinder::isElementAccess(const Expr *E) const {
+  const Expr *Iter = nullptr;
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() == UO_Deref)
+      Iter = UO->getSubExpr();
+  } else if (const auto *OCE = dyn_cast<CXXOperatorCallExpr>(E)) {
+    if (OCE->getOperator() == OO_Star && OCE->getNumArgs() == 1)
+      Iter = OCE->getArg(0);
+  }
+  if (!Iter || !S.getBeginStmt())
+    return false;
+  const auto *DRE = dyn_cast<DeclRefExpr>(Iter->IgnoreImpCasts());
+  return DRE && DRE->getDecl() == S.getBeginStmt()->getSingleDecl();
+}
+
+RangeForDependence RangeForDependenceFinder::visit(const Stmt *St) {
+  if (!St)
+    return RFD_None;
+
+  if (const auto *E = dyn_cast<Expr>(St)) {
+    if (E->getType().isVolatileQualified())
+      return RFD_Volatile;
+    if (isElementAccess(E))
+      return RFD_None;
+  }
+
+  if (const auto *DS = dyn_cast<DeclStmt>(St)) {
+    for (const Decl *D : DS->decls()) {
+      if (const auto *VD = dyn_cast<VarDecl>(D)) {
+        RangeForDependence Dep = addVar(VD);
+        if (Dep != RFD_None)
+          return Dep;
+      }
+    }
+  } else if (const auto *DRE = dyn_cast<DeclRefExpr>(St)) {
+    if (isa<BindingDecl>(DRE->getDecl()))
+      return RFD_Unanalyzed;
+    const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (VD && !LoopVars.count(VD))
+      return RFD_OuterVariable;
+  } else if (const auto *ICE = dyn_cast<ImplicitCastExpr>(St)) {
+    // Nothing in the loop writes a variable declared outside of it, so its
+    // value is the same in every iteration.
+    if (ICE->getCastKind() == CK_LValueToRValue)
+      if (const auto *DRE =
+              dyn_cast<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens()))
+        if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+          if (!LoopVars.count(VD) && VD->hasLocalStorage() &&
+              !VD->getType()->isReferenceType())
+            return RFD_None;
+  } else if (isa<CallExpr>(St) || isa<CXXNewExpr>(St) ||
+             isa<CXXDeleteExpr>(St) || isa<CXXBindTemporaryExpr>(St) ||
+             isa<ObjCMessageExpr>(St)) {
+    return RFD_Call;
+  } else if (const auto *CE = dyn_cast<CXXConstructExpr>(St)) {
+    if (!CE->getConstructor()->isTrivial())
+      return RFD_Call;
+  } else if (const auto *UO = dyn_cast<UnaryOperator>(St)) {
+    if (UO->getOpcode() == UO_Deref || UO->getOpcode() == UO_AddrOf)
+      return RFD_Indirect;
+  } else if (const auto *ME = dyn_cast<MemberExpr>(St)) {
+    if (ME->isArrow() || ME->getMemberDecl()->getType()->isReferenceType())
+      return RFD_Indirect;
+  } else if (isa<ArraySubscriptExpr>(St) || isa<ObjCIvarRefExpr>(St)) {
+    return RFD_Indirect;
+  } else if (isa<LambdaExpr>(St) || isa<BlockExpr>(St) || isa<AsmStmt>(St) ||
+             isa<CXXThrowExpr>(St) || isa<VAArgExpr>(St) ||
+             isa<AtomicExpr>(St) || isa<PseudoObjectExpr>(St) ||
+             isa<ArrayInitLoopExpr>(St) || isa<CXXDefaultArgExpr>(St) ||
+             isa<CXXDefaultInitExpr>(St) || isa<CoroutineSuspendExpr>(St) ||
+             isa<OMPExecutableDirective>(St)) {
+    // These hide subexpressions from children(), or have effects that the
+    // checks above don't account for.
+    return RFD_Unanalyzed;
+  }
+
+  for (const Stmt *Child : St->children()) {
+    RangeForDependence Dep = visit(Child);
+    if (Dep != RFD_None)
+      return Dep;
+  }
+  return RFD_None;
+}
+
+RangeForDependence
+RangeForDependenceFinder::find(Optional<uint64_t> &NumElements) {
+  if (S.getCoawaitLoc().isValid())
+    return RFD_Unanalyzed;
+  RangeForDependence Dep = checkRange(NumElements);
+  if (Dep == RFD_None)
+    Dep = visit(S.getLoopVarStmt());
+  if (Dep == RFD_None)
+    Dep = visit(S.getBody());
+  return Dep;
+}
+
 void
 CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S,
                                      ArrayRef<const Attr *> ForAttrs) {
@@ -933,6 +1116,22 @@ CodeGenFunction::EmitCXXForRangeStmt(const CXXForRangeStmt &S,
   llvm::BasicBlock *CondBlock = createBasicBlock("for.cond");
   EmitBlock(CondBlock);
 
+  if (CGM.getCodeGenOpts().DeriveLoopHints) {
+    Optional<uint64_t> NumElements;
+    RangeForDependence Dep = RangeForDependenceFinder(S).find(NumElements);
+    QualType RangeTy = S.getRangeInit()->getType();
+    if (Dep == RFD_None) {
+      LoopStack.setParallel();
+      // The trip count may not fit in a diagnostic's integer argument.
+      CGM.getDiags().Report(S.getForLoc(), diag::remark_loop_hint_parallel)
+          << RangeTy << NumElements.hasValue()
+          << llvm::utostr(NumElements.getValueOr(0));
+    } else {
+      CGM.getDiags().Report(S.getForLoc(), diag::remark_loop_hint_not_parallel)
+          << RangeTy << Dep;
+    }
+  }
+
   const SourceRange &R = S.getSourceRange();
   LoopStack.push(CondBlock, CGM.getContext(), ForAttrs,
                  SourceLocToDebugLoc(R.getBegin()),
@@ -705,6 +705,7 @@ CodeGenVTables::GenerateConstructionVTable(const CXXRecordDecl *RD,
   std::unique_ptr<VTableLayout> VTLayout(
       getItaniumVTableContext().createConstructionVTableLayout(
           Base.getBase(), Base.getBaseOffset(), BaseIsVirtual, RD));
+  ++NumConstructionVTables;
 
   // Add the address points.
   AddressPoints = VTLayout->getAddressPoints();
@@ -763,6 +764,15 @@ CodeGenModule::getVTableLinkage(const CXXRecordDecl *RD) {
   if (!RD->isExternallyVisible())
     return llvm::GlobalVariable::InternalLinkage;
 
+  // Only vtables that would otherwise be linkonce_odr have a home.
+  if (Optional<bool> Home = VTables.getVTableHome(RD)) {
+    if (*Home)
+      return llvm::GlobalVariable::WeakODRLinkage;
+    return shouldEmitAvailableExternallyVTable(*this, RD)
+               ? llvm::GlobalVariable::AvailableExternallyLinkage
+               : llvm::GlobalVariable::ExternalLinkage;
+  }
+
   // We're at the end of the translation unit, so the current key
   // function is fully correct.
   const CXXMethodDecl *keyFunction = Context.getCurrentKeyFunction(RD);
@@ -857,6 +867,13 @@ void CodeGenModule::EmitVTable(CXXRecordDecl *theClass) {
 
 void
 CodeGenVTables::GenerateClassData(const CXXRecordDecl *RD) {
+  // Sema asks for the data of a class whose key function is defined here, and
+  // so does the end of the translation unit if its vtable was used.
+  if (!ClassesWithData.insert(RD).second)
+    return;
+
+  llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+
   if (CGDebugInfo *DI = CGM.getModuleDebugInfo())
     DI->completeClassData(RD);
 
@@ -864,6 +881,43 @@ CodeGenVTables::GenerateClassData(const CXXRecordDecl *RD) {
     CGM.getCXXABI().emitVirtualInheritanceTables(RD);
 
   CGM.getCXXABI().emitVTableDefinitions(*this, RD);
+
+  ClassDataTime += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+  ClassDataTime -= Start;
+}
+
+Optional<bool> CodeGenVTables::getVTableHome(const CXXRecordDecl *RD) {
+  if (CGM.getCodeGenOpts().InstantiationHomesFile.empty() ||
+      CGM.getTarget().getCXXABI().isMicrosoft())
+    return None;
+
+  // A manifest written before the class gained a key function or an explicit
+  // instantiation must not override where those put the vtable.
+  TemplateSpecializationKind TSK = RD->getTemplateSpecializationKind();
+  if (TSK == TSK_ExplicitInstantiationDeclaration ||
+      TSK == TSK_ExplicitInstantiationDefinition ||
+      (TSK != TSK_ImplicitInstantiation &&
+       CGM.getContext().getCurrentKeyFunction(RD)))
+    return None;
+
+  SmallString<256> Name;
+  llvm::raw_svector_ostream Out(Name);
+  cast<ItaniumMangleContext>(CGM.getCXXABI().getMangleContext())
+      .mangleCXXVTable(RD, Out);
+  return CGM.getInstantiationHome(Name);
+}
+
+void CodeGenVTables::PrintStats() {
+  if (CGM.getTarget().getCXXABI().isMicrosoft())
+    return;
+  llvm::errs() << "\n*** VTable Stats:\n";
+  llvm::errs() << "  " << getItaniumVTableContext().getNumVTableLayouts()
+               << " vtable layouts computed\n";
+  llvm::errs() << "  " << ClassesWithData.size()
+               << " classes with vtables emitted, " << NumVTTs << " VTTs, "
+               << NumConstructionVTables << " construction vtables\n";
+  llvm::errs() << "  " << llvm::format("%.4f", ClassDataTime.getWallTime())
+               << " seconds emitting vtables\n";
 }
 
 /// At this point in the translation unit, does it appear that can we
@@ -890,6 +944,11 @@ bool CodeGenVTables::isVTableExternal(const CXXRecordDecl *RD) {
   if (TSK == TSK_ExplicitInstantiationDeclaration)
     return true;
 
+  // A vtable that every translation unit using it would define is only
+  // defined by the one that the -finstantiation-homes= manifest names.
+  if (Optional<bool> Home = getVTableHome(RD))
+    return !*Home;
+
   // Otherwise, if the class is an instantiated template, the
   // vtable must be defined here.
   if (TSK == TSK_ImplicitInstantiation ||
@@ -930,11 +989,17 @@ void CodeGenModule::EmitDeferredVTables() {
   size_t savedSize = DeferredVTables.size();
 #endif
 
-  for (const CXXRecordDecl *RD : DeferredVTables)
+  bool RecordHomes = (!CodeGenOpts.InstantiationHomesFile.empty() ||
+                      !CodeGenOpts.EmitInstantiationHomesFile.empty()) &&
+                     !getTarget().getCXXABI().isMicrosoft();
+  for (const CXXRecordDecl *RD : DeferredVTables) {
+    if (RecordHomes)
+      VTablesForHomes.push_back(RD);
     if (shouldEmitVTableAtEndOfTranslationUnit(*this, RD))
       VTables.GenerateClassData(RD);
     else if (shouldOpportunisticallyEmitVTables())
       OpportunisticVTables.push_back(RD);
+  }
 
   assert(savedSize == DeferredVTables.size() &&
          "deferred extra vtables during vtable emission?");
@@ -20,7 +20,9 @@
 #include "clang/AST/VTableBuilder.h"
 #include "clang/Basic/ABI.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/Support/Timer.h"
 
 namespace clang {
   class CXXRecordDecl;
@@ -57,6 +59,20 @@ class CodeGenVTables {
   /// Cache for the deleted virtual member call function.
   llvm::Constant *DeletedVirtualFn = nullptr;
 
+  /// The VTT of each class with virtual bases, by GetAddrOfVTT.
+  llvm::DenseMap<const CXXRecordDecl *, llvm::GlobalVariable *> VTTs;
+
+  /// The classes whose data GenerateClassData has emitted.
+  llvm::SmallPtrSet<const CXXRecordDecl *, 16> ClassesWithData;
+
+  /// The number of VTTs, and of the construction vtables they point to, that
+  /// were emitted.
+  unsigned NumVTTs = 0;
+  unsigned NumConstructionVTables = 0;
+
+  /// The time spent in GenerateClassData.
+  llvm::TimeRecord ClassDataTime;
+
   /// emitThunk - Emit a single thunk.
   void emitThunk(GlobalDecl GD, const ThunkInfo &Thunk, bool ForVTable);
 
@@ -123,6 +139,19 @@ public:
 
   bool isVTableExternal(const CXXRecordDecl *RD);
 
+  /// Look up the vtable of \p RD in the -finstantiation-homes= manifest.
+  ///
+  /// Only vtables that would otherwise be linkonce_odr are looked up: those of
+  /// implicit instantiations, and of classes without a key function that are
+  /// not explicitly instantiated.
+  ///
+  /// \returns true if this translation unit defines it, false if another one
+  /// does, or None if the manifest doesn't list it.
+  Optional<bool> getVTableHome(const CXXRecordDecl *RD);
+
+  /// Print statistics about vtable emission to stderr.
+  void PrintStats();
+
   /// Returns the type of a vtable with the given layout. Normally a struct of
   /// arrays of pointers, with one struct element for each vtable in the vtable
   /// group.
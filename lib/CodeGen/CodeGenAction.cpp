@@ -324,6 +324,10 @@ namespace clang {
       Gen->HandleVTable(RD);
     }
 
+    void PrintStats() override {
+      Gen->PrintStats();
+    }
+
     static void InlineAsmDiagHandler(const llvm::SMDiagnostic &SM,void *Context,
                                      unsigned LocCookie) {
       SourceLocation Loc = SourceLocation::getFromRawEncoding(LocCookie);
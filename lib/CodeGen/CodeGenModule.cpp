@@ -52,10 +52,15 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ProfileSummary.h"
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace CodeGen;
@@ -160,10 +165,24 @@ CodeGenModule::CodeGenModule(ASTContext &C, const HeaderSearchOptions &HSO,
         getDiags().Report(DiagID) << CodeGenOpts.ProfileInstrumentUsePath
                                   << EI.message();
       });
-    } else
+    } else {
       PGOReader = std::move(ReaderOrErr.get());
+
+      // Functions entered as often as the counts that make up 99% of the
+      // profile are hot, as in llvm::ProfileSummaryInfo.
+      for (const llvm::ProfileSummaryEntry &Entry :
+           PGOReader->getSummary().getDetailedSummary()) {
+        if (Entry.Cutoff >= 990000) {
+          PGOHotCountThreshold = std::max<uint64_t>(Entry.MinCount, 1);
+          break;
+        }
+      }
+    }
   }
 
+  if (!CodeGenOpts.InstantiationHomesFile.empty())
+    loadInstantiationHomes();
+
   // If coverage mapping generation is enabled, create the
   // CoverageMappingModuleGen object.
   if (CodeGenOpts.CoverageMapping)
@@ -412,6 +431,7 @@ void CodeGenModule::Release() {
       AddGlobalCtor(OpenMPRegistrationFunction, 0, ComdatKey);
     }
   if (PGOReader) {
+    orderFunctionsByProfile();
     getModule().setProfileSummary(PGOReader->getSummary().getMD(VMContext));
     if (PGOStats.hasDiagnostics())
       PGOStats.reportDiagnostics(getDiags(), getCodeGenOpts().MainFileName);
@@ -429,6 +449,9 @@ void CodeGenModule::Release() {
   }
   emitAtAvailableLinkGuard();
   emitLLVMUsed();
+  if (!CodeGenOpts.InstantiationHomesFile.empty() ||
+      !CodeGenOpts.EmitInstantiationHomesFile.empty())
+    recordInstantiationHomes();
   if (SanStats)
     SanStats->finish();
 
@@ -863,9 +886,178 @@ CodeGenModule::getFunctionLinkage(GlobalDecl GD) {
     return llvm::GlobalValue::InternalLinkage;
   }
 
+  // A function that the manifest assigns to another translation unit is only
+  // made available for inlining here, and one that it assigns to this
+  // translation unit is defined for the others to link against. EmitGlobal
+  // emits the latter even if it is not used.
+  if (Linkage == GVA_DiscardableODR)
+    if (Optional<bool> Home = getInstantiationHome(getMangledName(GD)))
+      Linkage = *Home ? GVA_StrongODR : GVA_AvailableExternally;
+
   return getLLVMLinkageForDeclarator(D, Linkage, /*isConstantVariable=*/false);
 }
 
+void CodeGenModule::orderFunctionsByProfile() {
+  SmallVector<llvm::Function *, 16> Hot, Cold;
+  for (llvm::Function &F : getModule()) {
+    if (F.isDeclaration())
+      continue;
+    auto EntryCount = F.getEntryCount();
+    if (!EntryCount)
+      continue;
+    if (*EntryCount >= PGOHotCountThreshold)
+      Hot.push_back(&F);
+    else if (*EntryCount == 0)
+      Cold.push_back(&F);
+  }
+
+  // The hottest functions come first.
+  std::stable_sort(Hot.begin(), Hot.end(),
+                   [](llvm::Function *LHS, llvm::Function *RHS) {
+                     return *LHS->getEntryCount() > *RHS->getEntryCount();
+                   });
+  auto &Functions = getModule().getFunctionList();
+  for (llvm::Function *F : llvm::reverse(Hot))
+    Functions.splice(Functions.begin(), Functions, F->getIterator());
+  for (llvm::Function *F : Cold)
+    Functions.splice(Functions.end(), Functions, F->getIterator());
+}
+
+/// Name a translation unit in instantiation home manifests by the real path of
+/// its source file, however it was named on the command line.
+static std::string getInstantiationHomeName(StringRef SourceFileName) {
+  SmallString<256> Path;
+  if (llvm::sys::fs::real_path(SourceFileName, Path)) {
+    Path = SourceFileName;
+    llvm::sys::fs::make_absolute(Path);
+    llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+  }
+  return Path.str();
+}
+
+void CodeGenModule::loadInstantiationHomes() {
+  auto BufferOrErr =
+      llvm::MemoryBuffer::getFile(CodeGenOpts.InstantiationHomesFile);
+  if (!BufferOrErr) {
+    unsigned DiagID = Diags.getCustomDiagID(
+        DiagnosticsEngine::Error, "could not read instantiation homes %0: %1");
+    getDiags().Report(DiagID) << CodeGenOpts.InstantiationHomesFile
+                              << BufferOrErr.getError().message();
+    return;
+  }
+
+  // Each line names a function and the translation unit that defines it. The
+  // manifest is the concatenation of the files written by
+  // -femit-instantiation-homes=, so the first translation unit that lists a
+  // function is its home.
+  std::string TU = getInstantiationHomeName(getModule().getSourceFileName());
+  SmallVector<StringRef, 0> Lines;
+  (*BufferOrErr)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                    /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    StringRef Name, Home;
+    std::tie(Name, Home) = Line.trim().split(' ');
+    if (!Name.empty())
+      InstantiationHomes.insert(std::make_pair(Name, Home.trim() == TU));
+  }
+}
+
+Optional<bool> CodeGenModule::getInstantiationHome(StringRef Name) const {
+  auto Home = InstantiationHomes.find(Name);
+  if (Home == InstantiationHomes.end())
+    return None;
+  return Home->second;
+}
+
+void CodeGenModule::recordInstantiationHomes() {
+  std::string TU = getInstantiationHomeName(getModule().getSourceFileName());
+  std::string Homes;
+  llvm::raw_string_ostream HomesOS(Homes);
+  auto Record = [&](const llvm::GlobalValue &GV, unsigned &NumHomedElsewhere,
+                    unsigned &NumHomedHere) {
+    if (Optional<bool> Home = getInstantiationHome(GV.getName())) {
+      if (!*Home) {
+        if (GV.isDeclaration() || GV.hasAvailableExternallyLinkage())
+          ++NumHomedElsewhere;
+        return;
+      }
+      if (GV.isDeclaration())
+        return;
+      ++NumHomedHere;
+    } else if (GV.isDeclaration() || !GV.hasLinkOnceODRLinkage()) {
+      return;
+    }
+    HomesOS << GV.getName() << ' ' << TU << '\n';
+  };
+  for (const llvm::Function &F : getModule())
+    Record(F, NumInstantiationsHomedElsewhere, NumInstantiationsHomedHere);
+  // The VTT and the type info of a class go where its vtable goes.
+  for (const CXXRecordDecl *RD : VTablesForHomes)
+    Record(*getCXXABI().getAddrOfVTable(RD, CharUnits()),
+           NumVTablesHomedElsewhere, NumVTablesHomedHere);
+  HomesOS.flush();
+
+  // The other translation units only declare what the manifest assigns to
+  // this one, so something it assigns here but that is no longer defined here,
+  // e.g. a template that is no longer instantiated, will be missing at link
+  // time.
+  unsigned NumMissing = 0;
+  StringRef FirstMissing;
+  for (const auto &Home : InstantiationHomes) {
+    if (!Home.getValue())
+      continue;
+    llvm::GlobalValue *GV = getModule().getNamedValue(Home.getKey());
+    if (GV && !GV->isDeclaration())
+      continue;
+    if (!NumMissing++ || Home.getKey() < FirstMissing)
+      FirstMissing = Home.getKey();
+  }
+  if (NumMissing) {
+    unsigned DiagID = Diags.getCustomDiagID(
+        DiagnosticsEngine::Warning,
+        "instantiation homes %0 are out of date: %1 symbols assigned to this "
+        "translation unit are not defined here, including '%2'");
+    getDiags().Report(DiagID) << CodeGenOpts.InstantiationHomesFile
+                              << NumMissing << FirstMissing;
+  }
+
+  if (CodeGenOpts.EmitInstantiationHomesFile.empty())
+    return;
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(CodeGenOpts.EmitInstantiationHomesFile, EC,
+                          llvm::sys::fs::F_Text);
+  if (EC) {
+    unsigned DiagID = Diags.getCustomDiagID(
+        DiagnosticsEngine::Error, "could not write instantiation homes %0: %1");
+    getDiags().Report(DiagID) << CodeGenOpts.EmitInstantiationHomesFile
+                              << EC.message();
+    return;
+  }
+  OS << Homes;
+}
+
+void CodeGenModule::PrintStats() {
+  if (!CodeGenOpts.InstantiationHomesFile.empty()) {
+    llvm::errs() << "\n*** Instantiation Home Stats:\n";
+    llvm::errs() << "  " << InstantiationHomes.size()
+                 << " symbols in the manifest\n";
+    llvm::errs() << "  " << NumInstantiationsHomedElsewhere
+                 << " functions left to the translation unit that defines "
+                    "them\n";
+    llvm::errs() << "  " << NumInstantiationsHomedHere
+                 << " functions defined for other translation units\n";
+    llvm::errs() << "  " << NumVTablesHomedElsewhere
+                 << " vtables left to the translation unit that defines "
+                    "them\n";
+    llvm::errs() << "  " << NumVTablesHomedHere
+                 << " vtables defined for other translation units\n";
+  }
+  if (getLangOpts().CPlusPlus)
+    VTables.PrintStats();
+  if (DebugInfo)
+    DebugInfo->PrintStats();
+}
+
 void CodeGenModule::setFunctionDLLStorageClass(GlobalDecl GD, llvm::Function *F) {
   const auto *FD = cast<FunctionDecl>(GD.getDecl());
 
@@ -960,6 +1152,12 @@ void CodeGenModule::SetLLVMFunctionAttributesForDefinition(const Decl *D,
   // starting with the default for this optimization level.
   bool ShouldAddOptNone =
       !CodeGenOpts.DisableO0ImplyOptNone && CodeGenOpts.OptimizationLevel == 0;
+  // With -fprofile-cold-optnone, functions that the profile shows never ran
+  // are not worth optimizing.
+  if (CodeGenOpts.ProfileColdOptNone) {
+    auto EntryCount = F->getEntryCount();
+    ShouldAddOptNone |= EntryCount && *EntryCount == 0;
+  }
   // We can't add optnone in the following cases, it won't pass the verifier.
   ShouldAddOptNone &= !D->hasAttr<MinSizeAttr>();
   ShouldAddOptNone &= !F->hasFnAttribute(llvm::Attribute::AlwaysInline);
@@ -1832,6 +2030,11 @@ void CodeGenModule::EmitGlobal(GlobalDecl GD) {
     // The value must be emitted, but cannot be emitted eagerly.
     assert(!MayBeEmittedEagerly(Global));
     addDeferredDeclToEmit(GD);
+  } else if (isa<FunctionDecl>(Global) && !InstantiationHomes.empty() &&
+             getInstantiationHome(MangledName).getValueOr(false)) {
+    // The manifest assigns the function to this translation unit, so the
+    // others rely on it being defined here.
+    addDeferredDeclToEmit(GD);
   } else {
     // Otherwise, remember that we saw a deferred decl with this name.  The
     // first use of the mangled name will cause it to move into
@@ -2730,6 +2933,10 @@ void CodeGenModule::maybeSetTrivialComdat(const Decl &D,
                                           llvm::GlobalObject &GO) {
   if (!shouldBeInCOMDAT(*this, D))
     return;
+  // Linkage can still differ from that of the declaration, with
+  // -finstantiation-homes=.
+  if (GO.hasAvailableExternallyLinkage())
+    return;
   GO.setComdat(TheModule.getOrInsertComdat(GO.getName()));
 }
 
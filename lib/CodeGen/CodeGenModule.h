@@ -300,6 +300,10 @@ private:
   llvm::MDNode *NoObjCARCExceptionsMetadata = nullptr;
   std::unique_ptr<llvm::IndexedInstrProfReader> PGOReader;
   InstrProfStats PGOStats;
+
+  /// The entry count from which a function is considered hot, according to
+  /// the summary of the instrumentation profile.
+  uint64_t PGOHotCountThreshold = UINT64_MAX;
   std::unique_ptr<llvm::SanitizerStatReport> SanStats;
 
   // A set of references that have only been seen via a weakref so far. This is
@@ -395,6 +399,28 @@ private:
   std::vector<llvm::Function *> CXXThreadLocalInits;
   std::vector<const VarDecl *> CXXThreadLocalInitVars;
 
+  /// The inline functions, template instantiations and vtables listed in the
+  /// -finstantiation-homes= manifest, mapped to whether this translation unit
+  /// is the one that defines them.
+  llvm::StringMap<bool> InstantiationHomes;
+
+  /// Functions that the manifest assigns to another translation unit, which
+  /// were left undefined or only made available for inlining.
+  unsigned NumInstantiationsHomedElsewhere = 0;
+
+  /// Functions that the manifest assigns to this translation unit, which
+  /// were defined for the others.
+  unsigned NumInstantiationsHomedHere = 0;
+
+  /// Vtables that the manifest assigns to another translation unit, and
+  /// to this one.
+  unsigned NumVTablesHomedElsewhere = 0;
+  unsigned NumVTablesHomedHere = 0;
+
+  /// The classes whose vtables were considered for emission at the end of the
+  /// translation unit, when the instantiation homes are recorded.
+  std::vector<const CXXRecordDecl *> VTablesForHomes;
+
   /// Global variables with initializers that need to run before main.
   std::vector<llvm::Function *> CXXGlobalInits;
 
@@ -515,6 +541,15 @@ public:
   /// Finalize LLVM code generation.
   void Release();
 
+  /// Print statistics about code generation to stderr.
+  void PrintStats();
+
+  /// Look up the symbol \p Name in the -finstantiation-homes= manifest.
+  ///
+  /// \returns true if this translation unit defines it, false if another one
+  /// does, or None if the manifest doesn't list it.
+  llvm::Optional<bool> getInstantiationHome(StringRef Name) const;
+
   /// Return true if we should emit location information for expressions.
   bool getExpressionLocationsEnabled() const;
 
@@ -556,6 +591,7 @@ public:
 
   InstrProfStats &getPGOStats() { return PGOStats; }
   llvm::IndexedInstrProfReader *getPGOReader() const { return PGOReader.get(); }
+  uint64_t getProfileHotCountThreshold() const { return PGOHotCountThreshold; }
 
   CoverageMappingModuleGen *getCoverageMapping() const {
     return CoverageMapping.get();
@@ -1350,6 +1386,18 @@ private:
   /// .gcda files in a way that persists in .bc files.
   void EmitCoverageFile();
 
+  /// Move the functions that the profile shows are hot to the start of the
+  /// module, and the ones that never ran to the end.
+  void orderFunctionsByProfile();
+
+  /// Read the manifest given with -finstantiation-homes=.
+  void loadInstantiationHomes();
+
+  /// Count the functions and vtables whose definitions the manifest decided,
+  /// and write the ones defined by this translation unit to the file given
+  /// with -femit-instantiation-homes=.
+  void recordInstantiationHomes();
+
   /// Emits the initializer for a uuidof string.
   llvm::Constant *EmitUuidofInitializer(StringRef uuidstr);
 
@@ -16,6 +16,7 @@
 #include "CoverageMappingGen.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/AST/StmtVisitor.h"
+#include "clang/Sema/SemaDiagnostic.h"
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/Support/Endian.h"
@@ -782,7 +783,7 @@ void CodeGenPGO::assignRegionCounters(GlobalDecl GD, llvm::Function *Fn) {
     SourceManager &SM = CGM.getContext().getSourceManager();
     loadRegionCounts(PGOReader, SM.isInMainFile(D->getLocation()));
     computeRegionCounts(D);
-    applyFunctionAttributes(PGOReader, Fn);
+    applyFunctionAttributes(D, PGOReader, Fn);
   }
 }
 
@@ -873,13 +874,39 @@ void CodeGenPGO::computeRegionCounts(const Decl *D) {
 }
 
 void
-CodeGenPGO::applyFunctionAttributes(llvm::IndexedInstrProfReader *PGOReader,
+CodeGenPGO::applyFunctionAttributes(const Decl *D,
+                                    llvm::IndexedInstrProfReader *PGOReader,
                                     llvm::Function *Fn) {
   if (!haveRegionCounts())
     return;
 
   uint64_t FunctionCount = getRegionCount(nullptr);
   Fn->setEntryCount(FunctionCount);
+
+  // Keep the hot functions and the ones that never run apart from the rest,
+  // so that the code that runs is packed together. CodeGenModule::Release
+  // orders them within the module the same way.
+  const auto *ND = dyn_cast<NamedDecl>(D);
+  if (FunctionCount >= CGM.getProfileHotCountThreshold()) {
+    Fn->setSectionPrefix(".hot");
+    if (ND)
+      CGM.getDiags().Report(D->getLocation(),
+                            diag::remark_profile_hot_function)
+          << ND << FunctionCount;
+  } else if (FunctionCount == 0) {
+    Fn->setSectionPrefix(".unlikely");
+    Fn->addFnAttr(llvm::Attribute::Cold);
+    // SetLLVMFunctionAttributesForDefinition makes the function optnone
+    // unless it has to be inlined or optimized for size.
+    bool OptNone = CGM.getCodeGenOpts().ProfileColdOptNone &&
+                   !D->hasAttr<MinSizeAttr>() &&
+                   !D->hasAttr<AlwaysInlineAttr>() &&
+                   !Fn->hasFnAttribute(llvm::Attribute::AlwaysInline);
+    if (ND)
+      CGM.getDiags().Report(D->getLocation(),
+                            diag::remark_profile_cold_function)
+          << ND << OptNone;
+  }
 }
 
 void CodeGenPGO::emitCounterIncrement(CGBuilderTy &Builder, const Stmt *S,
@@ -94,7 +94,8 @@ private:
   void setFuncName(StringRef Name, llvm::GlobalValue::LinkageTypes Linkage);
   void mapRegionCounters(const Decl *D);
   void computeRegionCounts(const Decl *D);
-  void applyFunctionAttributes(llvm::IndexedInstrProfReader *PGOReader,
+  void applyFunctionAttributes(const Decl *D,
+                               llvm::IndexedInstrProfReader *PGOReader,
                                llvm::Function *Fn);
   void loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
                         bool IsInMainFile);
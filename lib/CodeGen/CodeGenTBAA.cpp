@@ -276,6 +276,10 @@ llvm::MDNode *CodeGenTBAA::getBaseTypeInfo(QualType QTy) {
     for (RecordDecl::field_iterator i = RD->field_begin(),
          e = RD->field_end(); i != e; ++i, ++idx) {
       QualType FieldQTy = i->getType();
+      // Accesses to the elements of an array member are described as accesses
+      // to its first element; see EmitArraySubscriptExpr.
+      if (CodeGenOpts.StructPathTBAAArrays)
+        FieldQTy = Context.getBaseElementType(FieldQTy);
       llvm::MDNode *FieldNode = isValidBaseType(FieldQTy) ?
           getBaseTypeInfo(FieldQTy) : getTypeInfo(FieldQTy);
       if (!FieldNode)
@@ -281,6 +281,11 @@ namespace {
       Builder->RefreshTypeCacheForClass(RD);
     }
 
+    void PrintStats() override {
+      if (Builder)
+        Builder->PrintStats();
+    }
+
     void CompleteTentativeDefinition(VarDecl *D) override {
       if (Diags.hasErrorOccurred())
         return;
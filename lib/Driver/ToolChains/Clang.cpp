@@ -767,6 +767,13 @@ static void addPGOAndCoverageFlags(Compilation &C, const Driver &D,
     CmdArgs.push_back("-fcoverage-mapping");
   }
 
+  if (Arg *A = Args.getLastArg(options::OPT_fcoverage_counters_EQ)) {
+    if (!ProfileGenerateArg)
+      D.Diag(clang::diag::err_drv_argument_only_allowed_with)
+          << A->getAsString(Args) << "-fprofile-instr-generate";
+    A->render(Args, CmdArgs);
+  }
+
   if (C.getArgs().hasArg(options::OPT_c) ||
       C.getArgs().hasArg(options::OPT_S)) {
     if (Output.isFilename()) {
@@ -2554,6 +2561,10 @@ static void RenderModulesOptions(Compilation &C, const Driver &D,
   Args.AddAllArgs(CmdArgs, options::OPT_fmodules_ignore_macro);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_interval);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_prune_after);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_build_threads);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_cache_max_size);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_cache_dedup);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_cache_stats);
 
   Args.AddLastArg(CmdArgs, options::OPT_fbuild_session_timestamp);
 
@@ -2572,14 +2583,18 @@ static void RenderModulesOptions(Compilation &C, const Driver &D,
                                      .count())));
   }
 
-  if (Args.getLastArg(options::OPT_fmodules_validate_once_per_build_session)) {
-    if (!Args.getLastArg(options::OPT_fbuild_session_timestamp,
-                         options::OPT_fbuild_session_file))
-      D.Diag(diag::err_drv_modules_validate_once_requires_timestamp);
+  for (options::ID Opt : {options::OPT_fmodules_validate_once_per_build_session,
+                          options::OPT_fmodules_share_session_validation}) {
+    if (Arg *A = Args.getLastArg(Opt)) {
+      if (!Args.getLastArg(options::OPT_fbuild_session_timestamp,
+                           options::OPT_fbuild_session_file))
+        D.Diag(diag::err_drv_modules_validate_once_requires_timestamp)
+            << A->getSpelling();
 
-    Args.AddLastArg(CmdArgs,
-                    options::OPT_fmodules_validate_once_per_build_session);
+      A->render(Args, CmdArgs);
+    }
   }
+  Args.AddLastArg(CmdArgs, options::OPT_fvalidate_ast_input_files_content);
 
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_validate_system_headers);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_disable_diagnostic_validation);
@@ -2970,6 +2985,12 @@ static void RenderDebugOptions(const ToolChain &TC, const Driver &D,
     CmdArgs.push_back("-generate-type-units");
   }
 
+  // Type homing only changes limited debug info.
+  if (Args.hasFlag(options::OPT_fdebug_type_homing,
+                   options::OPT_fno_debug_type_homing, false) &&
+      DebugInfoKind == codegenoptions::LimitedDebugInfo)
+    CmdArgs.push_back("-fdebug-type-homing");
+
   // Decide how to render forward declarations of template instantiations.
   // SCE wants full descriptions, others just get them in the name.
   if (DebuggerTuning == llvm::DebuggerKind::SCE)
@@ -3292,6 +3313,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    options::OPT_fno_profile_sample_accurate, false))
     CmdArgs.push_back("-fprofile-sample-accurate");
 
+  if (Args.hasFlag(options::OPT_fprofile_cold_optnone,
+                   options::OPT_fno_profile_cold_optnone, false))
+    CmdArgs.push_back("-fprofile-cold-optnone");
+
   if (!Args.hasFlag(options::OPT_fpreserve_as_comments,
                     options::OPT_fno_preserve_as_comments, true))
     CmdArgs.push_back("-fno-preserve-as-comments");
@@ -3337,6 +3362,9 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   if (!Args.hasFlag(options::OPT_fstruct_path_tbaa,
                     options::OPT_fno_struct_path_tbaa))
     CmdArgs.push_back("-no-struct-path-tbaa");
+  if (Args.hasFlag(options::OPT_fstruct_path_tbaa_arrays,
+                   options::OPT_fno_struct_path_tbaa_arrays, false))
+    CmdArgs.push_back("-fstruct-path-tbaa-arrays");
   if (Args.hasFlag(options::OPT_fstrict_enums, options::OPT_fno_strict_enums,
                    false))
     CmdArgs.push_back("-fstrict-enums");
@@ -3548,6 +3576,9 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_finstrument_functions,
                   options::OPT_finstrument_functions_after_inlining);
 
+  Args.AddLastArg(CmdArgs, options::OPT_finstantiation_homes_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_femit_instantiation_homes_EQ);
+
   addPGOAndCoverageFlags(C, D, Output, Args, CmdArgs);
 
   if (auto *ABICompatArg = Args.getLastArg(options::OPT_fclang_abi_compat_EQ))
@@ -3789,6 +3820,11 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(A->getValue());
   }
 
+  if (Arg *A = Args.getLastArg(options::OPT_ftypo_correction_budget_EQ)) {
+    CmdArgs.push_back("-ftypo-correction-budget");
+    CmdArgs.push_back(A->getValue());
+  }
+
   // Pass -fmessage-length=.
   CmdArgs.push_back("-fmessage-length");
   if (Arg *A = Args.getLastArg(options::OPT_fmessage_length_EQ)) {
@@ -4297,6 +4333,12 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
                    options::OPT_fno_slp_vectorize, EnableSLPVec))
     CmdArgs.push_back("-vectorize-slp");
 
+  if (Args.hasFlag(options::OPT_fderive_loop_hints,
+                   options::OPT_fno_derive_loop_hints, false))
+    CmdArgs.push_back("-fderive-loop-hints");
+
+  Args.AddLastArg(CmdArgs, options::OPT_fcodegen_threads_EQ);
+
   if (Arg *A = Args.getLastArg(options::OPT_fshow_overloads_EQ))
     A->render(Args, CmdArgs);
 
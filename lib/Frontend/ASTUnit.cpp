@@ -31,6 +31,7 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Parse/Parser.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
@@ -2197,6 +2198,14 @@ void ASTUnit::CodeComplete(
   }
 }
 
+bool ASTUnit::parseSkippedFunctionBody(FunctionDecl *FD) {
+  if (!TheSema || !PP)
+    return false;
+
+  Parser P(*PP, *TheSema, /*SkipFunctionBodies=*/false);
+  return P.ParseSkippedFunctionBody(FD);
+}
+
 bool ASTUnit::Save(StringRef File) {
   if (HadModuleLoaderFatalFailure)
     return true;
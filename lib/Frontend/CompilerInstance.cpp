@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Frontend/CompilerInstance.h"
+#include "ModuleBuildScheduler.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
@@ -488,6 +489,8 @@ void CompilerInstance::createASTContext() {
   auto *Context = new ASTContext(getLangOpts(), PP.getSourceManager(),
                                  PP.getIdentifierTable(), PP.getSelectorTable(),
                                  PP.getBuiltinInfo());
+  if (getFrontendOpts().ASTMemoryReport != FrontendOptions::AMR_None)
+    Context->enableMemoryAccounting();
   Context->InitBuiltinTypes(getTarget(), getAuxTarget());
   setASTContext(Context);
 }
@@ -1026,8 +1029,16 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
       getFileManager().PrintStats();
       OS << '\n';
     }
+    if (!CacheStats.empty()) {
+      OS << "*** Module Cache Stats:\n";
+      CacheStats.print(OS);
+      OS << '\n';
+    }
     llvm::PrintStatistics(OS);
   }
+  if (getHeaderSearchOpts().ModulesCacheStats && !CacheStats.empty() &&
+      !getHeaderSearchOpts().ModuleCachePath.empty())
+    recordModuleCacheStats(getHeaderSearchOpts().ModuleCachePath, CacheStats);
   StringRef StatsFile = getFrontendOpts().StatsFile;
   if (!StatsFile.empty()) {
     std::error_code EC;
@@ -1056,18 +1067,13 @@ static InputKind::Language getLanguageFromOptions(const LangOptions &LangOpts) {
   return LangOpts.CPlusPlus ? InputKind::CXX : InputKind::C;
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance. Returns true if the module
-/// was built without errors.
-static bool
-compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
-                  StringRef ModuleName, FrontendInputFile Input,
-                  StringRef OriginalModuleMapFile, StringRef ModuleFileName,
-                  llvm::function_ref<void(CompilerInstance &)> PreBuildStep =
-                      [](CompilerInstance &) {},
-                  llvm::function_ref<void(CompilerInstance &)> PostBuildStep =
-                      [](CompilerInstance &) {}) {
-  // Construct a compiler invocation for creating this module.
+/// \brief Create the compiler invocation for building the given module,
+/// from the options of the importing compiler instance.
+static std::shared_ptr<CompilerInvocation>
+createModuleInvocation(CompilerInstance &ImportingInstance,
+                       StringRef ModuleName, FrontendInputFile Input,
+                       StringRef OriginalModuleMapFile,
+                       StringRef ModuleFileName) {
   auto Invocation =
       std::make_shared<CompilerInvocation>(ImportingInstance.getInvocation());
 
@@ -1093,16 +1099,6 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // Note the name of the module we're building.
   Invocation->getLangOpts()->CurrentModule = ModuleName;
 
-  // Make sure that the failed-module structure has been allocated in
-  // the importing instance, and propagate the pointer to the newly-created
-  // instance.
-  PreprocessorOptions &ImportingPPOpts
-    = ImportingInstance.getInvocation().getPreprocessorOpts();
-  if (!ImportingPPOpts.FailedModules)
-    ImportingPPOpts.FailedModules =
-        std::make_shared<PreprocessorOptions::FailedModulesSet>();
-  PPOpts.FailedModules = ImportingPPOpts.FailedModules;
-
   // If there is a module map file, build the module using the module map.
   // Set up the inputs/outputs so that we build the module from its umbrella
   // header.
@@ -1112,6 +1108,8 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   FrontendOpts.GenerateGlobalModuleIndex = false;
   FrontendOpts.BuildingImplicitModule = true;
   FrontendOpts.OriginalModuleMap = OriginalModuleMapFile;
+  // The importer's memory report only covers its own AST.
+  FrontendOpts.ASTMemoryReport = FrontendOptions::AMR_None;
   // Force implicitly-built modules to hash the content of the module file.
   HSOpts.ModulesHashContent = true;
   FrontendOpts.Inputs = {Input};
@@ -1122,14 +1120,45 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
   assert(ImportingInstance.getInvocation().getModuleHash() ==
          Invocation->getModuleHash() && "Module hash mismatch!");
-  
+
+  // We don't want to produce any dependency output from the module build.
+  Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+  return Invocation;
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance. Returns true if the module
+/// was built without errors.
+static bool
+compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
+                  StringRef ModuleName, FrontendInputFile Input,
+                  StringRef OriginalModuleMapFile, StringRef ModuleFileName,
+                  llvm::function_ref<void(CompilerInstance &)> PreBuildStep =
+                      [](CompilerInstance &) {},
+                  llvm::function_ref<void(CompilerInstance &)> PostBuildStep =
+                      [](CompilerInstance &) {}) {
+  // Construct a compiler invocation for creating this module.
+  auto Invocation = createModuleInvocation(ImportingInstance, ModuleName, Input,
+                                           OriginalModuleMapFile,
+                                           ModuleFileName);
+
+  // Make sure that the failed-module structure has been allocated in
+  // the importing instance, and propagate the pointer to the newly-created
+  // instance.
+  PreprocessorOptions &ImportingPPOpts
+    = ImportingInstance.getInvocation().getPreprocessorOpts();
+  if (!ImportingPPOpts.FailedModules)
+    ImportingPPOpts.FailedModules =
+        std::make_shared<PreprocessorOptions::FailedModulesSet>();
+  Invocation->getPreprocessorOpts().FailedModules =
+      ImportingPPOpts.FailedModules;
+
   // Construct a compiler instance that will be used to actually create the
   // module.  Since we're sharing a PCMCache,
   // CompilerInstance::CompilerInstance is responsible for finalizing the
   // buffers to prevent use-after-frees.
   CompilerInstance Instance(ImportingInstance.getPCHContainerOperations(),
                             &ImportingInstance.getPreprocessor().getPCMCache());
-  auto &Inv = *Invocation;
   Instance.setInvocation(std::move(Invocation));
 
   Instance.createDiagnostics(new ForwardingDiagnosticConsumer(
@@ -1149,10 +1178,8 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
     FullSourceLoc(ImportLoc, ImportingInstance.getSourceManager()));
 
   // If we're collecting module dependencies, we need to share a collector
-  // between all of the module CompilerInstances. Other than that, we don't
-  // want to produce any dependency output from the module build.
+  // between all of the module CompilerInstances.
   Instance.setModuleDepCollector(ImportingInstance.getModuleDepCollector());
-  Inv.getDependencyOutputOpts() = DependencyOutputOptions();
 
   ImportingInstance.getDiagnostics().Report(ImportLoc,
                                             diag::remark_module_build)
@@ -1186,6 +1213,48 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   return !Instance.getDiagnostics().hasErrorOccurred();
 }
 
+/// \brief Determine the module map to build the given module from. If there
+/// is none because the module was inferred, returns a made-up file name and
+/// sets \p InferredModuleMapContent to the contents that the file should have.
+static FrontendInputFile getModuleMapInput(CompilerInstance &ImportingInstance,
+                                           Module *Module,
+                                           std::string &InferredModuleMapContent) {
+  InputKind IK(getLanguageFromOptions(ImportingInstance.getLangOpts()),
+               InputKind::ModuleMap);
+
+  // Use the module map where this module resides.
+  ModuleMap &ModMap
+    = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
+  if (const FileEntry *ModuleMapFile =
+          ModMap.getContainingModuleMapFile(Module))
+    return FrontendInputFile(ModuleMapFile->getName(), IK, +Module->IsSystem);
+
+  // FIXME: We only need to fake up an input file here as a way of
+  // transporting the module's directory to the module map parser. We should
+  // be able to do that more directly, and parse from a memory buffer without
+  // inventing this file.
+  SmallString<128> FakeModuleMapFile(Module->Directory->getName());
+  llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
+
+  llvm::raw_string_ostream OS(InferredModuleMapContent);
+  Module->print(OS);
+  OS.flush();
+  return FrontendInputFile(FakeModuleMapFile, IK, +Module->IsSystem);
+}
+
+/// \brief Make \p Instance read \p Content for the inferred module map
+/// \p Input.
+static void overrideInferredModuleMap(CompilerInstance &Instance,
+                                      const FrontendInputFile &Input,
+                                      StringRef Content) {
+  std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
+      llvm::MemoryBuffer::getMemBuffer(Content);
+  const FileEntry *ModuleMapFile = Instance.getFileManager().getVirtualFile(
+      Input.getFile(), Content.size(), 0);
+  Instance.getSourceManager().overrideFileContents(ModuleMapFile,
+                                                   std::move(ModuleMapBuffer));
+}
+
 /// \brief Compile a module file for the given module, using the options 
 /// provided by the importing compiler instance. Returns true if the module
 /// was built without errors.
@@ -1193,48 +1262,19 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
                               SourceLocation ImportLoc,
                               Module *Module,
                               StringRef ModuleFileName) {
-  InputKind IK(getLanguageFromOptions(ImportingInstance.getLangOpts()),
-               InputKind::ModuleMap);
-
   // Get or create the module map that we'll use to build this module.
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
-  bool Result;
-  if (const FileEntry *ModuleMapFile =
-          ModMap.getContainingModuleMapFile(Module)) {
-    // Use the module map where this module resides.
-    Result = compileModuleImpl(
-        ImportingInstance, ImportLoc, Module->getTopLevelModuleName(),
-        FrontendInputFile(ModuleMapFile->getName(), IK, +Module->IsSystem),
-        ModMap.getModuleMapFileForUniquing(Module)->getName(),
-        ModuleFileName);
-  } else {
-    // FIXME: We only need to fake up an input file here as a way of
-    // transporting the module's directory to the module map parser. We should
-    // be able to do that more directly, and parse from a memory buffer without
-    // inventing this file.
-    SmallString<128> FakeModuleMapFile(Module->Directory->getName());
-    llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
-
-    std::string InferredModuleMapContent;
-    llvm::raw_string_ostream OS(InferredModuleMapContent);
-    Module->print(OS);
-    OS.flush();
-
-    Result = compileModuleImpl(
-        ImportingInstance, ImportLoc, Module->getTopLevelModuleName(),
-        FrontendInputFile(FakeModuleMapFile, IK, +Module->IsSystem),
-        ModMap.getModuleMapFileForUniquing(Module)->getName(),
-        ModuleFileName,
-        [&](CompilerInstance &Instance) {
-      std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
-          llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
-      ModuleMapFile = Instance.getFileManager().getVirtualFile(
-          FakeModuleMapFile, InferredModuleMapContent.size(), 0);
-      Instance.getSourceManager().overrideFileContents(
-          ModuleMapFile, std::move(ModuleMapBuffer));
-    });
-  }
+  std::string InferredModuleMapContent;
+  FrontendInputFile Input =
+      getModuleMapInput(ImportingInstance, Module, InferredModuleMapContent);
+  bool Result = compileModuleImpl(
+      ImportingInstance, ImportLoc, Module->getTopLevelModuleName(), Input,
+      ModMap.getModuleMapFileForUniquing(Module)->getName(), ModuleFileName,
+      [&](CompilerInstance &Instance) {
+    if (!InferredModuleMapContent.empty())
+      overrideInferredModuleMap(Instance, Input, InferredModuleMapContent);
+  });
 
   // We've rebuilt a module. If we're allowed to generate or update the global
   // module index, record that fact in the importing compiler instance.
@@ -1245,6 +1285,27 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   return Result;
 }
 
+/// \brief Store the module file that was just built by content, if requested,
+/// and count the outcome.
+static void storeModuleFile(CompilerInstance &ImportingInstance,
+                            StringRef ModuleFileName) {
+  const HeaderSearchOptions &HSOpts = ImportingInstance.getHeaderSearchOpts();
+  if (!HSOpts.ModulesCacheDedup)
+    return;
+
+  ModuleCacheStats &Stats = ImportingInstance.getModuleCacheStats();
+  switch (storeModuleFileByContent(HSOpts.ModuleCachePath, ModuleFileName)) {
+  case ModuleFileStoreResult::Stored:
+    ++Stats.Stored;
+    break;
+  case ModuleFileStoreResult::Deduplicated:
+    ++Stats.Deduplicated;
+    break;
+  case ModuleFileStoreResult::Failed:
+    break;
+  }
+}
+
 static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
                                  SourceLocation ImportLoc,
                                  SourceLocation ModuleNameLoc, Module *Module,
@@ -1281,6 +1342,7 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
         diagnoseBuildFailure();
         return false;
       }
+      storeModuleFile(ImportingInstance, ModuleFileName);
       break;
 
     case llvm::LockFileManager::LFS_Shared:
@@ -1328,6 +1390,215 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
   }
 }
 
+namespace {
+/// \brief Keeps the diagnostics of a scheduled module build, for its importer
+/// to report once the build is done.
+class StoringDiagnosticConsumer : public DiagnosticConsumer {
+  std::vector<StoredDiagnostic> &Stored;
+
+public:
+  explicit StoringDiagnosticConsumer(std::vector<StoredDiagnostic> &Stored)
+      : Stored(Stored) {}
+
+  void HandleDiagnostic(DiagnosticsEngine::Level Level,
+                        const Diagnostic &Info) override {
+    DiagnosticConsumer::HandleDiagnostic(Level, Info);
+    Stored.emplace_back(Level, Info);
+  }
+};
+
+/// \brief A module build started by compileModuleDependencies.
+struct ScheduledModuleBuild {
+  std::shared_ptr<CompilerInvocation> Invocation;
+  std::string ModuleName;
+  std::string InferredModuleMapContent;
+
+  /// Whether this build compiled the module, rather than finding it written
+  /// by another process or thread.
+  bool Compiled = false;
+
+  /// The diagnostics produced by the build, in order.
+  std::vector<StoredDiagnostic> Diagnostics;
+
+  /// The build's diagnostics engine and managers, which the locations of its
+  /// diagnostics refer to.
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags;
+  IntrusiveRefCntPtr<FileManager> FileMgr;
+  IntrusiveRefCntPtr<SourceManager> SourceMgr;
+
+  /// The outcome of storing the module file by content.
+  ModuleFileStoreResult StoreResult = ModuleFileStoreResult::Failed;
+};
+} // end anonymous namespace
+
+/// \brief Build a module scheduled by compileModuleDependencies, on one of the
+/// scheduler's threads. Other than the file system, the build shares nothing
+/// with the importing compiler instance: it has its own file manager and
+/// module file cache, and its diagnostics are only stored, for the importer
+/// to report. Returns true if the module file was written, by this build or by
+/// another one.
+static bool
+compileScheduledModule(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                       IntrusiveRefCntPtr<vfs::FileSystem> VFS,
+                       ArrayRef<std::string> BuildStack,
+                       ScheduledModuleBuild &Build) {
+  std::string ModuleFileName = Build.Invocation->getFrontendOpts().OutputFile;
+
+  // Don't race another process that is building the same module. If locking
+  // fails, leave the module to its importer, which knows how to handle that.
+  llvm::LockFileManager Locked(ModuleFileName);
+  switch (Locked) {
+  case llvm::LockFileManager::LFS_Error:
+    return false;
+  case llvm::LockFileManager::LFS_Shared:
+    return Locked.waitForUnlock() == llvm::LockFileManager::Res_Success &&
+           llvm::sys::fs::exists(ModuleFileName);
+  case llvm::LockFileManager::LFS_Owned:
+    // The module might have been written before we got the lock.
+    if (llvm::sys::fs::exists(ModuleFileName))
+      return true;
+    break;
+  }
+
+  CompilerInstance Instance(std::move(PCHContainerOps));
+  Instance.setInvocation(Build.Invocation);
+  Instance.createDiagnostics(new StoringDiagnosticConsumer(Build.Diagnostics),
+                             /*ShouldOwnClient=*/true);
+  Instance.setVirtualFileSystem(VFS);
+  Instance.createFileManager();
+  Instance.createSourceManager(Instance.getFileManager());
+  Build.Diags = &Instance.getDiagnostics();
+  Build.FileMgr = &Instance.getFileManager();
+  Build.SourceMgr = &Instance.getSourceManager();
+  Build.Compiled = true;
+
+  // Import locations belong to the importer's source manager, so only the
+  // names are kept; they are enough to detect cycles.
+  SourceManager &SourceMgr = Instance.getSourceManager();
+  for (const std::string &Name : BuildStack)
+    SourceMgr.pushModuleBuildStack(Name, FullSourceLoc());
+  SourceMgr.pushModuleBuildStack(Build.ModuleName, FullSourceLoc());
+
+  if (!Build.InferredModuleMapContent.empty())
+    overrideInferredModuleMap(Instance,
+                              Build.Invocation->getFrontendOpts().Inputs[0],
+                              Build.InferredModuleMapContent);
+
+  // Use a separate thread so that we get a stack large enough.
+  const unsigned ThreadStackSize = 8 << 20;
+  llvm::CrashRecoveryContext CRC;
+  CRC.RunSafelyOnThread(
+      [&]() {
+        GenerateModuleFromModuleMapAction Action;
+        Instance.ExecuteAction(Action);
+      },
+      ThreadStackSize);
+
+  Instance.clearOutputFiles(/*EraseFiles=*/true);
+  if (Instance.getDiagnostics().hasErrorOccurred())
+    return false;
+
+  const HeaderSearchOptions &HSOpts = Build.Invocation->getHeaderSearchOpts();
+  if (HSOpts.ModulesCacheDedup)
+    Build.StoreResult =
+        storeModuleFileByContent(HSOpts.ModuleCachePath, ModuleFileName);
+  return true;
+}
+
+/// \brief Build the modules that \p Module depends on and that are missing
+/// from the module cache, concurrently, before \p Module itself is built.
+///
+/// Failed builds are not diagnosed here. The modules that failed are built
+/// again, and their errors diagnosed, when they are imported.
+static void compileModuleDependencies(CompilerInstance &ImportingInstance,
+                                      SourceLocation ImportLoc,
+                                      Module *Module) {
+  HeaderSearch &HS = ImportingInstance.getPreprocessor().getHeaderSearchInfo();
+  ModuleBuildScheduler Scheduler(HS, ImportingInstance.getFileManager());
+
+  // Importing a module that is being built is a cycle, which is diagnosed
+  // when it is imported.
+  SmallVector<std::string, 4> BuildStack;
+  for (const auto &Entry :
+       ImportingInstance.getSourceManager().getModuleBuildStack()) {
+    BuildStack.push_back(Entry.first);
+    if (clang::Module *M = HS.lookupModule(Entry.first, /*AllowSearch=*/false))
+      Scheduler.excludeModule(M);
+  }
+  Scheduler.addDependenciesOf(Module);
+  ArrayRef<ModuleBuildScheduler::Job> Jobs = Scheduler.jobs();
+  if (Jobs.empty())
+    return;
+
+  // Everything the builds need from the importing instance is computed here,
+  // so that they don't touch it.
+  ModuleMap &ModMap = HS.getModuleMap();
+  std::vector<ScheduledModuleBuild> Builds(Jobs.size());
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I) {
+    ScheduledModuleBuild &Build = Builds[I];
+    Build.ModuleName = Jobs[I].M->getTopLevelModuleName();
+    Build.Invocation = createModuleInvocation(
+        ImportingInstance, Build.ModuleName,
+        getModuleMapInput(ImportingInstance, Jobs[I].M,
+                          Build.InferredModuleMapContent),
+        ModMap.getModuleMapFileForUniquing(Jobs[I].M)->getName(),
+        Jobs[I].ModuleFileName);
+    Build.Invocation->getPreprocessorOpts().FailedModules =
+        std::make_shared<PreprocessorOptions::FailedModulesSet>();
+    // The modules these builds import are built on demand, so that the number
+    // of threads stays bounded.
+    Build.Invocation->getHeaderSearchOpts().ModuleBuildThreads = 0;
+  }
+
+  llvm::sys::fs::create_directories(
+      llvm::sys::path::parent_path(Jobs.front().ModuleFileName));
+
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps =
+      ImportingInstance.getPCHContainerOperations();
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS =
+      &ImportingInstance.getVirtualFileSystem();
+  std::vector<bool> Built = Scheduler.run(
+      ImportingInstance.getHeaderSearchOpts().ModuleBuildThreads,
+      [&](unsigned I) {
+        return compileScheduledModule(PCHContainerOps, VFS, BuildStack,
+                                      Builds[I]);
+      });
+
+  DiagnosticsEngine &Diags = ImportingInstance.getDiagnostics();
+  ModuleCacheStats &Stats = ImportingInstance.getModuleCacheStats();
+  bool BuiltAny = false;
+  for (unsigned I = 0, N = Builds.size(); I != N; ++I) {
+    if (!Built[I])
+      continue;
+    BuiltAny = true;
+    // A module written by someone else was not built here, and the builder
+    // reports its diagnostics.
+    if (!Builds[I].Compiled)
+      continue;
+    ++Stats.Scheduled;
+    if (Builds[I].StoreResult == ModuleFileStoreResult::Stored)
+      ++Stats.Stored;
+    else if (Builds[I].StoreResult == ModuleFileStoreResult::Deduplicated)
+      ++Stats.Deduplicated;
+    Diags.Report(ImportLoc, diag::remark_module_build)
+        << Builds[I].ModuleName << Jobs[I].ModuleFileName;
+
+    // Report the build's diagnostics to the importer's client, as they would
+    // have been had the module been built on demand, with the locations in
+    // the build's source manager.
+    DiagnosticsEngine &BuildDiags = *Builds[I].Diags;
+    BuildDiags.setClient(Diags.getClient(), /*ShouldOwnClient=*/false);
+    for (const StoredDiagnostic &SD : Builds[I].Diagnostics)
+      BuildDiags.Report(SD);
+
+    Diags.Report(ImportLoc, diag::remark_module_build_done)
+        << Builds[I].ModuleName;
+  }
+
+  if (BuiltAny && ImportingInstance.getFrontendOpts().GenerateGlobalModuleIndex)
+    ImportingInstance.setBuildGlobalModuleIndex(true);
+}
+
 /// \brief Diagnose differences between the current definition of the given
 /// configuration macro and the definition provided on the command line.
 static void checkConfigMacro(Preprocessor &PP, StringRef ConfigMacro,
@@ -1468,6 +1739,14 @@ static void pruneModuleCache(const HeaderSearchOptions &HSOpts) {
             llvm::sys::fs::directory_iterator() && !EC)
       llvm::sys::fs::remove(Dir->path());
   }
+
+  // Module files stored by content are only kept while a module file in
+  // the cache links to them.
+  removeUnusedModuleFileObjects(ModuleCachePathNative);
+
+  if (HSOpts.ModuleCacheMaxSize)
+    limitModuleCacheSize(ModuleCachePathNative,
+                         uint64_t(HSOpts.ModuleCacheMaxSize) << 20);
 }
 
 void CompilerInstance::createModuleManager() {
@@ -1734,14 +2013,17 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
     unsigned ARRFlags = Source == ModuleCache ?
                         ASTReader::ARR_OutOfDate | ASTReader::ARR_Missing :
                         ASTReader::ARR_ConfigurationMismatch;
-    switch (ModuleManager->ReadAST(ModuleFileName,
-                                   Source == PrebuiltModulePath
-                                       ? serialization::MK_PrebuiltModule
-                                       : Source == ModuleBuildPragma
-                                             ? serialization::MK_ExplicitModule
-                                             : serialization::MK_ImplicitModule,
-                                   ImportLoc, ARRFlags)) {
+    ASTReader::ASTReadResult ReadResult = ModuleManager->ReadAST(
+        ModuleFileName,
+        Source == PrebuiltModulePath
+            ? serialization::MK_PrebuiltModule
+            : Source == ModuleBuildPragma ? serialization::MK_ExplicitModule
+                                          : serialization::MK_ImplicitModule,
+        ImportLoc, ARRFlags);
+    switch (ReadResult) {
     case ASTReader::Success: {
+      if (Source == ModuleCache)
+        ++CacheStats.Hits;
       if (Source != ModuleCache && !Module) {
         Module = PP->getHeaderSearchInfo().lookupModule(ModuleName);
         if (!Module || !Module->getASTFile() ||
@@ -1803,11 +2085,24 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
         return ModuleLoadResult();
       }
 
+      // Build the missing modules that this one depends on first, several at a
+      // time. Those builds can't share a dependency collector, so don't
+      // schedule them when collecting dependencies.
+      if (getHeaderSearchOpts().ModuleBuildThreads > 1 &&
+          !getModuleDepCollector())
+        compileModuleDependencies(*this, ImportLoc, Module);
+
+      if (ReadResult == ASTReader::Missing)
+        ++CacheStats.Missing;
+      else
+        ++CacheStats.OutOfDate;
+
       // Try to compile and then load the module.
       if (!compileAndLoadModule(*this, ImportLoc, ModuleNameLoc, Module,
                                 ModuleFileName)) {
         assert(getDiagnostics().hasErrorOccurred() &&
                "undiagnosed error in compileAndLoadModule");
+        ++CacheStats.Failed;
         if (getPreprocessorOpts().FailedModules)
           getPreprocessorOpts().FailedModules->addFailed(ModuleName);
         KnownModules[Path[0].first] = nullptr;
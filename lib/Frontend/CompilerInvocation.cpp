@@ -546,6 +546,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
     OPT_fuse_register_sized_bitfield_access);
   Opts.RelaxedAliasing = Args.hasArg(OPT_relaxed_aliasing);
   Opts.StructPathTBAA = !Args.hasArg(OPT_no_struct_path_tbaa);
+  Opts.StructPathTBAAArrays = Args.hasArg(OPT_fstruct_path_tbaa_arrays);
   Opts.FineGrainedBitfieldAccesses =
       Args.hasFlag(OPT_ffine_grained_bitfield_accesses,
                    OPT_fno_fine_grained_bitfield_accesses, false);
@@ -568,6 +569,7 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.SampleProfileFile = Args.getLastArgValue(OPT_fprofile_sample_use_EQ);
   Opts.DebugInfoForProfiling = Args.hasFlag(
       OPT_fdebug_info_for_profiling, OPT_fno_debug_info_for_profiling, false);
+  Opts.DebugTypeHoming = Args.hasArg(OPT_fdebug_type_homing);
   Opts.GnuPubnames = Args.hasArg(OPT_ggnu_pubnames);
 
   setPGOInstrumentor(Opts, Args, Diags);
@@ -608,6 +610,18 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.CoverageMapping =
       Args.hasFlag(OPT_fcoverage_mapping, OPT_fno_coverage_mapping, false);
   Opts.DumpCoverageMapping = Args.hasArg(OPT_dump_coverage_mapping);
+  if (Arg *A = Args.getLastArg(OPT_fcoverage_counters_EQ)) {
+    StringRef Name = A->getValue();
+    unsigned Kind = llvm::StringSwitch<unsigned>(Name)
+        .Case("full", CodeGenOptions::CoverageCountersFull)
+        .Case("fast", CodeGenOptions::CoverageCountersFast)
+        .Default(~0U);
+    if (Kind == ~0U)
+      Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args) << Name;
+    else
+      Opts.setCoverageCounters(
+          static_cast<CodeGenOptions::CoverageCountersKind>(Kind));
+  }
   Opts.AsmVerbose = Args.hasArg(OPT_masm_verbose);
   Opts.PreserveAsmComments = !Args.hasArg(OPT_fno_preserve_as_comments);
   Opts.AssumeSaneOperatorNew = !Args.hasArg(OPT_fno_assume_sane_operator_new);
@@ -683,9 +697,15 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.MergeFunctions = Args.hasArg(OPT_fmerge_functions);
 
+  Opts.InstantiationHomesFile =
+      Args.getLastArgValue(OPT_finstantiation_homes_EQ);
+  Opts.EmitInstantiationHomesFile =
+      Args.getLastArgValue(OPT_femit_instantiation_homes_EQ);
+
   Opts.NoUseJumpTables = Args.hasArg(OPT_fno_jump_tables);
 
   Opts.ProfileSampleAccurate = Args.hasArg(OPT_fprofile_sample_accurate);
+  Opts.ProfileColdOptNone = Args.hasArg(OPT_fprofile_cold_optnone);
 
   Opts.PrepareForLTO = Args.hasArg(OPT_flto, OPT_flto_EQ);
   Opts.EmitSummaryIndex = false;
@@ -709,6 +729,22 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.VectorizeLoop = Args.hasArg(OPT_vectorize_loops);
   Opts.VectorizeSLP = Args.hasArg(OPT_vectorize_slp);
+  Opts.DeriveLoopHints = Args.hasArg(OPT_fderive_loop_hints);
+  Opts.CodeGenThreads =
+      std::max(0, getLastArgIntValue(Args, OPT_fcodegen_threads_EQ, 0, Diags));
+  // Unless told otherwise, split the module into one partition per thread.
+  Opts.CodeGenPartitions = std::max(
+      1, getLastArgIntValue(Args, OPT_fcodegen_partitions_EQ,
+                            Opts.CodeGenThreads, Diags));
+  Opts.CodeGenCachePath = Args.getLastArgValue(OPT_fcodegen_cache_path_EQ);
+  // The new pass manager always optimizes the module as a whole.
+  if (Opts.ExperimentalNewPassManager &&
+      (Opts.CodeGenPartitions > 1 || !Opts.CodeGenCachePath.empty())) {
+    Diags.Report(diag::warn_drv_codegen_partitions_ignored);
+    Opts.CodeGenThreads = 0;
+    Opts.CodeGenPartitions = 1;
+    Opts.CodeGenCachePath.clear();
+  }
 
   Opts.MainFileName = Args.getLastArgValue(OPT_main_file_name);
   Opts.VerifyModule = !Args.hasArg(OPT_disable_llvm_verifier);
@@ -1172,6 +1208,8 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
   Opts.SpellCheckingLimit = getLastArgIntValue(
       Args, OPT_fspell_checking_limit,
       DiagnosticOptions::DefaultSpellCheckingLimit, Diags);
+  Opts.TypoCorrectionBudget =
+      getLastArgIntValue(Args, OPT_ftypo_correction_budget, 0, Diags);
   Opts.SnippetLineLimit = getLastArgIntValue(
       Args, OPT_fcaret_diagnostics_max_lines,
       DiagnosticOptions::DefaultSnippetLineLimit, Diags);
@@ -1340,8 +1378,21 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
+  if (const Arg *A = Args.getLastArg(OPT_ast_memory_report,
+                                     OPT_ast_memory_report_EQ)) {
+    StringRef Format =
+        A->getOption().matches(OPT_ast_memory_report) ? "text" : A->getValue();
+    if (Format == "text")
+      Opts.ASTMemoryReport = FrontendOptions::AMR_Text;
+    else if (Format == "json")
+      Opts.ASTMemoryReport = FrontendOptions::AMR_JSON;
+    else
+      Diags.Report(diag::err_drv_invalid_value)
+          << A->getAsString(Args) << Format;
+  }
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
   Opts.ShowVersion = Args.hasArg(OPT_version);
+  Opts.PrintModuleCacheStats = Args.hasArg(OPT_print_module_cache_stats);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
   Opts.LLVMArgs = Args.getAllArgValues(OPT_mllvm);
   Opts.FixWhatYouCan = Args.hasArg(OPT_fix_what_you_can);
@@ -1352,6 +1403,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.ASTDumpAll = Args.hasArg(OPT_ast_dump_all);
   Opts.ASTDumpFilter = Args.getLastArgValue(OPT_ast_dump_filter);
   Opts.ASTDumpLookups = Args.hasArg(OPT_ast_dump_lookups);
+  Opts.SkipNonMainFileFunctionBodies =
+      Args.hasArg(OPT_skip_non_main_file_function_bodies);
   Opts.UseGlobalModuleIndex = !Args.hasArg(OPT_fno_modules_global_index);
   Opts.GenerateGlobalModuleIndex = Opts.UseGlobalModuleIndex;
   Opts.ModuleMapFiles = Args.getAllArgValues(OPT_fmodule_map_file);
@@ -1582,8 +1635,18 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
       getLastArgIntValue(Args, OPT_fmodules_prune_interval, 7 * 24 * 60 * 60);
   Opts.ModuleCachePruneAfter =
       getLastArgIntValue(Args, OPT_fmodules_prune_after, 31 * 24 * 60 * 60);
+  Opts.ModuleBuildThreads =
+      getLastArgIntValue(Args, OPT_fmodules_build_threads, 0);
+  Opts.ModuleCacheMaxSize =
+      getLastArgIntValue(Args, OPT_fmodules_cache_max_size, 0);
+  Opts.ModulesCacheDedup = Args.hasArg(OPT_fmodules_cache_dedup);
+  Opts.ModulesCacheStats = Args.hasArg(OPT_fmodules_cache_stats);
   Opts.ModulesValidateOncePerBuildSession =
       Args.hasArg(OPT_fmodules_validate_once_per_build_session);
+  Opts.ModulesShareSessionValidation =
+      Args.hasArg(OPT_fmodules_share_session_validation);
+  Opts.ValidateASTInputFilesContent =
+      Args.hasArg(OPT_fvalidate_ast_input_files_content);
   Opts.BuildSessionTimestamp =
       getLastArgUInt64Value(Args, OPT_fbuild_session_timestamp, 0);
   Opts.ModulesValidateSystemHeaders =
@@ -2213,6 +2276,11 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_depth, 512, Diags);
   Opts.ConstexprStepLimit =
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
+  Opts.ConstexprBytecodeVerify = Args.hasArg(OPT_fconstexpr_bytecode_verify);
+  Opts.ConstexprBytecode =
+      Args.hasArg(OPT_fconstexpr_bytecode) || Opts.ConstexprBytecodeVerify;
+  Opts.ConstexprCallCache = Args.hasArg(OPT_fconstexpr_call_cache);
+  Opts.CacheUnqualifiedLookup = Args.hasArg(OPT_fcache_unqualified_lookup);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
   Opts.NumLargeByValueCopy =
@@ -23,6 +23,7 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
@@ -923,6 +924,18 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.getFrontendOpts().ASTMemoryReport != FrontendOptions::AMR_None &&
+      CI.hasASTContext()) {
+    SmallVector<std::pair<StringRef, size_t>, 1> Tables;
+    if (CI.hasSema())
+      Tables.push_back({"Sema side tables",
+                        CI.getSema().getSideTableAllocatedMemory()});
+    CI.getASTContext().printMemoryReport(
+        llvm::errs(),
+        CI.getFrontendOpts().ASTMemoryReport == FrontendOptions::AMR_JSON,
+        Tables);
+  }
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
@@ -995,8 +1008,12 @@ void ASTFrontendAction::ExecuteAction() {
   if (!CI.hasSema())
     CI.createSema(getTranslationUnitKind(), CompletionConsumer);
 
-  ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
-           CI.getFrontendOpts().SkipFunctionBodies);
+  const FrontendOptions &FEOpts = CI.getFrontendOpts();
+  if (FEOpts.SkipNonMainFileFunctionBodies)
+    CI.getSema().SkipNonMainFileFunctionBodies = true;
+
+  ParseAST(CI.getSema(), FEOpts.ShowStats,
+           FEOpts.SkipFunctionBodies || FEOpts.SkipNonMainFileFunctionBodies);
 }
 
 void PluginASTAction::anchor() { }
@@ -0,0 +1,230 @@
+//===--- ModuleBuildScheduler.cpp - Build implicit modules concurrently ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the scheduler for concurrent implicit module builds.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ModuleBuildScheduler.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/Module.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include <functional>
+#include <mutex>
+
+using namespace clang;
+
+/// Return the top-level module name at the start of \p Path, which names a
+/// module or submodule in an import directive.
+static StringRef getTopLevelModuleName(StringRef Path) {
+  return Path.ltrim().take_while(
+      [](char C) { return isIdentifierBody(C); });
+}
+
+/// Call \p OnInclude for each inclusion directive in \p Buffer, and
+/// \p OnImport for each module import. This only skips comments; it does not
+/// evaluate conditionals.
+static void
+scanDirectives(StringRef Buffer,
+               llvm::function_ref<void(StringRef, bool)> OnInclude,
+               llvm::function_ref<void(StringRef)> OnImport) {
+  bool InBlockComment = false;
+  while (!Buffer.empty()) {
+    StringRef Line;
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    if (InBlockComment) {
+      size_t End = Line.find("*/");
+      if (End == StringRef::npos)
+        continue;
+      Line = Line.substr(End + 2);
+      InBlockComment = false;
+    }
+    Line = Line.ltrim();
+
+    size_t Start = Line.find("/*");
+    if (Start != StringRef::npos &&
+        Line.find("*/", Start + 2) == StringRef::npos)
+      InBlockComment = true;
+
+    if (Line.consume_front("@import")) {
+      OnImport(getTopLevelModuleName(Line));
+      continue;
+    }
+    if (!Line.consume_front("#"))
+      continue;
+    Line = Line.ltrim();
+
+    if (Line.consume_front("pragma")) {
+      Line = Line.ltrim();
+      if (!Line.consume_front("clang"))
+        continue;
+      Line = Line.ltrim();
+      if (!Line.consume_front("module"))
+        continue;
+      Line = Line.ltrim();
+      if (Line.consume_front("import"))
+        OnImport(getTopLevelModuleName(Line));
+      continue;
+    }
+
+    if (!Line.consume_front("include_next") && !Line.consume_front("include") &&
+        !Line.consume_front("import"))
+      continue;
+    Line = Line.ltrim();
+    bool Angled = Line.consume_front("<");
+    if (!Angled && !Line.consume_front("\""))
+      continue;
+    size_t End = Line.find(Angled ? '>' : '"');
+    if (End != StringRef::npos && End != 0)
+      OnInclude(Line.substr(0, End), Angled);
+  }
+}
+
+void ModuleBuildScheduler::scanHeader(const FileEntry *File,
+                                      Module *Requesting,
+                                      SmallVectorImpl<Module *> &Imports) {
+  auto Buffer = FileMgr.getBufferForFile(File);
+  if (!Buffer)
+    return;
+
+  const DirectoryEntry *Dir = File->getDir();
+  scanDirectives(
+      (*Buffer)->getBuffer(),
+      [&](StringRef Name, bool Angled) {
+        const DirectoryLookup *CurDir = nullptr;
+        ModuleMap::KnownHeader Suggested;
+        const FileEntry *Included = HS.LookupFile(
+            Name, SourceLocation(), Angled, /*FromDir=*/nullptr, CurDir,
+            {std::make_pair(File, Dir)}, /*SearchPath=*/nullptr,
+            /*RelativePath=*/nullptr, Requesting, &Suggested,
+            /*IsMapped=*/nullptr);
+        if (Included && Suggested)
+          Imports.push_back(Suggested.getModule()->getTopLevelModule());
+      },
+      [&](StringRef Name) {
+        if (Name.empty())
+          return;
+        if (Module *M = HS.lookupModule(Name))
+          Imports.push_back(M);
+      });
+}
+
+void ModuleBuildScheduler::collectImports(Module *M,
+                                          SmallVectorImpl<Module *> &Imports) {
+  llvm::SmallPtrSet<const FileEntry *, 16> Scanned;
+  SmallVector<Module *, 8> Worklist(1, M);
+  while (!Worklist.empty()) {
+    Module *Sub = Worklist.pop_back_val();
+    if (!Sub->isAvailable())
+      continue;
+
+    if (const FileEntry *Umbrella = Sub->getUmbrellaHeader().Entry)
+      if (Scanned.insert(Umbrella).second)
+        scanHeader(Umbrella, Sub, Imports);
+    for (unsigned Kind = 0; Kind != Module::HK_Excluded; ++Kind)
+      for (const Module::Header &H : Sub->Headers[Kind])
+        if (Scanned.insert(H.Entry).second)
+          scanHeader(H.Entry, Sub, Imports);
+
+    Worklist.append(Sub->submodule_begin(), Sub->submodule_end());
+  }
+}
+
+int ModuleBuildScheduler::getJob(Module *M) {
+  auto Known = JobForModule.find(M);
+  if (Known != JobForModule.end())
+    return Known->second;
+
+  // Modules whose dependencies are still being found have no job yet, which
+  // keeps a cycle in the predicted graph from deadlocking the build.
+  JobForModule[M] = -1;
+  if (!M->isAvailable())
+    return -1;
+
+  // Module files that exist might be out of date, but checking that means
+  // reading them. Leave them to the importer, which will do so anyway.
+  std::string ModuleFileName = HS.getCachedModuleFileName(M);
+  if (ModuleFileName.empty() || llvm::sys::fs::exists(ModuleFileName))
+    return -1;
+
+  SmallVector<Module *, 8> Imports;
+  collectImports(M, Imports);
+  SmallVector<unsigned, 4> Deps;
+  for (Module *Import : Imports) {
+    int Dep = getJob(Import);
+    if (Dep >= 0 && !llvm::is_contained(Deps, unsigned(Dep)))
+      Deps.push_back(Dep);
+  }
+
+  int Index = Jobs.size();
+  Jobs.push_back({M, std::move(ModuleFileName), std::move(Deps)});
+  JobForModule[M] = Index;
+  return Index;
+}
+
+void ModuleBuildScheduler::excludeModule(Module *M) {
+  JobForModule[M->getTopLevelModule()] = -1;
+}
+
+void ModuleBuildScheduler::addDependenciesOf(Module *M) {
+  M = M->getTopLevelModule();
+  excludeModule(M);
+
+  SmallVector<Module *, 8> Imports;
+  collectImports(M, Imports);
+  for (Module *Import : Imports)
+    getJob(Import);
+}
+
+std::vector<bool>
+ModuleBuildScheduler::run(unsigned NumThreads,
+                          llvm::function_ref<bool(unsigned)> Build) {
+  std::vector<bool> Built(Jobs.size());
+  std::vector<unsigned> PendingDeps(Jobs.size());
+  std::vector<SmallVector<unsigned, 4>> Dependents(Jobs.size());
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I) {
+    PendingDeps[I] = Jobs[I].Deps.size();
+    for (unsigned Dep : Jobs[I].Deps)
+      Dependents[Dep].push_back(I);
+  }
+
+  llvm::ThreadPool Pool(NumThreads);
+  std::mutex Mutex;
+  std::function<void(unsigned)> Start = [&](unsigned I) {
+    Pool.async([&, I] {
+      bool Success = Build(I);
+
+      // A job whose dependency failed is never started; its importer will
+      // try to build it again, and diagnose the failure, if it needs it.
+      std::lock_guard<std::mutex> Lock(Mutex);
+      if (!Success)
+        return;
+      Built[I] = true;
+      for (unsigned Dependent : Dependents[I])
+        if (--PendingDeps[Dependent] == 0)
+          Start(Dependent);
+    });
+  };
+
+  // Find the jobs that can start right away before starting any, since the
+  // first ones to finish start others.
+  SmallVector<unsigned, 8> Ready;
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+    if (!PendingDeps[I])
+      Ready.push_back(I);
+  for (unsigned I : Ready)
+    Start(I);
+  Pool.wait();
+  return Built;
+}
@@ -0,0 +1,101 @@
+//===--- ModuleBuildScheduler.h - Build implicit modules concurrently -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides the scheduler behind -fmodules-build-threads. Before an
+// implicit module is built, the scheduler finds the modules it depends on
+// whose module files are missing from the module cache, by scanning the
+// headers of each module for inclusion and import directives and resolving
+// them with header search. It then builds those modules on a thread pool,
+// starting each one as soon as the ones it depends on have been built.
+//
+// Discovery is a prediction: a directive that is never reached (because of
+// the preprocessor state) adds an unneeded dependency, and one produced by a
+// macro expansion is missed. Neither affects correctness, since the module
+// that needs a dependency still builds it on demand if it is missing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_FRONTEND_MODULEBUILDSCHEDULER_H
+#define LLVM_CLANG_LIB_FRONTEND_MODULEBUILDSCHEDULER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class FileEntry;
+class FileManager;
+class HeaderSearch;
+class Module;
+
+class ModuleBuildScheduler {
+public:
+  /// \brief A module that needs to be built.
+  struct Job {
+    Module *M;
+
+    /// The file that the module will be written to.
+    std::string ModuleFileName;
+
+    /// The jobs that have to finish before this one can start.
+    SmallVector<unsigned, 4> Deps;
+  };
+
+  ModuleBuildScheduler(HeaderSearch &HS, FileManager &FileMgr)
+      : HS(HS), FileMgr(FileMgr) {}
+
+  /// \brief Find the modules that \p M depends on, directly or indirectly,
+  /// and that have no module file in the module cache.
+  ///
+  /// \p M itself is not added, since its importer builds it.
+  void addDependenciesOf(Module *M);
+
+  /// \brief Never build \p M, because it is already being built.
+  void excludeModule(Module *M);
+
+  ArrayRef<Job> jobs() const { return Jobs; }
+
+  /// \brief Call \p Build for each job on up to \p NumThreads threads,
+  /// once all of the job's dependencies were built successfully.
+  ///
+  /// \p Build is called concurrently and must be safe to do so.
+  ///
+  /// \returns true for each job that was built successfully.
+  std::vector<bool> run(unsigned NumThreads,
+                        llvm::function_ref<bool(unsigned)> Build);
+
+private:
+  /// Return the job for building \p M, creating it and the jobs for its
+  /// dependencies if needed, or -1 if \p M does not need to be built.
+  int getJob(Module *M);
+
+  /// Collect the top-level modules imported by the headers of \p M.
+  void collectImports(Module *M, SmallVectorImpl<Module *> &Imports);
+
+  /// Collect the top-level modules imported by \p File, a header of the
+  /// module \p Requesting.
+  void scanHeader(const FileEntry *File, Module *Requesting,
+                  SmallVectorImpl<Module *> &Imports);
+
+  HeaderSearch &HS;
+  FileManager &FileMgr;
+
+  std::vector<Job> Jobs;
+
+  /// The job for each module that was considered, or -1.
+  llvm::DenseMap<Module *, int> JobForModule;
+};
+
+} // end namespace clang
+
+#endif
@@ -0,0 +1,272 @@
+//===--- ModuleCache.cpp - Storage of implicitly built modules ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/ModuleCache.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <map>
+
+using namespace clang;
+namespace fs = llvm::sys::fs;
+
+/// The directory of the module cache that module files are stored in by
+/// content.
+static const char ObjectsDirName[] = "objects";
+
+/// The file of the module cache that usage counts are recorded in.
+static const char StatsFileName[] = "modules.stats";
+
+ModuleCacheStats &ModuleCacheStats::operator+=(const ModuleCacheStats &Other) {
+  Hits += Other.Hits;
+  Missing += Other.Missing;
+  OutOfDate += Other.OutOfDate;
+  Failed += Other.Failed;
+  Scheduled += Other.Scheduled;
+  Stored += Other.Stored;
+  Deduplicated += Other.Deduplicated;
+  return *this;
+}
+
+void ModuleCacheStats::print(raw_ostream &OS) const {
+  OS << "  " << Hits << " hits, " << Missing + OutOfDate << " misses ("
+     << Missing << " missing, " << OutOfDate << " out of date), " << Failed
+     << " failed builds\n";
+  OS << "  " << Scheduled << " module files built ahead of their import\n";
+  OS << "  " << Stored << " module files stored by content, " << Deduplicated
+     << " deduplicated\n";
+}
+
+ModuleFileStoreResult clang::storeModuleFileByContent(StringRef CachePath,
+                                                      StringRef ModuleFileName) {
+  auto Buffer = llvm::MemoryBuffer::getFile(ModuleFileName, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return ModuleFileStoreResult::Failed;
+
+  llvm::MD5 Hash;
+  Hash.update((*Buffer)->getBuffer());
+  llvm::MD5::MD5Result Digest;
+  Hash.final(Digest);
+
+  SmallString<128> ObjectFile(CachePath);
+  llvm::sys::path::append(ObjectFile, ObjectsDirName);
+  if (fs::create_directories(ObjectFile))
+    return ModuleFileStoreResult::Failed;
+  SmallString<32> ObjectName = Digest.digest();
+  ObjectName += ".pcm";
+  llvm::sys::path::append(ObjectFile, ObjectName);
+
+  // Most module files are not identical to any other.
+  std::error_code EC = fs::create_hard_link(ModuleFileName, ObjectFile);
+  if (!EC)
+    return ModuleFileStoreResult::Stored;
+  if (EC != llvm::errc::file_exists)
+    return ModuleFileStoreResult::Failed;
+
+  // Don't trust the hash alone to decide that the files are the same.
+  auto Object = llvm::MemoryBuffer::getFile(ObjectFile, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
+  if (!Object || (*Object)->getBuffer() != (*Buffer)->getBuffer())
+    return ModuleFileStoreResult::Failed;
+  if (fs::equivalent(ObjectFile, ModuleFileName))
+    return ModuleFileStoreResult::Stored;
+
+  // Replace the module file with a link to the stored one. Renaming the link
+  // over it means that readers see one file or the other, both identical.
+  SmallString<128> LinkFile;
+  if (fs::createUniqueFile(ModuleFileName + "-%%%%%%%%.link", LinkFile))
+    return ModuleFileStoreResult::Failed;
+  fs::remove(LinkFile);
+  if (fs::create_hard_link(ObjectFile, LinkFile))
+    return ModuleFileStoreResult::Failed;
+  if (fs::rename(LinkFile, ModuleFileName)) {
+    fs::remove(LinkFile);
+    return ModuleFileStoreResult::Failed;
+  }
+  return ModuleFileStoreResult::Deduplicated;
+}
+
+/// Call \p Callback for each module file in the module cache at \p CachePath,
+/// with the name of the directory it is in.
+static void
+forEachModuleFile(StringRef CachePath,
+                  llvm::function_ref<void(StringRef Dir, StringRef File,
+                                          const fs::file_status &Status)>
+                      Callback) {
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  llvm::sys::path::native(CachePath, CachePathNative);
+  for (fs::directory_iterator Dir(CachePathNative, EC), DirEnd;
+       Dir != DirEnd && !EC; Dir.increment(EC)) {
+    if (!fs::is_directory(Dir->path()))
+      continue;
+
+    std::error_code FileEC;
+    for (fs::directory_iterator File(Dir->path(), FileEC), FileEnd;
+         File != FileEnd && !FileEC; File.increment(FileEC)) {
+      if (llvm::sys::path::extension(File->path()) != ".pcm")
+        continue;
+      fs::file_status Status;
+      if (fs::status(File->path(), Status))
+        continue;
+      Callback(llvm::sys::path::filename(Dir->path()), File->path(), Status);
+    }
+  }
+}
+
+void clang::removeUnusedModuleFileObjects(StringRef CachePath) {
+  SmallString<128> ObjectsDir(CachePath);
+  llvm::sys::path::append(ObjectsDir, ObjectsDirName);
+
+  std::error_code EC;
+  for (fs::directory_iterator File(ObjectsDir, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    fs::file_status Status;
+    if (fs::status(File->path(), Status))
+      continue;
+    if (Status.getLinkCount() == 1)
+      fs::remove(File->path());
+  }
+}
+
+void clang::limitModuleCacheSize(StringRef CachePath, uint64_t MaxSize) {
+  // Links to a stored module file make up a single entry, which takes space
+  // once, and is used whenever any of them is.
+  struct Entry {
+    uint64_t Size;
+    llvm::sys::TimePoint<> AccessTime;
+    SmallVector<std::string, 2> Files;
+  };
+  std::map<fs::UniqueID, Entry> Entries;
+  uint64_t TotalSize = 0;
+  forEachModuleFile(CachePath, [&](StringRef, StringRef File,
+                                   const fs::file_status &Status) {
+    Entry &E = Entries[Status.getUniqueID()];
+    if (E.Files.empty()) {
+      E.Size = Status.getSize();
+      E.AccessTime = Status.getLastAccessedTime();
+      TotalSize += E.Size;
+    }
+    E.Files.push_back(File);
+  });
+  if (TotalSize <= MaxSize)
+    return;
+
+  std::vector<Entry *> ByAccessTime;
+  for (auto &E : Entries)
+    ByAccessTime.push_back(&E.second);
+  std::sort(ByAccessTime.begin(), ByAccessTime.end(),
+            [](const Entry *LHS, const Entry *RHS) {
+              return LHS->AccessTime < RHS->AccessTime;
+            });
+
+  for (Entry *E : ByAccessTime) {
+    if (TotalSize <= MaxSize)
+      break;
+    for (const std::string &File : E->Files) {
+      fs::remove(File);
+      fs::remove(File + ".timestamp");
+
+      // The global module index refers to the module file, so it is out of
+      // date now; it is rebuilt when needed.
+      SmallString<128> IndexFile = llvm::sys::path::parent_path(File);
+      llvm::sys::path::append(IndexFile, "modules.idx");
+      fs::remove(IndexFile);
+    }
+    TotalSize -= E->Size;
+  }
+}
+
+void clang::recordModuleCacheStats(StringRef CachePath,
+                                   const ModuleCacheStats &Stats) {
+  SmallString<128> StatsFile(CachePath);
+  llvm::sys::path::append(StatsFile, StatsFileName);
+
+  // Each compilation appends a line, written at once so that concurrent
+  // compilations don't interleave their counts.
+  std::string Line;
+  llvm::raw_string_ostream LineOS(Line);
+  LineOS << Stats.Hits << ' ' << Stats.Missing << ' ' << Stats.OutOfDate << ' '
+         << Stats.Failed << ' ' << Stats.Scheduled << ' ' << Stats.Stored
+         << ' ' << Stats.Deduplicated << '\n';
+  LineOS.flush();
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(StatsFile, EC, fs::F_Append | fs::F_Text);
+  if (!EC)
+    OS << Line;
+}
+
+/// Read the counts recorded in the module cache at \p CachePath.
+static ModuleCacheStats readModuleCacheStats(StringRef CachePath) {
+  SmallString<128> StatsFile(CachePath);
+  llvm::sys::path::append(StatsFile, StatsFileName);
+
+  ModuleCacheStats Total;
+  auto Buffer = llvm::MemoryBuffer::getFile(StatsFile);
+  if (!Buffer)
+    return Total;
+
+  SmallVector<StringRef, 16> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    ModuleCacheStats Stats;
+    unsigned *Fields[] = {&Stats.Hits,      &Stats.Missing, &Stats.OutOfDate,
+                          &Stats.Failed,    &Stats.Scheduled, &Stats.Stored,
+                          &Stats.Deduplicated};
+    bool Valid = true;
+    for (unsigned *Field : Fields) {
+      StringRef Value;
+      std::tie(Value, Line) = getToken(Line);
+      if (Value.getAsInteger(10, *Field)) {
+        Valid = false;
+        break;
+      }
+    }
+    // Skip lines that were cut short, e.g. by a full disk.
+    if (Valid)
+      Total += Stats;
+  }
+  return Total;
+}
+
+void clang::printModuleCacheStats(StringRef CachePath, raw_ostream &OS) {
+  unsigned NumFiles = 0;
+  uint64_t Size = 0;
+  llvm::StringSet<> ConfigurationNames;
+  std::map<fs::UniqueID, uint64_t> Shared;
+  forEachModuleFile(CachePath, [&](StringRef Dir, StringRef,
+                                   const fs::file_status &Status) {
+    Shared[Status.getUniqueID()] = Status.getSize();
+    if (Dir == ObjectsDirName)
+      return;
+    ConfigurationNames.insert(Dir);
+    ++NumFiles;
+    Size += Status.getSize();
+  });
+  uint64_t SizeOnDisk = 0;
+  for (const auto &File : Shared)
+    SizeOnDisk += File.second;
+
+  OS << "*** Module Cache Stats for '" << CachePath << "':\n";
+  OS << "  " << NumFiles << " module files in " << ConfigurationNames.size()
+     << " configurations, " << Size << " bytes (" << SizeOnDisk
+     << " bytes on disk)\n";
+  readModuleCacheStats(CachePath).print(OS);
+}
@@ -22,6 +22,7 @@
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Frontend/ModuleCache.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Rewrite/Frontend/FrontendActions.h"
 #include "clang/StaticAnalyzer/Frontend/FrontendActions.h"
@@ -192,6 +193,17 @@ bool clang::ExecuteCompilerInvocation(CompilerInstance *Clang) {
     return true;
   }
 
+  // Honor -print-module-cache-stats.
+  if (Clang->getFrontendOpts().PrintModuleCacheStats) {
+    StringRef CachePath = Clang->getHeaderSearchOpts().ModuleCachePath;
+    if (CachePath.empty()) {
+      Clang->getDiagnostics().Report(diag::err_fe_module_cache_stats_no_path);
+      return false;
+    }
+    printModuleCacheStats(CachePath, llvm::outs());
+    return true;
+  }
+
   // Load any requested plugins.
   for (unsigned i = 0,
          e = Clang->getFrontendOpts().Plugins.size(); i != e; ++i) {
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Parse/ParseAST.h"
+#include "clang/AST/APValue.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ExternalASTSource.h"
@@ -115,6 +116,7 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   if (PrintStats) {
     Decl::EnableStatistics();
     Stmt::EnableStatistics();
+    APValue::EnableStatistics();
   }
 
   // Also turn on collection of stats inside of the Sema object.
@@ -165,6 +167,7 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
     S.getASTContext().PrintStats();
     Decl::PrintStats();
     Stmt::PrintStats();
+    APValue::PrintStats();
     Consumer->PrintStats();
   }
 }
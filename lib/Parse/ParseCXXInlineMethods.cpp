@@ -102,7 +102,7 @@ NamedDecl *Parser::ParseCXXInlineMethodDef(AccessSpecifier AS,
   }
 
   if (SkipFunctionBodies && (!FnD || Actions.canSkipFunctionBody(FnD)) &&
-      trySkippingFunctionBody()) {
+      trySkippingFunctionBody(FnD)) {
     Actions.ActOnSkippedFunctionBody(FnD);
     return FnD;
   }
@@ -2634,7 +2634,7 @@ Parser::ParseObjCAutoreleasePoolStmt(SourceLocation atLoc) {
 /// for later parsing.
 void Parser::StashAwayMethodOrFunctionBodyTokens(Decl *MDecl) {
   if (SkipFunctionBodies && (!MDecl || Actions.canSkipFunctionBody(MDecl)) &&
-      trySkippingFunctionBody()) {
+      trySkippingFunctionBody(MDecl)) {
     Actions.ActOnSkippedFunctionBody(MDecl);
     return;
   }
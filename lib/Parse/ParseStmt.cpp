@@ -2019,10 +2019,18 @@ Decl *Parser::ParseFunctionTryBlock(Decl *Decl, ParseScope &BodyScope) {
   return Actions.ActOnFinishFunctionBody(Decl, FnBody.get());
 }
 
-bool Parser::trySkippingFunctionBody() {
+bool Parser::trySkippingFunctionBody(Decl *D) {
   assert(SkipFunctionBodies &&
          "Should only be called when SkipFunctionBodies is enabled");
   if (!PP.isCodeCompletionEnabled()) {
+    // Keep the tokens of the body around so it can be parsed on demand.
+    FunctionDecl *FD = D ? D->getAsFunction() : nullptr;
+    if (FD && Actions.SkipNonMainFileFunctionBodies) {
+      CachedTokens Toks;
+      LexTemplateFunctionForLateParsing(Toks);
+      Actions.MarkAsSkippedFunctionBody(FD, D, Toks);
+      return true;
+    }
     SkipFunctionBody();
     return true;
   }
@@ -2059,6 +2067,32 @@ bool Parser::trySkippingFunctionBody() {
   return true;
 }
 
+bool Parser::ParseSkippedFunctionBody(FunctionDecl *FD) {
+  auto It = Actions.SkippedFunctionBodies.find(FD);
+  if (It == Actions.SkippedFunctionBodies.end())
+    return false;
+  std::unique_ptr<LateParsedTemplate> LPT = std::move(It->second);
+  Actions.SkippedFunctionBodies.erase(It);
+
+  // The parser that skipped the body is gone, so recreate a translation unit
+  // scope for the body to be parsed in.
+  ParseScope TUScope(this, Scope::DeclScope);
+  getCurScope()->setEntity(Actions.Context.getTranslationUnitDecl());
+  Scope *SavedTUScope = Actions.TUScope;
+  Actions.TUScope = getCurScope();
+
+  FD->setHasSkippedBody(false);
+  ParseLateTemplatedFuncDef(*LPT);
+
+  // Anything the new body needs instantiated would otherwise never be, since
+  // the end of the translation unit has already been processed.
+  Actions.PerformPendingInstantiations();
+
+  TUScope.Exit();
+  Actions.TUScope = SavedTUScope;
+  return FD->hasBody();
+}
+
 /// ParseCXXTryBlock - Parse a C++ try-block.
 ///
 ///       try-block:
@@ -1091,7 +1091,7 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
     D.getMutableDeclSpec().abort();
 
     if (SkipFunctionBodies && (!DP || Actions.canSkipFunctionBody(DP)) &&
-        trySkippingFunctionBody()) {
+        trySkippingFunctionBody(DP)) {
       BodyScope.Exit();
       return Actions.ActOnSkippedFunctionBody(DP);
     }
@@ -1191,7 +1191,7 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
   }
 
   if (SkipFunctionBodies && (!Res || Actions.canSkipFunctionBody(Res)) &&
-      trySkippingFunctionBody()) {
+      trySkippingFunctionBody(Res)) {
     BodyScope.Exit();
     Actions.ActOnSkippedFunctionBody(Res);
     return Actions.ActOnFinishFunctionBody(Res, nullptr, false);
@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TypoCorrectionIndex.h"
+#include "UnqualifiedLookupCache.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/AST/DeclCXX.h"
@@ -39,6 +41,7 @@
 #include "clang/Sema/TemplateDeduction.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/Support/Format.h"
 using namespace clang;
 using namespace sema;
 
@@ -128,7 +131,8 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
       CodeSegStack(nullptr), CurInitSeg(nullptr), VisContext(nullptr),
       PragmaAttributeCurrentTargetDecl(nullptr),
       IsBuildingRecoveryCallExpr(false), Cleanup{}, LateTemplateParser(nullptr),
-      LateTemplateParserCleanup(nullptr), OpaqueParser(nullptr), IdResolver(pp),
+      LateTemplateParserCleanup(nullptr), OpaqueParser(nullptr),
+      SkipNonMainFileFunctionBodies(false), IdResolver(pp),
       StdExperimentalNamespaceCache(nullptr), StdInitializerList(nullptr),
       CXXTypeInfoDecl(nullptr), MSVCGuidDecl(nullptr), NSNumberDecl(nullptr),
       NSValueDecl(nullptr), NSStringDecl(nullptr),
@@ -154,6 +158,17 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
   if (getLangOpts().CPlusPlus)
     FieldCollector.reset(new CXXFieldCollector());
 
+  // Cached lookups don't track module visibility, so only use them without
+  // modules.
+  if (getLangOpts().CPlusPlus && getLangOpts().CacheUnqualifiedLookup &&
+      !getLangOpts().Modules && !getLangOpts().ModulesTS &&
+      !getLangOpts().ModulesLocalVisibility) {
+    UnqualifiedLookups.reset(new UnqualifiedLookupCache());
+    IdResolver.setLookupCache(UnqualifiedLookups.get());
+    Context.setDeclLookupChangedFn(&UnqualifiedLookupCache::declLookupChanged,
+                                   UnqualifiedLookups.get());
+  }
+
   // Tell diagnostics how to render things from the AST library.
   Diags.SetArgToStringFn(&FormatASTNodeDiagnosticArgument, &Context);
 
@@ -331,6 +346,8 @@ void Sema::Initialize() {
 
 Sema::~Sema() {
   if (VisContext) FreeVisContext();
+  if (UnqualifiedLookups)
+    Context.setDeclLookupChangedFn(nullptr, nullptr);
   // Kill all the active scopes.
   for (unsigned I = 1, E = FunctionScopes.size(); I != E; ++I)
     delete FunctionScopes[I];
@@ -416,9 +433,34 @@ void Sema::addExternalSource(ExternalSemaSource *E) {
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
+  if (SkipNonMainFileFunctionBodies)
+    llvm::errs() << SkippedFunctionBodies.size()
+                 << " function bodies skipped and retained for later parsing.\n";
 
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
+  if (UnqualifiedLookups)
+    UnqualifiedLookups->PrintStats();
+
+  llvm::errs() << "\n*** Typo Correction Stats:\n";
+  llvm::errs() << "  " << TyposCorrected << " typos looked at, "
+               << TypoCorrectionCost.NumOverLimit << " over the limit, "
+               << TypoCorrectionCost.NumOverBudget << " over the budget\n";
+  llvm::errs() << "  " << TypoCorrectionCost.NumEditDistances
+               << " edit distances computed in "
+               << llvm::format("%.3f", TypoCorrectionCost.Time / 1e6)
+               << " ms\n";
+  if (TypoIndex)
+    TypoIndex->PrintStats();
+}
+
+size_t Sema::getSideTableAllocatedMemory() const {
+  return BumpAlloc.getTotalMemory() +
+         llvm::capacity_in_bytes(UnparsedDefaultArgLocs) +
+         llvm::capacity_in_bytes(ExtnameUndeclaredIdentifiers) +
+         llvm::capacity_in_bytes(ShadowingDecls) +
+         llvm::capacity_in_bytes(VTablesUsed) +
+         llvm::capacity_in_bytes(VisibleNamespaceCache);
 }
 
 void Sema::diagnoseNullableToNonnullConversion(QualType DstType,
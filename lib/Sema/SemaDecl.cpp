@@ -1805,6 +1805,13 @@ static void CheckPoppedLabel(LabelDecl *L, Sema &S) {
 void Sema::ActOnPopScope(SourceLocation Loc, Scope *S) {
   S->mergeNRVOIntoParent();
 
+  // Lookups from this scope may have used its using-directives; another scope
+  // could be created at the same address without them.
+  if (S->using_directives().begin() != S->using_directives().end())
+    invalidateUnqualifiedLookups();
+  else
+    invalidateUnqualifiedLookupsFrom(S);
+
   if (S->decl_empty()) return;
   assert((S->getFlags() & (Scope::DeclScope | Scope::TemplateParamScope)) &&
          "Scope shouldn't contain decls!");
@@ -12361,6 +12368,11 @@ bool Sema::canSkipFunctionBody(Decl *D) {
   if (const FunctionDecl *FD = D->getAsFunction())
     if (FD->isConstexpr() || FD->getReturnType()->isUndeducedType())
       return false;
+  // When only bodies outside of the main file are skipped, the main file is
+  // always parsed fully.
+  if (SkipNonMainFileFunctionBodies &&
+      SourceMgr.isInMainFile(D->getLocation()))
+    return false;
   return Consumer.shouldSkipFunctionBody(D);
 }
 
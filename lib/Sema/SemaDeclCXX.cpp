@@ -2350,6 +2350,9 @@ bool Sema::AttachBaseSpecifiers(CXXRecordDecl *Class,
  if (Bases.empty())
     return false;
 
+  // Members of the new bases can now be found from within the class.
+  invalidateUnqualifiedLookups();
+
   // Used to keep track of which base types we have already seen, so
   // that we can properly diagnose redundant direct base types. Note
   // that the key is always the unqualified canonical type of the base
@@ -8966,10 +8969,12 @@ void Sema::PushUsingDirective(Scope *S, UsingDirectiveDecl *UDir) {
   DeclContext *Ctx = S->getEntity();
   if (Ctx && !Ctx->isFunctionOrMethod())
     Ctx->addDecl(UDir);
-  else
+  else {
     // Otherwise, it is at block scope. The using-directives will affect lookup
     // only to the end of the scope.
     S->PushUsingDirective(UDir);
+    invalidateUnqualifiedLookups();
+  }
 }
 
 
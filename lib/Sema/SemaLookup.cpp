@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "TypoCorrectionIndex.h"
+#include "UnqualifiedLookupCache.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/Decl.h"
@@ -41,6 +43,7 @@
 #include "llvm/ADT/edit_distance.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <list>
 #include <set>
@@ -1048,7 +1051,46 @@ struct FindLocalExternScope {
 };
 } // end anonymous namespace
 
+/// \brief Determine whether the result of the unqualified lookup \p R can be
+/// cached.
+static bool isCacheableUnqualifiedLookup(const LookupResult &R) {
+  // Redeclaration lookups depend on where the lookup started in ways the
+  // cache does not track, and are rarely repeated anyway.
+  if (!R.empty() || R.isForRedeclaration() ||
+      R.getLookupKind() == Sema::LookupRedeclarationWithLinkage)
+    return false;
+
+  // Looking up these names can declare members or deduction guides.
+  DeclarationName Name = R.getLookupName();
+  return !isImplicitlyDeclaredMemberFunctionName(Name) &&
+         Name.getNameKind() != DeclarationName::CXXConversionFunctionName &&
+         Name.getNameKind() != DeclarationName::CXXDeductionGuideName;
+}
+
 bool Sema::CppLookupName(LookupResult &R, Scope *S) {
+  if (!UnqualifiedLookups || !S || !isCacheableUnqualifiedLookup(R))
+    return CppLookupNameUncached(R, S);
+
+  bool Found;
+  if (UnqualifiedLookups->lookup(R, S, Found))
+    return Found;
+
+  Found = CppLookupNameUncached(R, S);
+  UnqualifiedLookups->insert(R, S, Found);
+  return Found;
+}
+
+void Sema::invalidateUnqualifiedLookups() {
+  if (UnqualifiedLookups)
+    UnqualifiedLookups->invalidateAll();
+}
+
+void Sema::invalidateUnqualifiedLookupsFrom(Scope *S) {
+  if (UnqualifiedLookups)
+    UnqualifiedLookups->invalidateScope(S);
+}
+
+bool Sema::CppLookupNameUncached(LookupResult &R, Scope *S) {
   assert(getLangOpts().CPlusPlus && "Can perform only C++ lookup");
 
   DeclarationName Name = R.getLookupName();
@@ -3951,6 +3993,30 @@ void TypoCorrectionConsumer::FoundDecl(NamedDecl *ND, NamedDecl *Hiding,
   FoundName(Name->getName());
 }
 
+namespace {
+/// \brief Charges the time until it is destroyed to the cost of typo
+/// correction.
+class TypoCorrectionTimer {
+  Sema &SemaRef;
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  explicit TypoCorrectionTimer(Sema &SemaRef)
+      : SemaRef(SemaRef), Start(std::chrono::steady_clock::now()) {}
+  ~TypoCorrectionTimer() {
+    SemaRef.TypoCorrectionCost.Time +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - Start).count();
+  }
+};
+} // end anonymous namespace
+
+bool Sema::isTypoCorrectionBudgetExhausted() const {
+  uint64_t Budget =
+      getDiagnostics().getDiagnosticOptions().TypoCorrectionBudget;
+  return Budget && TypoCorrectionCost.Time >= Budget * 1000000;
+}
+
 void TypoCorrectionConsumer::FoundName(StringRef Name) {
   // Compute the edit distance between the typo and the name of this
   // entity, and add the identifier to the list of results.
@@ -3975,6 +4041,7 @@ void TypoCorrectionConsumer::addName(StringRef Name, NamedDecl *ND,
   // Compute an upper bound on the allowable edit distance, so that the
   // edit-distance algorithm can short-circuit.
   unsigned UpperBound = (TypoStr.size() + 2) / 3 + 1;
+  ++SemaRef.TypoCorrectionCost.NumEditDistances;
   unsigned ED = TypoStr.edit_distance(Name, true, UpperBound);
   if (ED >= UpperBound) return;
 
@@ -4140,8 +4207,15 @@ retry_lookup:
 }
 
 void TypoCorrectionConsumer::performQualifiedLookups() {
+  TypoCorrectionTimer Timer(SemaRef);
   unsigned TypoLen = Typo->getName().size();
   for (const TypoCorrection &QR : QualifiedResults) {
+    // Looking for each candidate in every known namespace is the most
+    // expensive part of typo correction, so give up on it once the budget
+    // is used up.
+    if (SemaRef.isTypoCorrectionBudgetExhausted())
+      break;
+
     for (const auto &NSI : Namespaces) {
       DeclContext *Ctx = NSI.DeclCtx;
       const Type *NSType = NSI.NameSpecifier->getAsType();
@@ -4593,10 +4667,18 @@ std::unique_ptr<TypoCorrectionConsumer> Sema::makeTypoCorrectionConsumer(
   // to correct all typos can turn into a HUGE performance penalty, causing
   // some files to take minutes to get rejected by the parser.
   unsigned Limit = getDiagnostics().getDiagnosticOptions().SpellCheckingLimit;
-  if (Limit && TyposCorrected >= Limit)
+  if (Limit && TyposCorrected >= Limit) {
+    ++TypoCorrectionCost.NumOverLimit;
+    return nullptr;
+  }
+  if (isTypoCorrectionBudgetExhausted()) {
+    ++TypoCorrectionCost.NumOverBudget;
     return nullptr;
+  }
   ++TyposCorrected;
 
+  TypoCorrectionTimer Timer(*this);
+
   // If we're handling a missing symbol error, using modules, and the
   // special search all modules option is used, look for a missing import.
   if (ErrorRecovery && getLangOpts().Modules &&
@@ -4640,10 +4722,16 @@ std::unique_ptr<TypoCorrectionConsumer> Sema::makeTypoCorrectionConsumer(
 
   if (IsUnqualifiedLookup || SearchNamespaces) {
     // For unqualified lookup, look through all of the names that we have
-    // seen in this translation unit.
-    // FIXME: Re-add the ability to skip very unlikely potential corrections.
-    for (const auto &I : Context.Idents)
-      Consumer->FoundName(I.getKey());
+    // seen in this translation unit. The index skips the ones that cannot be
+    // close enough to the typo without computing their edit distance.
+    if (!TypoIndex)
+      TypoIndex.reset(new TypoCorrectionIndex());
+    TypoIndex->update(Context.Idents);
+    SmallVector<StringRef, 32> Candidates;
+    TypoIndex->findCandidates(Typo->getName(),
+                              (Typo->getName().size() + 2) / 3, Candidates);
+    for (StringRef Name : Candidates)
+      Consumer->FoundName(Name);
 
     // Walk through identifiers in external identifier sources.
     // FIXME: Re-add the ability to skip very unlikely potential corrections.
@@ -9851,6 +9851,19 @@ void Sema::UnmarkAsLateParsedTemplate(FunctionDecl *FD) {
   FD->setLateTemplateParsed(false);
 }
 
+void Sema::MarkAsSkippedFunctionBody(FunctionDecl *FD, Decl *FnD,
+                                     CachedTokens &Toks) {
+  if (!FD)
+    return;
+
+  auto LPT = llvm::make_unique<LateParsedTemplate>();
+
+  // Take tokens to avoid allocations
+  LPT->Toks.swap(Toks);
+  LPT->D = FnD;
+  SkippedFunctionBodies[FD] = std::move(LPT);
+}
+
 bool Sema::IsInsideALocalClassWithinATemplateFunction() {
   DeclContext *DC = CurContext;
 
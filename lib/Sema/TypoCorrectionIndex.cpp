@@ -0,0 +1,95 @@
+//===--- TypoCorrectionIndex.cpp - Index of identifiers for typos ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the identifier index used by typo correction.
+//
+//===----------------------------------------------------------------------===//
+
+#include "TypoCorrectionIndex.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+uint64_t TypoCorrectionIndex::getCharSet(StringRef Name) {
+  // Give each character that is common in identifiers its own bit. Anything
+  // else shares the last one, which only makes the bound weaker.
+  uint64_t Set = 0;
+  for (char C : Name) {
+    unsigned Bit;
+    if (C >= 'a' && C <= 'z')
+      Bit = C - 'a';
+    else if (C >= 'A' && C <= 'Z')
+      Bit = 26 + (C - 'A');
+    else if (C >= '0' && C <= '9')
+      Bit = 52 + (C - '0');
+    else if (C == '_')
+      Bit = 62;
+    else
+      Bit = 63;
+    Set |= uint64_t(1) << Bit;
+  }
+  return Set;
+}
+
+void TypoCorrectionIndex::update(const IdentifierTable &Idents) {
+  // Identifiers are never removed from the table, so it has not changed if
+  // its size has not.
+  if (Idents.size() == TableSize)
+    return;
+  TableSize = Idents.size();
+  ++NumUpdates;
+
+  for (const auto &I : Idents) {
+    if (!Indexed.insert(I.getValue()).second)
+      continue;
+
+    StringRef Name = I.getKey();
+    if (Name.size() >= ByLength.size())
+      ByLength.resize(Name.size() + 1);
+    ByLength[Name.size()].push_back({Name.data(), getCharSet(Name)});
+  }
+}
+
+void TypoCorrectionIndex::findCandidates(StringRef Typo, unsigned MaxDistance,
+                                         SmallVectorImpl<StringRef> &Names) {
+  ++NumQueries;
+
+  // TypoCorrectionConsumer::addName rejects names whose length differs from
+  // the typo's by more than a third of it.
+  size_t Len = Typo.size();
+  size_t MaxLenDiff = std::min<size_t>(Len / 3, MaxDistance);
+  size_t MinLen = std::max<size_t>(Len - MaxLenDiff, 1);
+  size_t MaxLen = Len + MaxLenDiff;
+
+  uint64_t TypoChars = getCharSet(Typo);
+  for (size_t L = MinLen; L <= MaxLen && L < ByLength.size(); ++L) {
+    NumScanned += ByLength[L].size();
+    for (const Entry &E : ByLength[L]) {
+      // Inserting or deleting a character changes at most one member of the
+      // set, and replacing one changes at most two.
+      unsigned Differences = llvm::countPopulation(E.Chars ^ TypoChars);
+      if ((Differences + 1) / 2 > MaxDistance)
+        continue;
+      Names.push_back(StringRef(E.Name, L));
+      ++NumCandidates;
+    }
+  }
+}
+
+void TypoCorrectionIndex::PrintStats() const {
+  unsigned NumIndexed = Indexed.size();
+  llvm::errs() << "  " << NumIndexed << " identifiers indexed, in "
+               << NumUpdates << " updates\n";
+  llvm::errs() << "  " << NumCandidates << "/" << NumScanned
+               << " names of a similar length passed the character filter, in "
+               << NumQueries << " queries\n";
+}
@@ -0,0 +1,74 @@
+//===--- TypoCorrectionIndex.h - Index of identifiers for typos -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides an index over the identifiers of a translation unit that
+// lets typo correction skip most of them without computing an edit distance.
+//
+// Identifiers are bucketed by length, and each one is summarized by the set
+// of characters it contains. Typo correction only considers names whose
+// length is within a third of the typo's, and an edit changes at most two
+// members of that set, so both are cheap lower bounds on the edit distance.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_SEMA_TYPOCORRECTIONINDEX_H
+#define LLVM_CLANG_LIB_SEMA_TYPOCORRECTIONINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <vector>
+
+namespace clang {
+
+class IdentifierInfo;
+class IdentifierTable;
+
+class TypoCorrectionIndex {
+public:
+  /// \brief Add the identifiers in \p Idents that have not been indexed yet.
+  void update(const IdentifierTable &Idents);
+
+  /// \brief Collect the indexed names that might be at most \p MaxDistance
+  /// edits away from \p Typo, and close enough in length to it for typo
+  /// correction to consider them.
+  void findCandidates(StringRef Typo, unsigned MaxDistance,
+                      SmallVectorImpl<StringRef> &Names);
+
+  void PrintStats() const;
+
+private:
+  struct Entry {
+    /// The spelling of the identifier. Its length is given by the bucket.
+    const char *Name;
+    /// The characters that occur in the identifier, as given by getCharSet.
+    uint64_t Chars;
+  };
+
+  static uint64_t getCharSet(StringRef Name);
+
+  /// The indexed identifiers, by length.
+  std::vector<std::vector<Entry>> ByLength;
+
+  /// The identifiers that are in the index, and the size of the identifier
+  /// table when it was last brought up to date.
+  llvm::DenseSet<const IdentifierInfo *> Indexed;
+  unsigned TableSize = 0;
+
+  unsigned NumUpdates = 0;
+  unsigned NumQueries = 0;
+  uint64_t NumScanned = 0;
+  uint64_t NumCandidates = 0;
+};
+
+} // end namespace clang
+
+#endif
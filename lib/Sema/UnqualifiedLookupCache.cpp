@@ -0,0 +1,151 @@
+//===--- UnqualifiedLookupCache.cpp - Cached unqualified lookups ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cache of unqualified name lookup results.
+//
+//===----------------------------------------------------------------------===//
+
+#include "UnqualifiedLookupCache.h"
+#include "clang/Sema/Lookup.h"
+#include "clang/Sema/Scope.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+/// The number of results to keep before starting again. Results for the
+/// outermost scopes are only dropped when their name changes, so this bounds
+/// the memory they can hold on to.
+static const unsigned MaxEntries = 1 << 16;
+
+bool UnqualifiedLookupCache::matches(const Entry &E, const LookupResult &R,
+                                     Scope *S) {
+  return E.S == S && E.Parent == S->getParent() &&
+         E.Entity == S->getEntity() && E.ScopeFlags == S->getFlags() &&
+         E.LookupKind == unsigned(R.getLookupKind()) &&
+         E.HideTags == R.isHidingTags() &&
+         E.AllowHidden == R.isAllowingHidden();
+}
+
+bool UnqualifiedLookupCache::lookup(LookupResult &R, Scope *S, bool &Found) {
+  ++NumLookups;
+  auto It = Entries.find(R.getLookupName());
+  if (It == Entries.end())
+    return false;
+
+  for (const Entry &E : It->second) {
+    if (!matches(E, R, S))
+      continue;
+
+    ++NumHits;
+    for (const DeclAccessPair &D : E.Decls)
+      R.addDecl(D.getDecl(), D.getAccess());
+    if (E.NamingClass)
+      R.setNamingClass(E.NamingClass);
+    R.resolveKind();
+    Found = E.Found;
+    return true;
+  }
+  return false;
+}
+
+void UnqualifiedLookupCache::insert(const LookupResult &R, Scope *S,
+                                    bool Found) {
+  // Only plain results can be replayed by adding the declarations back and
+  // resolving them again. Ambiguities carry base paths, and results in the
+  // current instantiation depend on the template being defined.
+  switch (R.getResultKind()) {
+  case LookupResult::NotFound:
+  case LookupResult::Found:
+  case LookupResult::FoundOverloaded:
+  case LookupResult::FoundUnresolvedValue:
+    break;
+  case LookupResult::NotFoundInCurrentInstantiation:
+  case LookupResult::Ambiguous:
+    return;
+  }
+  if (R.getBasePaths() || R.isShadowed())
+    return;
+
+  if (NumEntries == MaxEntries)
+    invalidateAll();
+
+  Entry E;
+  E.S = S;
+  E.Parent = S->getParent();
+  E.Entity = S->getEntity();
+  E.ScopeFlags = S->getFlags();
+  E.LookupKind = R.getLookupKind();
+  E.HideTags = R.isHidingTags();
+  E.AllowHidden = R.isAllowingHidden();
+  E.Found = Found;
+  E.NamingClass = R.getNamingClass();
+  for (auto I = R.begin(), IEnd = R.end(); I != IEnd; ++I)
+    E.Decls.push_back(I.getPair());
+
+  Entries[R.getLookupName()].push_back(std::move(E));
+  NamesByScope[S].push_back(R.getLookupName());
+  ++NumEntries;
+  ++NumInserted;
+}
+
+void UnqualifiedLookupCache::invalidate(DeclarationName Name) {
+  // A using-directive can make any name visible.
+  if (Name == DeclarationName::getUsingDirectiveName())
+    return invalidateAll();
+
+  auto It = Entries.find(Name);
+  if (It == Entries.end())
+    return;
+  NumInvalidated += It->second.size();
+  NumEntries -= It->second.size();
+  Entries.erase(It);
+}
+
+void UnqualifiedLookupCache::invalidateScope(Scope *S) {
+  auto It = NamesByScope.find(S);
+  if (It == NamesByScope.end())
+    return;
+
+  for (DeclarationName Name : It->second) {
+    auto EntriesIt = Entries.find(Name);
+    if (EntriesIt == Entries.end())
+      continue;
+    SmallVectorImpl<Entry> &NameEntries = EntriesIt->second;
+    auto NewEnd = std::remove_if(NameEntries.begin(), NameEntries.end(),
+                                 [&](const Entry &E) { return E.S == S; });
+    unsigned NumRemoved = NameEntries.end() - NewEnd;
+    NumInvalidated += NumRemoved;
+    NumEntries -= NumRemoved;
+    NameEntries.erase(NewEnd, NameEntries.end());
+    if (NameEntries.empty())
+      Entries.erase(EntriesIt);
+  }
+  NamesByScope.erase(It);
+}
+
+void UnqualifiedLookupCache::invalidateAll() {
+  NamesByScope.clear();
+  if (!NumEntries)
+    return;
+  NumInvalidated += NumEntries;
+  ++NumFlushes;
+  NumEntries = 0;
+  Entries.clear();
+}
+
+void UnqualifiedLookupCache::PrintStats() const {
+  llvm::errs() << "\n*** Unqualified Lookup Cache Stats:\n";
+  llvm::errs() << "  " << NumHits << "/" << NumLookups
+               << " lookups hit the cache\n";
+  llvm::errs() << "  " << NumInserted << " results cached, "
+               << NumInvalidated << " invalidated, " << NumEntries
+               << " still cached\n";
+  llvm::errs() << "  " << NumFlushes << " full invalidations\n";
+}
@@ -0,0 +1,108 @@
+//===--- UnqualifiedLookupCache.h - Cached unqualified lookups --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides the cache behind -fcache-unqualified-lookup, which remembers
+// the results of C++ unqualified name lookups performed from a given scope so
+// that repeated lookups of the same name from the same place do not walk the
+// scope chain, the enclosing contexts and their using-directives again.
+//
+// Results are kept per name. Any change to the declarations with a name, in
+// the identifier resolver or in the lookup table of any namespace or class,
+// drops the results for that name. Changes that can affect every name (new
+// using-directives, or base classes being attached) drop everything.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_SEMA_UNQUALIFIEDLOOKUPCACHE_H
+#define LLVM_CLANG_LIB_SEMA_UNQUALIFIEDLOOKUPCACHE_H
+
+#include "clang/AST/DeclAccessPair.h"
+#include "clang/AST/DeclarationName.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+
+class CXXRecordDecl;
+class DeclContext;
+class LookupResult;
+class Scope;
+
+class UnqualifiedLookupCache {
+public:
+  /// \brief Try to answer the lookup \p R from scope \p S from the cache.
+  ///
+  /// \returns true, with the cached declarations added to \p R and \p Found
+  /// set to the result of the original lookup, on a hit.
+  bool lookup(LookupResult &R, Scope *S, bool &Found);
+
+  /// \brief Remember the result of the completed lookup \p R from scope \p S,
+  /// if it is one that can be replayed.
+  void insert(const LookupResult &R, Scope *S, bool Found);
+
+  /// \brief Drop all results for \p Name.
+  void invalidate(DeclarationName Name);
+
+  /// \brief Drop the results of lookups from \p S, which is being popped.
+  ///
+  /// The parser recycles scopes, so a later scope at the same address, with
+  /// the same parent, flags and (null) entity, could otherwise match them.
+  void invalidateScope(Scope *S);
+
+  /// \brief Drop all results.
+  void invalidateAll();
+
+  /// \brief Callback for ASTContext::setDeclLookupChangedFn.
+  static void declLookupChanged(void *Cache, DeclarationName Name) {
+    static_cast<UnqualifiedLookupCache *>(Cache)->invalidate(Name);
+  }
+
+  void PrintStats() const;
+
+private:
+  struct Entry {
+    /// The scope the lookup started from, and the state of that scope which
+    /// lookup depends on, which can change while the scope is active.
+    Scope *S;
+    Scope *Parent;
+    DeclContext *Entity;
+    unsigned ScopeFlags;
+
+    /// The settings of the lookup.
+    unsigned LookupKind;
+    bool HideTags;
+    bool AllowHidden;
+
+    /// The result.
+    bool Found;
+    CXXRecordDecl *NamingClass;
+    SmallVector<DeclAccessPair, 2> Decls;
+  };
+
+  static bool matches(const Entry &E, const LookupResult &R, Scope *S);
+
+  llvm::DenseMap<DeclarationName, SmallVector<Entry, 1>> Entries;
+  unsigned NumEntries = 0;
+
+  /// The names that results were cached for, for each scope the lookups
+  /// started from. A name may be listed more than once, or no longer have
+  /// results for the scope.
+  llvm::DenseMap<Scope *, SmallVector<DeclarationName, 4>> NamesByScope;
+
+  unsigned NumLookups = 0;
+  unsigned NumHits = 0;
+  unsigned NumInserted = 0;
+  unsigned NumInvalidated = 0;
+  unsigned NumFlushes = 0;
+};
+
+} // end namespace clang
+
+#endif
@@ -110,6 +110,8 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
@@ -117,6 +119,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -2076,9 +2079,28 @@ ASTReader::readInputFileInfo(ModuleFile &F, unsigned ID) {
   R.TopLevelModuleMap = static_cast<bool>(Record[5]);
   R.Filename = Blob;
   ResolveImportedPath(F, R.Filename);
+
+  // The hash of the contents, if any, follows the file.
+  R.ContentHash = 0;
+  llvm::BitstreamEntry Entry = Cursor.advance();
+  if (Entry.Kind == llvm::BitstreamEntry::Record) {
+    Record.clear();
+    if (Cursor.readRecord(Entry.ID, Record) == INPUT_FILE_HASH)
+      R.ContentHash = (Record[1] << 32) | Record[0];
+  }
   return R;
 }
 
+/// \brief Compute the hash of the contents of an input file that is stored
+/// in AST files.
+static uint64_t hashInputFileContents(StringRef Contents) {
+  llvm::MD5 Hash;
+  Hash.update(Contents);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.low();
+}
+
 static unsigned moduleKindForDiagnostic(ModuleKind Kind);
 InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   // If this ID is bogus, just return an empty input file.
@@ -2160,12 +2182,27 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
 
   bool IsOutOfDate = false;
 
+  // A file whose modification time changed might still have the contents it
+  // had when the AST file was built, e.g. after a version control checkout.
+  auto HasModifiedContents = [&] {
+    if (!FI.ContentHash || StoredSize != File->getSize() ||
+        !PP.getHeaderSearchInfo().getHeaderSearchOpts()
+             .ValidateASTInputFilesContent)
+      return true;
+    auto Buffer = FileMgr.getBufferForFile(File);
+    if (!Buffer ||
+        hashInputFileContents((*Buffer)->getBuffer()) != FI.ContentHash)
+      return true;
+    ++NumInputFilesMatchedByContent;
+    return false;
+  };
+
   // For an overridden file, there is nothing to validate.
   if (!Overridden && //
       (StoredSize != File->getSize() ||
        (StoredTime && StoredTime != File->getModificationTime() &&
         !DisableValidation)
-       )) {
+       ) && HasModifiedContents()) {
     if (Complain) {
       // Build a list of the PCH imports that got us here (in reverse).
       SmallVector<ModuleFile *, 4> ImportStack(1, &F);
@@ -2378,14 +2415,39 @@ ASTReader::ReadControlBlock(ModuleFile &F,
         if (ValidateSystemInputs ||
             (HSOpts.ModulesValidateOncePerBuildSession &&
              F.InputFilesValidationTimestamp <= HSOpts.BuildSessionTimestamp &&
+             F.Kind == MK_ImplicitModule) ||
+            (HSOpts.ModulesShareSessionValidation &&
              F.Kind == MK_ImplicitModule))
           N = NumInputs;
 
+        // A module file that was validated earlier in the session, by any
+        // compilation, is identified by its signature, which changes
+        // whenever it is rebuilt.
+        if (HSOpts.ModulesShareSessionValidation &&
+            F.Kind == MK_ImplicitModule && wasValidatedInSession(F)) {
+          N = 0;
+          ++NumModuleFilesTrusted;
+        } else {
+          ++NumModuleFilesValidated;
+        }
+
+        auto ValidationStart = std::chrono::steady_clock::now();
+        auto addValidationTime = [&] {
+          InputFileValidationTime +=
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - ValidationStart)
+                  .count();
+        };
         for (unsigned I = 0; I < N; ++I) {
           InputFile IF = getInputFile(F, I+1, Complain);
-          if (!IF.getFile() || IF.isOutOfDate())
+          ++NumInputFilesValidated;
+          if (!IF.getFile() || IF.isOutOfDate()) {
+            addValidationTime();
             return OutOfDate;
+          }
         }
+        addValidationTime();
+        F.AllInputFilesValidated = N && N == NumInputs;
       }
 
       if (Listener)
@@ -3122,12 +3184,13 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
     case SOURCE_LOCATION_PRELOADS: {
       // Need to transform from the local view (1-based IDs) to the global view,
       // which is based off F.SLocEntryBaseID.
-      if (!F.PreloadSLocEntries.empty()) {
+      if (F.PreloadSLocEntries) {
         Error("Multiple SOURCE_LOCATION_PRELOADS records in AST file");
         return Failure;
       }
 
-      F.PreloadSLocEntries.swap(Record);
+      F.PreloadSLocEntries = (const uint32_t *)Blob.data();
+      F.NumPreloadSLocEntries = Record[0];
       break;
     }
 
@@ -3788,6 +3851,122 @@ bool ASTReader::isGlobalIndexUnavailable() const {
          !hasGlobalIndex() && TriedLoadingGlobalIndex;
 }
 
+/// \brief Get the file of the module cache that lists the module files
+/// validated during the current build session.
+static std::string getSessionValidationsFilename(const HeaderSearch &HS) {
+  SmallString<128> Filename(HS.getModuleCachePath());
+  llvm::sys::path::append(Filename, "modules.validated");
+  return Filename.str();
+}
+
+/// \brief Get the key of a module file in the list of the module files
+/// validated during the current build session.
+static std::string getSessionValidationKey(const ModuleFile &MF) {
+  std::string Key;
+  llvm::raw_string_ostream OS(Key);
+  for (uint32_t Word : MF.Signature)
+    OS << llvm::format_hex_no_prefix(Word, 8);
+  return OS.str();
+}
+
+void ASTReader::readSessionValidations() {
+  ReadSessionValidations = true;
+
+  const HeaderSearch &HS = PP.getHeaderSearchInfo();
+  auto Buffer = llvm::MemoryBuffer::getFile(getSessionValidationsFilename(HS));
+  if (!Buffer)
+    return;
+
+  // The first line identifies the session, and each other line the signature
+  // of a module file.
+  StringRef Line, Rest;
+  std::tie(Line, Rest) = (*Buffer)->getBuffer().split('\n');
+  uint64_t Session;
+  if (Line.getAsInteger(10, Session) ||
+      Session != HS.getHeaderSearchOpts().BuildSessionTimestamp)
+    return;
+
+  SessionValidationsAreCurrent = true;
+  while (!Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    if (!Line.empty())
+      SessionValidations.insert(Line);
+  }
+}
+
+bool ASTReader::wasValidatedInSession(const ModuleFile &MF) {
+  const HeaderSearch &HS = PP.getHeaderSearchInfo();
+  if (!HS.getHeaderSearchOpts().BuildSessionTimestamp ||
+      HS.getModuleCachePath().empty() || MF.Signature == ASTFileSignature())
+    return false;
+
+  // The list is read once. Module files validated by other compilations
+  // since then are validated again, which is only slower.
+  if (!ReadSessionValidations)
+    readSessionValidations();
+  return SessionValidations.count(getSessionValidationKey(MF));
+}
+
+void ASTReader::recordSessionValidations(ArrayRef<ImportedModule> Loaded) {
+  const HeaderSearch &HS = PP.getHeaderSearchInfo();
+  uint64_t Session = HS.getHeaderSearchOpts().BuildSessionTimestamp;
+  if (!Session || HS.getModuleCachePath().empty())
+    return;
+  if (!ReadSessionValidations)
+    readSessionValidations();
+
+  std::string Lines;
+  for (const ImportedModule &M : Loaded) {
+    if (M.Mod->Kind != MK_ImplicitModule || !M.Mod->AllInputFilesValidated ||
+        M.Mod->Signature == ASTFileSignature())
+      continue;
+    std::string Key = getSessionValidationKey(*M.Mod);
+    if (SessionValidations.insert(Key).second) {
+      Lines += Key;
+      Lines += '\n';
+    }
+  }
+  if (Lines.empty())
+    return;
+
+  std::string Filename = getSessionValidationsFilename(HS);
+  if (SessionValidationsAreCurrent) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Filename, EC,
+                            llvm::sys::fs::F_Append | llvm::sys::fs::F_Text);
+    if (EC)
+      return;
+    OS << Lines;
+    OS.close();
+    OS.clear_error(); // Avoid triggering a fatal error.
+    return;
+  }
+
+  // Start the list for this session. Compilations that race to do so each
+  // rename a complete list into place; the module files recorded in the
+  // lists that are replaced are only validated again.
+  int FD;
+  SmallString<128> TempFilename;
+  if (llvm::sys::fs::createUniqueFile(Filename + "-%%%%%%%%", FD,
+                                      TempFilename))
+    return;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Session << '\n' << Lines;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error(); // Avoid triggering a fatal error.
+      llvm::sys::fs::remove(TempFilename);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempFilename, Filename)) {
+    llvm::sys::fs::remove(TempFilename);
+    return;
+  }
+  SessionValidationsAreCurrent = true;
+}
+
 static void updateModuleTimestamp(ModuleFile &MF) {
   // Overwrite the timestamp file contents so that file's mtime changes.
   std::string TimestampFilename = MF.getTimestampFilename();
@@ -3902,7 +4081,7 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
     GlobalBitOffsetsMap.insert(std::make_pair(F.GlobalBitOffset, &F));
 
     // Preload SLocEntries.
-    for (unsigned I = 0, N = F.PreloadSLocEntries.size(); I != N; ++I) {
+    for (unsigned I = 0, N = F.NumPreloadSLocEntries; I != N; ++I) {
       int Index = int(F.PreloadSLocEntries[I] - 1) + F.SLocEntryBaseID;
       // Load it through the SourceManager and don't call ReadSLocEntry()
       // directly because the entry may have already been loaded in which case
@@ -4062,6 +4241,11 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
     }
   }
 
+  if (PP.getHeaderSearchInfo()
+          .getHeaderSearchOpts()
+          .ModulesShareSessionValidation)
+    recordSessionValidations(Loaded);
+
   return Success;
 }
 
@@ -4807,6 +4991,8 @@ bool ASTReader::readASTFileControlBlock(
         StringRef Blob;
         bool shouldContinue = false;
         switch ((InputFileRecordTypes)Cursor.readRecord(Code, Record, &Blob)) {
+        case INPUT_FILE_HASH:
+          break;
         case INPUT_FILE:
           bool Overridden = static_cast<bool>(Record[3]);
           std::string Filename = Blob;
@@ -7026,6 +7212,7 @@ ASTReader::GetExternalCXXCtorInitializers(uint64_t Offset) {
     return nullptr;
   }
 
+  ++NumCtorInitializersRead;
   unsigned Idx = 0;
   return ReadCXXCtorInitializers(*Loc.F, Record, Idx);
 }
@@ -7253,7 +7440,11 @@ Stmt *ASTReader::GetExternalDeclStmt(uint64_t Offset) {
   assert(NumCurrentElementsDeserializing == 0 &&
          "should not be called while already deserializing");
   Deserializing D(this);
-  return ReadStmtFromStream(*Loc.F);
+  unsigned StatementsBefore = NumStatementsRead;
+  Stmt *Body = ReadStmtFromStream(*Loc.F);
+  ++NumLazyBodiesRead;
+  NumBodyStatementsRead += NumStatementsRead - StatementsBefore;
+  return Body;
 }
 
 void ASTReader::FindExternalLexicalDecls(
@@ -7389,9 +7580,21 @@ ASTReader::FindExternalVisibleDeclsByName(const DeclContext *DC,
 
   Deserializing LookupResults(this);
 
+  // If there is a global index, only search the lookup tables of the module
+  // files that it does not rule out.
+  reader::ASTDeclContextNameLookupTrait::data_type IDs;
+  GlobalModuleIndex::HitSet Hits;
+  if (!loadGlobalIndex() &&
+      GlobalIndex->lookupDeclName(DeclarationNameKey(Name).getHash(), Hits))
+    IDs = It->second.Table.find(Name, [&](ModuleFile *F) {
+      return Hits.count(F) || !GlobalIndex->hasModuleFile(F);
+    });
+  else
+    IDs = It->second.Table.find(Name);
+
   // Load the list of declarations.
   SmallVector<NamedDecl *, 64> Decls;
-  for (DeclID ID : It->second.Table.find(Name)) {
+  for (DeclID ID : IDs) {
     NamedDecl *ND = cast<NamedDecl>(GetDecl(ID));
     if (ND->getDeclName() == Name)
       Decls.push_back(ND);
@@ -7512,6 +7715,21 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u statements read (%f%%)\n",
                  NumStatementsRead, TotalNumStatements,
                  ((float)NumStatementsRead/TotalNumStatements * 100));
+  if (NumStatementsRead)
+    std::fprintf(stderr, "  %u of the statements read were in function bodies, "
+                 "%u were read with their declarations\n",
+                 NumBodyStatementsRead, NumStatementsRead - NumBodyStatementsRead);
+  if (NumLazyBodies)
+    std::fprintf(stderr, "  %u/%u function bodies read (%f%%)\n",
+                 NumLazyBodiesRead, NumLazyBodies,
+                 ((float)NumLazyBodiesRead/NumLazyBodies * 100));
+  if (NumMergedBodies)
+    std::fprintf(stderr, "  %u function bodies skipped for an existing "
+                 "definition\n", NumMergedBodies);
+  if (NumLazyCtorInitializers)
+    std::fprintf(stderr, "  %u/%u constructor initializer lists read (%f%%)\n",
+                 NumCtorInitializersRead, NumLazyCtorInitializers,
+                 ((float)NumCtorInitializersRead/NumLazyCtorInitializers * 100));
   if (TotalNumMacros)
     std::fprintf(stderr, "  %u/%u macros read (%f%%)\n",
                  NumMacrosRead, TotalNumMacros,
@@ -7546,6 +7764,18 @@ void ASTReader::PrintStats() {
                  NumIdentifierLookupHits, NumIdentifierLookups,
                  (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
 
+  if (NumModuleFilesValidated || NumModuleFilesTrusted)
+    std::fprintf(stderr,
+                 "  %u module files validated, %u trusted from earlier in the "
+                 "build session\n",
+                 NumModuleFilesValidated, NumModuleFilesTrusted);
+  if (NumInputFilesValidated)
+    std::fprintf(stderr,
+                 "  %u input files validated in %f ms, %u unchanged by "
+                 "content\n",
+                 NumInputFilesValidated, InputFileValidationTime / 1e6,
+                 NumInputFilesMatchedByContent);
+
   if (GlobalIndex) {
     std::fprintf(stderr, "\n");
     GlobalIndex->printStats();
@@ -9234,14 +9464,20 @@ void ASTReader::finishPendingActions() {
       const FunctionDecl *Defn = nullptr;
       if (!getContext().getLangOpts().Modules || !FD->hasBody(Defn)) {
         FD->setLazyBody(PB->second);
-      } else
+        ++NumLazyBodies;
+      } else {
         mergeDefinitionVisibility(const_cast<FunctionDecl*>(Defn), FD);
+        ++NumMergedBodies;
+      }
       continue;
     }
 
     ObjCMethodDecl *MD = cast<ObjCMethodDecl>(PB->first);
-    if (!getContext().getLangOpts().Modules || !MD->hasBody())
+    if (!getContext().getLangOpts().Modules || !MD->hasBody()) {
       MD->setLazyBody(PB->second);
+      ++NumLazyBodies;
+    } else
+      ++NumMergedBodies;
   }
   PendingBodies.clear();
 
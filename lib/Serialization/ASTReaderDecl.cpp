@@ -456,8 +456,10 @@ void ASTDeclReader::ReadFunctionDefinition(FunctionDecl *FD) {
     Reader.DefinitionSource[FD] = Loc.F->Kind == ModuleKind::MK_MainFile;
   if (auto *CD = dyn_cast<CXXConstructorDecl>(FD)) {
     CD->NumCtorInitializers = Record.readInt();
-    if (CD->NumCtorInitializers)
+    if (CD->NumCtorInitializers) {
       CD->CtorInitializers = ReadGlobalOffset();
+      ++Reader.NumLazyCtorInitializers;
+    }
   }
   // Store the offset of the body so we can lazily load it later.
   Reader.PendingBodies[FD] = GetCurrentCursorOffset();
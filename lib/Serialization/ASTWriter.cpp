@@ -93,6 +93,7 @@
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
@@ -1083,6 +1084,7 @@ void ASTWriter::WriteBlockInfoBlock() {
 
   BLOCK(INPUT_FILES_BLOCK);
   RECORD(INPUT_FILE);
+  RECORD(INPUT_FILE_HASH);
 
   // AST Top-Level Block.
   BLOCK(AST_BLOCK);
@@ -1739,6 +1741,7 @@ struct InputFileEntry {
   bool IsTransient;
   bool BufferOverridden;
   bool IsTopLevelModuleMap;
+  uint64_t ContentHash;
 };
 
 } // namespace
@@ -1762,6 +1765,13 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
   IFAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
   unsigned IFAbbrevCode = Stream.EmitAbbrev(std::move(IFAbbrev));
 
+  // Create input file hash abbreviation.
+  auto IFHAbbrev = std::make_shared<BitCodeAbbrev>();
+  IFHAbbrev->Add(BitCodeAbbrevOp(INPUT_FILE_HASH));
+  IFHAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32)); // Low bits
+  IFHAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32)); // High bits
+  unsigned IFHAbbrevCode = Stream.EmitAbbrev(std::move(IFHAbbrev));
+
   // Get all ContentCache objects for files, sorted by whether the file is a
   // system one or not. System files go at the back, users files at the front.
   std::deque<InputFileEntry> SortedFiles;
@@ -1785,6 +1795,19 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
     Entry.BufferOverridden = Cache->BufferOverridden;
     Entry.IsTopLevelModuleMap = isModuleMap(File.getFileCharacteristic()) &&
                                 File.getIncludeLoc().isInvalid();
+
+    // Hash the contents that were read, so that a reader can tell whether a
+    // file whose modification time changed was really modified. Only readers
+    // that validate input files by content use the hash.
+    Entry.ContentHash = 0;
+    if (HSOpts.ValidateASTInputFilesContent && !Cache->BufferOverridden)
+      if (const llvm::MemoryBuffer *Buffer = Cache->getRawBuffer()) {
+        llvm::MD5 Hash;
+        Hash.update(Buffer->getBuffer());
+        llvm::MD5::MD5Result Result;
+        Hash.final(Result);
+        Entry.ContentHash = Result.low();
+      }
     if (Cache->IsSystemFile)
       SortedFiles.push_back(Entry);
     else
@@ -1819,6 +1842,13 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
         Entry.IsTopLevelModuleMap};
 
     EmitRecordWithPath(IFAbbrevCode, Record, Entry.File->getName());
+
+    if (Entry.ContentHash) {
+      RecordData::value_type HashRecord[] = {
+          INPUT_FILE_HASH, Entry.ContentHash & 0xFFFFFFFF,
+          Entry.ContentHash >> 32};
+      Stream.EmitRecordWithAbbrev(IFHAbbrevCode, HashRecord);
+    }
   }
 
   Stream.ExitBlock();
@@ -2224,7 +2254,7 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   // Write out the source location entry table. We skip the first
   // entry, which is always the same dummy entry.
   std::vector<uint32_t> SLocEntryOffsets;
-  RecordData PreloadSLocs;
+  std::vector<uint32_t> PreloadSLocs;
   SLocEntryOffsets.reserve(SourceMgr.local_sloc_entry_size() - 1);
   for (unsigned I = 1, N = SourceMgr.local_sloc_entry_size();
        I != N; ++I) {
@@ -2352,7 +2382,17 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   }
   // Write the source location entry preloads array, telling the AST
   // reader which source locations entries it should load eagerly.
-  Stream.EmitRecord(SOURCE_LOCATION_PRELOADS, PreloadSLocs);
+  Abbrev = std::make_shared<BitCodeAbbrev>();
+  Abbrev->Add(BitCodeAbbrevOp(SOURCE_LOCATION_PRELOADS));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // # of preloads
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // entries
+  unsigned SLocPreloadsAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+  {
+    RecordData::value_type Record[] = {SOURCE_LOCATION_PRELOADS,
+                                       PreloadSLocs.size()};
+    Stream.EmitRecordWithBlob(SLocPreloadsAbbrev, Record,
+                              bytes(PreloadSLocs));
+  }
 
   // Write the line table. It depends on remapping working, so it must come
   // after the source location offsets.
@@ -50,7 +50,9 @@ namespace {
     /// \brief Describes a module, including its file name and dependencies.
     MODULE,
     /// \brief The index for identifiers.
-    IDENTIFIER_INDEX
+    IDENTIFIER_INDEX,
+    /// \brief The index for the names in declaration context lookup tables.
+    DECL_NAME_INDEX
   };
 }
 
@@ -58,7 +60,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// \brief The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -121,12 +123,52 @@ public:
 typedef llvm::OnDiskIterableChainedHashTable<IdentifierIndexReaderTrait>
     IdentifierIndexTable;
 
+/// \brief Trait used to read the declaration name index from the on-disk hash
+/// table. Names are represented by their hashes.
+class DeclNameIndexReaderTrait {
+public:
+  typedef unsigned external_key_type;
+  typedef unsigned internal_key_type;
+  typedef SmallVector<unsigned, 2> data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(internal_key_type a, internal_key_type b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(internal_key_type a) { return a; }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char*& d) {
+    using namespace llvm::support;
+    unsigned DataLen = endian::readNext<uint16_t, little, unaligned>(d);
+    return std::make_pair(4, DataLen);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char* d, unsigned) {
+    using namespace llvm::support;
+    return endian::readNext<uint32_t, little, unaligned>(d);
+  }
+
+  static data_type ReadData(internal_key_type k, const unsigned char* d,
+                            unsigned DataLen) {
+    return IdentifierIndexReaderTrait::ReadData(StringRef(), d, DataLen);
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<DeclNameIndexReaderTrait>
+    DeclNameIndexTable;
+
 }
 
 GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                                      llvm::BitstreamCursor Cursor)
-    : Buffer(std::move(Buffer)), IdentifierIndex(), NumIdentifierLookups(),
-      NumIdentifierLookupHits() {
+    : Buffer(std::move(Buffer)), IdentifierIndex(), DeclNameIndex(),
+      NumIdentifierLookups(), NumIdentifierLookupHits(), NumDeclNameLookups(),
+      NumDeclNameLookupModuleFiles() {
   // Read the global index.
   bool InGlobalIndexBlock = false;
   bool Done = false;
@@ -224,12 +266,22 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
             (const unsigned char *)Blob.data(), IdentifierIndexReaderTrait());
       }
       break;
+
+    case DECL_NAME_INDEX:
+      // Wire up the declaration name index.
+      if (Record[0]) {
+        DeclNameIndex = DeclNameIndexTable::Create(
+            (const unsigned char *)Blob.data() + Record[0],
+            (const unsigned char *)Blob.data(), DeclNameIndexReaderTrait());
+      }
+      break;
     }
   }
 }
 
 GlobalModuleIndex::~GlobalModuleIndex() {
   delete static_cast<IdentifierIndexTable *>(IdentifierIndex);
+  delete static_cast<DeclNameIndexTable *>(DeclNameIndex);
 }
 
 std::pair<GlobalModuleIndex *, GlobalModuleIndex::ErrorCode>
@@ -313,6 +365,30 @@ bool GlobalModuleIndex::lookupIdentifier(StringRef Name, HitSet &Hits) {
   return true;
 }
 
+bool GlobalModuleIndex::lookupDeclName(unsigned NameHash, HitSet &Hits) {
+  Hits.clear();
+
+  // If there's no declaration name index, there is nothing we can do.
+  if (!DeclNameIndex)
+    return false;
+
+  // Look into the declaration name index.
+  ++NumDeclNameLookups;
+  DeclNameIndexTable &Table = *static_cast<DeclNameIndexTable *>(DeclNameIndex);
+  DeclNameIndexTable::iterator Known = Table.find(NameHash);
+  if (Known == Table.end())
+    return true;
+
+  SmallVector<unsigned, 2> ModuleIDs = *Known;
+  for (unsigned I = 0, N = ModuleIDs.size(); I != N; ++I) {
+    if (ModuleFile *MF = Modules[ModuleIDs[I]].File)
+      Hits.insert(MF);
+  }
+
+  NumDeclNameLookupModuleFiles += Hits.size();
+  return true;
+}
+
 bool GlobalModuleIndex::loadedModuleFile(ModuleFile *File) {
   // Look for the module in the global module index based on the module name.
   StringRef Name = File->ModuleName;
@@ -347,6 +423,13 @@ void GlobalModuleIndex::printStats() {
             NumIdentifierLookupHits, NumIdentifierLookups,
             (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumDeclNameLookups) {
+    fprintf(stderr, "  %u declaration name lookups found %f module files "
+                    "each, of %u known\n",
+            NumDeclNameLookups,
+            (double)NumDeclNameLookupModuleFiles / NumDeclNameLookups,
+            ModulesByFile.size());
+  }
   std::fprintf(stderr, "\n");
 }
 
@@ -413,6 +496,17 @@ namespace {
     /// \brief A mapping from all interesting identifiers to the set of module
     /// files in which those identifiers are considered interesting.
     InterestingIdentifierMap InterestingIdentifiers;
+
+    /// \brief Mapping from the hashes of declaration names to the list of
+    /// module file IDs whose declaration context lookup tables contain them.
+    typedef llvm::MapVector<unsigned, SmallVector<unsigned, 2>> DeclNameMap;
+
+    /// \brief The names in the lookup tables of all module files.
+    DeclNameMap DeclNames;
+
+    /// \brief Add the names in the lookup table \p Table of the module file
+    /// \p ID.
+    void addDeclContextLookupTable(unsigned ID, StringRef Table);
     
     /// \brief Write the block-info block for the global module index file.
     void emitBlockInfoBlock(llvm::BitstreamWriter &Stream);
@@ -482,6 +576,7 @@ GlobalModuleIndexBuilder::emitBlockInfoBlock(llvm::BitstreamWriter &Stream) {
   RECORD(INDEX_METADATA);
   RECORD(MODULE);
   RECORD(IDENTIFIER_INDEX);
+  RECORD(DECL_NAME_INDEX);
 #undef RECORD
 #undef BLOCK
 
@@ -509,6 +604,41 @@ namespace {
   };
 }
 
+void GlobalModuleIndexBuilder::addDeclContextLookupTable(unsigned ID,
+                                                         StringRef Table) {
+  using namespace llvm::support;
+  typedef reader::ASTDeclContextNameLookupTrait Trait;
+  if (Table.size() < 2 * sizeof(uint32_t))
+    return;
+
+  // The names of a lookup table are only known by their IDs in the module
+  // file, but their hashes depend on the names alone, and are stored in the
+  // table with each of them.
+  // FIXME: Don't rely on the OnDiskHashTable format here.
+  const unsigned char *Base = (const unsigned char *)Table.data();
+  const unsigned char *Buckets = Base + endian::read32le(Base);
+  unsigned NumBuckets = llvm::OnDiskChainedHashTable<
+      Trait>::readNumBucketsAndEntries(Buckets).first;
+  for (unsigned I = 0; I != NumBuckets; ++I) {
+    uint32_t Offset = endian::readNext<uint32_t, little, unaligned>(Buckets);
+    if (!Offset)
+      continue;
+
+    const unsigned char *Item = Base + Offset;
+    unsigned NumItems = endian::readNext<uint16_t, little, unaligned>(Item);
+    for (; NumItems; --NumItems) {
+      unsigned Hash = endian::readNext<uint32_t, little, unaligned>(Item);
+      auto KeyDataLen = Trait::ReadKeyDataLength(Item);
+      Item += KeyDataLen.first + KeyDataLen.second;
+
+      // The tables of a module file are added one after the other.
+      SmallVector<unsigned, 2> &IDs = DeclNames[Hash];
+      if (IDs.empty() || IDs.back() != ID)
+        IDs.push_back(ID);
+    }
+  }
+}
+
 bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   // Open the module file.
 
@@ -533,7 +663,13 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   unsigned ID = getModuleFileInfo(File).ID;
 
   // Search for the blocks and records we care about.
-  enum { Other, ControlBlock, ASTBlock, DiagnosticOptionsBlock } State = Other;
+  enum {
+    Other,
+    ControlBlock,
+    ASTBlock,
+    DeclTypesBlock,
+    DiagnosticOptionsBlock
+  } State = Other;
   bool Done = false;
   while (!Done) {
     llvm::BitstreamEntry Entry = InStream.advance();
@@ -549,6 +685,15 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
         continue;
       }
 
+      // Of the declarations and types, only the lookup tables are
+      // interesting; skip the rest without reading them.
+      if (State == DeclTypesBlock) {
+        uint64_t Start = InStream.GetCurrentBitNo();
+        if (InStream.skipRecord(Entry.ID) != DECL_CONTEXT_VISIBLE)
+          continue;
+        InStream.JumpToBit(Start);
+      }
+
       // Handle potentially-interesting records below.
       break;
 
@@ -571,6 +716,15 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
         continue;
       }
 
+      if (State == ASTBlock && Entry.ID == DECLTYPES_BLOCK_ID) {
+        if (InStream.EnterSubBlock(DECLTYPES_BLOCK_ID))
+          return true;
+
+        // Found the declarations and types block.
+        State = DeclTypesBlock;
+        continue;
+      }
+
       if (Entry.ID == UNHASHED_CONTROL_BLOCK_ID) {
         if (InStream.EnterSubBlock(UNHASHED_CONTROL_BLOCK_ID))
           return true;
@@ -586,7 +740,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       continue;
 
     case llvm::BitstreamEntry::EndBlock:
-      State = Other;
+      State = State == DeclTypesBlock ? ASTBlock : Other;
       continue;
     }
 
@@ -671,6 +825,13 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       }
     }
 
+    // Handle the lookup tables of declaration contexts.
+    if ((State == ASTBlock && Code == UPDATE_VISIBLE) ||
+        (State == DeclTypesBlock && Code == DECL_CONTEXT_VISIBLE)) {
+      addDeclContextLookupTable(ID, Blob);
+      continue;
+    }
+
     // Get Signature.
     if (State == DiagnosticOptionsBlock && Code == SIGNATURE)
       getModuleFileInfo(File).Signature = {
@@ -723,6 +884,38 @@ public:
   }
 };
 
+/// \brief Trait used to generate the declaration name index as an on-disk
+/// hash table.
+class DeclNameIndexWriterTrait {
+public:
+  typedef unsigned key_type;
+  typedef unsigned key_type_ref;
+  typedef SmallVector<unsigned, 2> data_type;
+  typedef const SmallVector<unsigned, 2> &data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) { return Key; }
+
+  std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream& Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    unsigned DataLen = Data.size() * 4;
+    endian::Writer<little>(Out).write<uint16_t>(DataLen);
+    return std::make_pair(4, DataLen);
+  }
+
+  void EmitKey(raw_ostream& Out, key_type_ref Key, unsigned KeyLen) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint32_t>(Key);
+  }
+
+  void EmitData(raw_ostream& Out, key_type_ref Key, data_type_ref Data,
+                unsigned DataLen) {
+    IdentifierIndexWriterTrait().EmitData(Out, StringRef(), Data, DataLen);
+  }
+};
+
 }
 
 bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
@@ -813,6 +1006,33 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable);
   }
 
+  // Write the declaration name -> module file mapping.
+  {
+    llvm::OnDiskChainedHashTableGenerator<DeclNameIndexWriterTrait> Generator;
+    DeclNameIndexWriterTrait Trait;
+    for (auto &Name : DeclNames)
+      Generator.insert(Name.first, Name.second, Trait);
+
+    SmallString<4096> DeclNameTable;
+    uint32_t BucketOffset;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(DeclNameTable);
+      // Make sure that no bucket is at offset 0
+      endian::Writer<little>(Out).write<uint32_t>(0);
+      BucketOffset = Generator.Emit(Out, Trait);
+    }
+
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(DECL_NAME_INDEX));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned DeclNameTableAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+    uint64_t Record[] = {DECL_NAME_INDEX, BucketOffset};
+    Stream.EmitRecordWithBlob(DeclNameTableAbbrev, Record, DeclNameTable);
+  }
+
   Stream.ExitBlock();
   return false;
 }
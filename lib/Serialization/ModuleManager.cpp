@@ -173,9 +173,14 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
       // ModuleManager it must be the same underlying file.
       // FIXME: Because FileManager::getFile() doesn't guarantee that it will
       // give us an open file, this may not be 100% reliable.
+      //
+      // The reader uses the offset tables of an AST file in place, so map it
+      // rather than copying it: the pages are then shared with every other
+      // process that imports the same module.
       Buf = FileMgr.getBufferForFile(NewModule->File,
                                      /*IsVolatile=*/false,
-                                     /*ShouldClose=*/false);
+                                     /*ShouldClose=*/false,
+                                     /*RequiresNullTerminator=*/false);
     }
 
     if (!Buf) {
@@ -227,14 +227,32 @@ public:
 
   /// \brief Find and read the lookup results for \p EKey.
   data_type find(const external_key_type &EKey) {
-    data_type Result;
-
     if (!PendingOverrides.empty())
       removeOverriddenTables();
 
     if (Tables.size() > static_cast<unsigned>(Info::MaxTables))
       condense();
 
+    return findIn(EKey, [](file_type) { return true; });
+  }
+
+  /// \brief Find and read the lookup results for \p EKey, only searching
+  /// the on-disk tables of the files for which \p ShouldSearch returns true.
+  ///
+  /// The tables are not condensed, since that reads all of them.
+  template <typename FilterFn>
+  data_type find(const external_key_type &EKey, FilterFn ShouldSearch) {
+    if (!PendingOverrides.empty())
+      removeOverriddenTables();
+
+    return findIn(EKey, ShouldSearch);
+  }
+
+private:
+  template <typename FilterFn>
+  data_type findIn(const external_key_type &EKey, FilterFn ShouldSearch) {
+    data_type Result;
+
     internal_key_type Key = Info::GetInternalKey(EKey);
     auto KeyHash = Info::ComputeHash(Key);
 
@@ -247,6 +265,8 @@ public:
     data_type_builder ResultBuilder(Result);
 
     for (auto *ODT : tables()) {
+      if (!ShouldSearch(ODT->File))
+        continue;
       auto &HT = ODT->Table;
       auto It = HT.find_hashed(Key, KeyHash);
       if (It != HT.end())
@@ -257,6 +277,7 @@ public:
     return Result;
   }
 
+public:
   /// \brief Read all the lookup results into a single value. This only makes
   /// sense if merging values across keys is meaningful.
   data_type findAll() {
@@ -0,0 +1,46 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o %t/first.s %s 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o %t/second.s %s 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: diff %t/first.s %t/second.s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o - %s -DCHANGED 2>&1 | FileCheck -check-prefix=CHANGED %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -mllvm -inline-threshold=1000 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fveclib=SVML 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: echo '_Z1hi:100:10' > %t/sample.prof
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fprofile-sample-use=%t/sample.prof 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fprofile-sample-use=%t/sample.prof 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: echo '_Z1hi:200:20' > %t/sample.prof
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fprofile-sample-use=%t/sample.prof 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fsanitize-coverage-type=3 -fsanitize-coverage-trace-pc-guard 2>&1 | FileCheck -allow-empty -check-prefix=NOT-PARTITIONED %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o /dev/null %s -fexperimental-new-pass-manager 2>&1 | FileCheck -check-prefix=NEW-PM %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-cache-path=%t/whole -Rcodegen-cache -S -o /dev/null %s 2>&1 | FileCheck -check-prefix=WHOLE-FIRST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-cache-path=%t/whole -Rcodegen-cache -S -o /dev/null %s 2>&1 | FileCheck -check-prefix=WHOLE-SECOND %s
+
+// Partitions are reused only while their contents and the optimization
+// options stay the same.
+
+// FIRST: remark: 0 of [[N:[0-9]+]] partitions of the module reused from code generation cache
+// SECOND: remark: [[N:[0-9]+]] of [[N]] partitions of the module reused from code generation cache
+// CHANGED: remark: {{[0-9]+}} of {{[0-9]+}} partitions of the module reused
+// CHANGED: .globl _Z1ki
+
+// Sanitizer coverage instruments each partition, so the module is not split.
+// NOT-PARTITIONED-NOT: remark:
+
+// NEW-PM: warning: partitioning and caching the optimization pipeline is not supported with the new pass manager
+// NEW-PM-NOT: remark:
+
+// A module that is not split is cached as a whole.
+// WHOLE-FIRST: remark: 0 of 1 partitions of the module reused
+// WHOLE-SECOND: remark: 1 of 1 partitions of the module reused
+
+__attribute__((noinline)) int f(int x) { return x * x + 1; }
+__attribute__((noinline)) int g(int x) { return f(x) + 2; }
+int h(int x) { return g(x - 1); }
+
+#ifdef CHANGED
+int k(int x) { return x - 7; }
+#else
+int k(int x) { return x - 3; }
+#endif
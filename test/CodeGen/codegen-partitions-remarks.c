@@ -0,0 +1,19 @@
+// REQUIRES: x86-registered-target
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=2 -Rpass=inline -S -o /dev/null %s 2>&1 | FileCheck %s
+// RUN: rm -f %t.yaml
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=2 -opt-record-file %t.yaml -S -o /dev/null %s
+// RUN: FileCheck -check-prefix=YAML %s < %t.yaml
+
+// Remarks from the partitions of the module, which are optimized in contexts
+// of their own, are reported and written to the optimization record.
+
+static inline int twice(int x) { return 2 * x; }
+
+int f(int x) { return twice(x) + 1; }
+int g(int x) { return twice(x) - 1; }
+
+// CHECK-DAG: remark: twice inlined into f
+// CHECK-DAG: remark: twice inlined into g
+
+// YAML: --- !Passed
+// YAML: Pass: inline
@@ -0,0 +1,28 @@
+// REQUIRES: x86-registered-target
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -S -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-partitions=4 -emit-llvm -o - %s | FileCheck -check-prefix=IR %s
+
+// Functions split across partitions are all emitted into the single output,
+// inline functions used from another partition are kept, and internal
+// functions stay internal.
+
+__attribute__((noinline)) inline int twice(int x) { return 2 * x; }
+
+__attribute__((noinline)) static int helper(int x) { return x * x + 1; }
+
+int f(int x) { return twice(x) + helper(x); }
+int g(int x) { return twice(x + 1); }
+int h(int x) { return helper(x - 1); }
+int k(int x) { return x - 3; }
+
+// CHECK-DAG: .globl _Z1fi
+// CHECK-DAG: .globl _Z1gi
+// CHECK-DAG: .globl _Z1hi
+// CHECK-DAG: .globl _Z1ki
+// CHECK-DAG: .weak _Z5twicei
+// CHECK-DAG: {{^}}_ZL6helperi:
+// CHECK-NOT: .globl _ZL6helperi
+
+// IR output is not affected by partitioning.
+// IR-DAG: define linkonce_odr i32 @_Z5twicei
+// IR-DAG: define internal i32 @_ZL6helperi
@@ -0,0 +1,45 @@
+// REQUIRES: x86-registered-target
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o %t/thin.bc %s 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: llvm-dis %t/thin.bc -o - | FileCheck %s
+// RUN: llvm-bcanalyzer -dump %t/thin.bc | FileCheck -check-prefix=SUMMARY %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o %t/full.bc %s 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: llvm-dis %t/full.bc -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s 2>&1 | FileCheck -check-prefix=TWO-CACHED %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -mllvm -inline-threshold=1000 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -fveclib=SVML 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -fdebug-info-for-profiling 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: echo 'function: { source: _Z1hi, target: renamed_h }' > %t/rewrite.map
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -frewrite-map-file %t/rewrite.map 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -frewrite-map-file %t/rewrite.map 2>&1 | FileCheck -check-prefix=TWO-CACHED %s
+// RUN: echo 'function: { source: _Z1gi, target: renamed_g }' > %t/rewrite.map
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -flto=thin -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s -frewrite-map-file %t/rewrite.map 2>&1 | FileCheck -check-prefix=TWO %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-threads=2 -fcodegen-partitions=4 -fcodegen-cache-path=%t/cache -Rcodegen-cache -S -o - %s 2>&1 | FileCheck -check-prefix=FOUR %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -fcodegen-threads=2 -fcodegen-cache-path=%t/cache -Rcodegen-cache -emit-llvm-bc -o /dev/null %s 2>&1 | FileCheck -allow-empty -check-prefix=NOLTO %s
+
+// Without -fcodegen-partitions, the module is split into one partition per
+// thread. The bitcode written for the LTO pre-link step is produced from the
+// partitions linked back together, and keeps the summary for -flto=thin. The
+// cached partitions are only reused for the same kind of LTO, the same
+// optimization options and the same contents of the files the pipeline reads.
+
+// TWO: remark: 0 of 2 partitions of the module reused
+// TWO-CACHED: remark: 2 of 2 partitions of the module reused
+// FOUR: remark: 0 of 4 partitions of the module reused
+// NOLTO-NOT: remark
+
+// CHECK-DAG: define i32 @_Z1fi
+// CHECK-DAG: define i32 @_Z1gi
+// CHECK-DAG: define i32 @_Z1hi
+// CHECK-DAG: define linkonce_odr i32 @_Z5twicei
+// CHECK-DAG: define internal {{.*}}i32 @_ZL6helperi
+
+// SUMMARY: <GLOBALVAL_SUMMARY_BLOCK
+
+__attribute__((noinline)) inline int twice(int x) { return 2 * x; }
+
+__attribute__((noinline)) static int helper(int x) { return x * x + 1; }
+
+int f(int x) { return twice(x) + helper(x); }
+int g(int x) { return twice(x + 1); }
+int h(int x) { return helper(x - 1); }
@@ -0,0 +1,74 @@
+// RUN: %clang_cc1 -triple x86_64-linux -O1 -disable-llvm-passes %s \
+// RUN:     -fstruct-path-tbaa-arrays -emit-llvm -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux -O1 -disable-llvm-passes %s \
+// RUN:     -emit-llvm -o - | FileCheck -check-prefix=NOARRAYS %s
+//
+// Check that with -fstruct-path-tbaa-arrays, accesses to elements of array
+// members are described relative to the enclosing struct, at the offset of
+// the array, so that they don't alias the other members.
+
+struct Point { float x, y; };
+
+struct S {
+  int n;
+  float a[4];
+  float b[4];
+  float m[2][2];
+  Point pts[2];
+  char buf[8];
+};
+
+float load_a(S *s, int i) {
+// CHECK-LABEL: define float @_Z6load_aP1Si(
+// CHECK: load float, {{.*}}, !tbaa [[TAG_S_a:![0-9]+]]
+// NOARRAYS-LABEL: define float @_Z6load_aP1Si(
+// NOARRAYS: load float, {{.*}}, !tbaa [[TAG_float:![0-9]+]]
+  return s->a[i];
+}
+
+void store_b(S *s, int i, float f) {
+// CHECK-LABEL: define void @_Z7store_bP1Sif(
+// CHECK: store float {{.*}}, float* %arrayidx{{.*}}, !tbaa [[TAG_S_b:![0-9]+]]
+// NOARRAYS-LABEL: define void @_Z7store_bP1Sif(
+// NOARRAYS: store float {{.*}}, float* %arrayidx{{.*}}, !tbaa [[TAG_float]]
+  s->b[i] = f;
+}
+
+float load_m(S *s, int i, int j) {
+// CHECK-LABEL: define float @_Z6load_mP1Sii(
+// CHECK: load float, {{.*}}, !tbaa [[TAG_S_m:![0-9]+]]
+  return s->m[i][j];
+}
+
+float load_y(S *s, int i) {
+// CHECK-LABEL: define float @_Z6load_yP1Si(
+// CHECK: load float, {{.*}}, !tbaa [[TAG_S_pts_y:![0-9]+]]
+  return s->pts[i].y;
+}
+
+// Character arrays are often storage for objects of other types.
+char load_buf(S *s, int i) {
+// CHECK-LABEL: define signext i8 @_Z8load_bufP1Si(
+// CHECK: load i8, {{.*}}, !tbaa [[TAG_char:![0-9]+]]
+  return s->buf[i];
+}
+
+// A local array is not part of a struct.
+float load_local(int i) {
+// CHECK-LABEL: define float @_Z10load_locali(
+// CHECK: load float, {{.*}}, !tbaa [[TAG_float:![0-9]+]]
+  float l[4] = {1, 2, 3, 4};
+  return l[i];
+}
+
+// CHECK-DAG: [[TAG_S_a]] = !{[[TYPE_S:![0-9]+]], [[TYPE_float:![0-9]+]], i64 4}
+// CHECK-DAG: [[TAG_S_b]] = !{[[TYPE_S]], [[TYPE_float]], i64 20}
+// CHECK-DAG: [[TAG_S_m]] = !{[[TYPE_S]], [[TYPE_float]], i64 36}
+// CHECK-DAG: [[TAG_S_pts_y]] = !{[[TYPE_S]], [[TYPE_float]], i64 56}
+// CHECK-DAG: [[TAG_char]] = !{[[TYPE_char:![0-9]+]], [[TYPE_char]], i64 0}
+// CHECK-DAG: [[TAG_float]] = !{[[TYPE_float]], [[TYPE_float]], i64 0}
+// CHECK-DAG: [[TYPE_S]] = !{!"_ZTS1S", [[TYPE_int:![0-9]+]], i64 0, [[TYPE_float]], i64 4, [[TYPE_float]], i64 20, [[TYPE_float]], i64 36, [[TYPE_Point:![0-9]+]], i64 52, [[TYPE_char]], i64 68}
+// CHECK-DAG: [[TYPE_Point]] = !{!"_ZTS5Point", [[TYPE_float]], i64 0, [[TYPE_float]], i64 4}
+
+// NOARRAYS-DAG: [[TAG_float]] = !{[[TYPE_float:![0-9]+]], [[TYPE_float]], i64 0}
+// NOARRAYS-DAG: !{!"_ZTS1S", [[TYPE_int:![0-9]+]], i64 0, [[TYPE_char:![0-9]+]], i64 4, [[TYPE_char]], i64 20, [[TYPE_char]], i64 36, [[TYPE_char]], i64 52, [[TYPE_char]], i64 68}
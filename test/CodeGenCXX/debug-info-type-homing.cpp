@@ -0,0 +1,57 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -debug-info-kind=limited \
+// RUN:     -fdebug-type-homing %s -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -debug-info-kind=limited \
+// RUN:     %s -o - | FileCheck -check-prefix=NOHOMING %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -debug-info-kind=limited \
+// RUN:     -fdebug-type-homing %s -o /dev/null -print-stats 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+
+// Its constructor is emitted in another translation unit.
+struct Elsewhere {
+  Elsewhere();
+  int x;
+};
+
+struct Here {
+  Here();
+  int y;
+};
+Here::Here() : y() {}
+
+// Aggregates are created without a constructor call.
+struct Aggregate {
+  int z;
+};
+
+// Its only constructors that can create an object are deleted.
+struct Deleted {
+  Deleted() = delete;
+  Deleted(int) = delete;
+  Deleted(const Deleted &);
+  int w = 0;
+};
+
+int f(Elsewhere &E, Here &H, Aggregate &A, Deleted &D) {
+  return E.x + H.y + A.z + D.w;
+}
+
+// Nothing but its constructor refers to it.
+struct Unused {
+  Unused();
+  int u;
+};
+Unused::Unused() : u() {}
+
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Elsewhere",{{.*}}flags: DIFlagFwdDecl
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Here",{{.*}}elements:
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Aggregate",{{.*}}elements:
+// CHECK-DAG: !DICompositeType(tag: DW_TAG_structure_type, name: "Deleted",{{.*}}elements:
+// CHECK-DAG: !DICompileUnit({{.*}}retainedTypes: ![[RETAINED:[0-9]+]]
+// CHECK-DAG: ![[RETAINED]] = !{{{.*}}![[UNUSED:[0-9]+]]{{[,}]}}
+// CHECK-DAG: ![[UNUSED]] = !DICompositeType(tag: DW_TAG_structure_type, name: "Unused",{{.*}}elements:
+
+// NOHOMING: !DICompositeType(tag: DW_TAG_structure_type, name: "Elsewhere",{{.*}}elements:
+
+// STATS: *** Debug Info Stats:
+// STATS-NEXT: 4 record types defined, with {{[0-9]+}} members
+// STATS-NEXT: 1 record types only declared
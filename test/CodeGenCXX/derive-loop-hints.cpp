@@ -0,0 +1,140 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm -o - %s -fderive-loop-hints -Rloop-hints -verify | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -std=c++11 -emit-llvm -o - %s | FileCheck -check-prefix=CHECK-NOHINTS %s
+
+// CHECK-NOHINTS-NOT: llvm.mem.parallel_loop_access
+
+namespace std {
+template <typename T, unsigned long N> struct array {
+  T elems[N];
+  T *begin() { return elems; }
+  T *end() { return elems + N; }
+};
+
+template <typename T> struct vector {
+  T *first, *last;
+  T *begin() { return first; }
+  T *end() { return last; }
+};
+}
+
+struct Point {
+  float x, y;
+};
+
+int f(int);
+
+// CHECK-LABEL: define void @_Z5scaleRA8_dd(
+void scale(double (&a)[8], double s) {
+  // expected-remark@+1 {{loop over 'double [8]' of 8 elements marked parallel: its iterations are independent}}
+  for (double &x : a)
+    x *= s;
+  // CHECK: for.body:
+  // CHECK: store double {{.*}}, !llvm.mem.parallel_loop_access ![[SCALE:[0-9]+]]
+  // CHECK: br label %for.cond, !llvm.loop ![[SCALE]]
+}
+
+// CHECK-LABEL: define void @_Z9normalizeRSt5arrayI5PointLm4EE(
+void normalize(std::array<Point, 4> &points) {
+  // expected-remark@+1 {{loop over 'std::array<Point, 4>' of 4 elements marked parallel}}
+  for (Point &p : points) {
+    float len = p.x + p.y;
+    p.x /= len;
+    p.y /= len;
+  }
+  // CHECK: store float {{.*}}, !llvm.mem.parallel_loop_access ![[NORMALIZE:[0-9]+]]
+  // CHECK: br label %for.cond, !llvm.loop ![[NORMALIZE]]
+}
+
+// CHECK-LABEL: define void @_Z5clampRSt6vectorIiEi(
+void clamp(std::vector<int> &v, int hi) {
+  // expected-remark@+1 {{loop over 'std::vector<int>' marked parallel}}
+  for (int &x : v)
+    x = x > hi ? hi : x;
+  // CHECK: store i32 {{.*}}, !llvm.mem.parallel_loop_access ![[CLAMP:[0-9]+]]
+  // CHECK: br label %for.cond, !llvm.loop ![[CLAMP]]
+}
+
+// CHECK-LABEL: define i32 @_Z3sumRSt6vectorIiE(
+int sum(std::vector<int> &v) {
+  int total = 0;
+  // expected-remark@+1 {{loop over 'std::vector<int>' not marked parallel: the loop uses a variable declared outside it other than by reading its value}}
+  for (int x : v)
+    total += x;
+  return total;
+  // CHECK-NOT: llvm.mem.parallel_loop_access
+  // CHECK: ret i32
+}
+
+void fill(char (&a)[5000000000]) {
+  // expected-remark@+1 {{loop over 'char [5000000000]' of 5000000000 elements marked parallel}}
+  for (char &c : a)
+    c = 0;
+}
+
+void apply(std::vector<int> &v) {
+  // expected-remark@+1 {{not marked parallel: the loop calls a function}}
+  for (int &x : v)
+    x = f(x);
+}
+
+void clear(std::vector<int *> &v) {
+  // expected-remark@+1 {{not marked parallel: the loop accesses memory through a pointer}}
+  for (int *p : v)
+    *p = 0;
+}
+
+void shift(int (&a)[8]) {
+  // expected-remark@+1 {{not marked parallel: the loop accesses memory through a pointer}}
+  for (int &x : a)
+    x = a[0];
+}
+
+void gather(int (&a)[8]) {
+  int *p = a;
+  // expected-remark@+1 {{not marked parallel: the loop accesses memory through a pointer}}
+  for (int &x : a)
+    x = *p;
+}
+
+void transpose(int (&m)[4][4]) {
+  // expected-remark@+1 {{loop over 'int [4][4]' not marked parallel: the loop accesses memory through a pointer}}
+  for (int (&row)[4] : m)
+    // expected-remark@+1 {{loop over 'int [4]' not marked parallel: the loop accesses memory through a pointer}}
+    for (int &x : row)
+      x = m[0][0];
+}
+
+void nested(int (&m)[4][4]) {
+  // expected-remark@+1 {{loop over 'int [4][4]' not marked parallel: the loop accesses memory through a pointer}}
+  for (int (&row)[4] : m)
+    // expected-remark@+1 {{loop over 'int [4]' of 4 elements marked parallel}}
+    for (int &x : row)
+      x = 0;
+}
+
+void aliased(int (&a)[8], const int &k) {
+  // expected-remark@+1 {{not marked parallel: the loop uses a variable declared outside it other than by reading its value}}
+  for (int &x : a)
+    x += k;
+}
+
+void counted(int (&a)[8]) {
+  // expected-remark@+1 {{not marked parallel: the loop uses a variable declared outside it other than by reading its value}}
+  for (int &x : a) {
+    static int n;
+    x = n++;
+  }
+}
+
+struct List {
+  int *begin();
+  int *end();
+};
+
+void list(List &l) {
+  // expected-remark@+1 {{loop over 'List' not marked parallel: the range is not an array, 'std::array', or 'std::vector'}}
+  for (int &x : l)
+    x = 0;
+}
+
+// CHECK: ![[SCALE]] = distinct !{![[SCALE]]}
@@ -0,0 +1,75 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: cp %s %t/a.cpp && cp %s %t/b.cpp
+// RUN: cd %t && %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only -femit-instantiation-homes=%t/a.homes a.cpp -DA_EXTRA
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only -femit-instantiation-homes=%t/b.homes %t/b.cpp -DTU_B
+// RUN: cat %t/a.homes %t/b.homes > %t/manifest
+// RUN: FileCheck -check-prefix=MANIFEST %s < %t/manifest
+//
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/./a.cpp -finstantiation-homes=%t/manifest | FileCheck -check-prefix=HOME %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only %t/a.cpp -finstantiation-homes=%t/manifest 2>&1 | FileCheck -check-prefix=STALE %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/b.cpp -DTU_B -finstantiation-homes=%t/manifest | FileCheck -check-prefix=O0 %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/b.cpp -DTU_B -O1 -disable-llvm-passes -finstantiation-homes=%t/manifest | FileCheck -check-prefix=O1 %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only %t/b.cpp -DTU_B -finstantiation-homes=%t/manifest -print-stats 2>&1 | FileCheck -check-prefix=STATS %s
+// RUN: not %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only %t/a.cpp -finstantiation-homes=%t/missing 2>&1 | FileCheck -check-prefix=MISSING %s
+
+// Functions used by both translation units are defined by the first one that
+// lists them; the others only see them for inlining.
+
+template <typename T> T add(T a, T b) { return a + b; }
+inline int helper(int x) { return add(x, 1); }
+template <typename T> T only_b(T a) { return a * 2; }
+
+struct S {
+  S() {}
+};
+
+// Only used by the first translation unit when the manifest was written.
+inline int extra(int x) { return x + 5; }
+template <typename T> T extra_tmpl(T a) { return a - 5; }
+
+int use(int x) {
+  S s;
+#ifdef A_EXTRA
+  x = extra(extra_tmpl(x));
+#endif
+#ifdef TU_B
+  x = only_b(x);
+#endif
+  return helper(x);
+}
+
+// MANIFEST-DAG: {{^}}_Z3addIiET_S0_S0_ {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_Z6helperi {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_ZN1SC1Ev {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_ZN1SC2Ev {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_Z6only_bIiET_S0_ {{.*}}b.cpp{{$}}
+// MANIFEST-DAG: {{^}}_Z5extrai {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_Z10extra_tmplIiET_S0_ {{.*}}a.cpp{{$}}
+
+// HOME-DAG: define weak_odr i32 @_Z6helperi(
+// HOME-DAG: define weak_odr i32 @_Z3addIiET_S0_S0_(
+// HOME-DAG: define weak_odr void @_ZN1SC1Ev(
+// HOME-DAG: define weak_odr void @_ZN1SC2Ev(
+// HOME-DAG: define weak_odr i32 @_Z5extrai(
+
+// A template that is no longer instantiated cannot be defined for the others.
+// STALE: warning: instantiation homes {{.*}}manifest are out of date: 1 symbols assigned to this translation unit are not defined here, including '_Z10extra_tmplIiET_S0_'
+
+// At -O0 the definitions are not needed.
+// O0-DAG: declare i32 @_Z6helperi(
+// O0-DAG: declare void @_ZN1SC1Ev(
+// O0-DAG: define weak_odr i32 @_Z6only_bIiET_S0_(
+// O0-NOT: @_Z3addIiET_S0_S0_(
+
+// O1-NOT: $_Z6helperi = comdat
+// O1-DAG: define available_externally i32 @_Z6helperi(
+// O1-DAG: define available_externally i32 @_Z3addIiET_S0_S0_(
+// O1-DAG: define available_externally void @_ZN1SC1Ev(
+// O1-DAG: define weak_odr i32 @_Z6only_bIiET_S0_(
+
+// STATS: *** Instantiation Home Stats:
+// STATS-NEXT: 7 symbols in the manifest
+// STATS-NEXT: 2 functions left to the translation unit that defines them
+// STATS-NEXT: 1 functions defined for other translation units
+
+// MISSING: error: could not read instantiation homes {{.*}}missing
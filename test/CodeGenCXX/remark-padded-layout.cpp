@@ -0,0 +1,79 @@
+// RUN: %clang_cc1 -triple=x86_64-none-none -Rpadded-layout -verify %s -emit-llvm-only
+
+struct A { // expected-remark {{struct 'A' is 24 bytes, 14 of which are padding; ordering its fields as 'd', 'c', 'e' would make it 16 bytes}}
+  char c;
+  double d;
+  char e;
+};
+A a;
+
+struct B { // expected-remark {{struct 'B' is 16 bytes, 7 of which are padding}}
+  double d;
+  char c;
+};
+B b;
+
+struct C {
+  int x;
+  int y;
+};
+C c;
+
+struct D {
+  char pad[60];
+  char name[8]; // expected-remark {{field 'name' at offset 60 of 'D' crosses a 64-byte cache line boundary}}
+};
+D d;
+
+// Only the fields of a derived class are moved.
+struct E : B { // expected-remark {{struct 'E' is 24 bytes, 7 of which are padding}}
+  char f;
+};
+E e;
+
+class F { // expected-remark {{class 'F' is 12 bytes, 6 of which are padding; ordering its fields as 'i', 'c1', 'c2' would make it 8 bytes}}
+  char c1;
+  int i;
+  char c2;
+public:
+  F();
+};
+F *f() { return new F; }
+
+template <typename T> struct W { // expected-remark {{struct 'W<int>' is 8 bytes, 3 of which are padding}}
+  char c;
+  T t;
+};
+W<int> w;
+
+union U {
+  char c;
+  double d;
+};
+U u;
+
+struct P {
+  char c;
+  int i;
+} __attribute__((packed));
+P p;
+
+struct G {
+  int bits : 3;
+  double d;
+};
+G g;
+
+// Records in system headers are left alone.
+# 1 "system.h" 1 3
+struct S {
+  char c;
+  double d;
+  char e;
+};
+template <typename T> struct SW {
+  char c;
+  T t;
+};
+S s;
+SW<int> sw;
@@ -0,0 +1,87 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: cp %s %t/a.cpp && cp %s %t/b.cpp
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only -femit-instantiation-homes=%t/a.homes %t/a.cpp -print-stats 2>&1 | FileCheck -check-prefix=STATS-A %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only -femit-instantiation-homes=%t/b.homes %t/b.cpp
+// RUN: cat %t/a.homes %t/b.homes > %t/manifest
+// RUN: FileCheck -check-prefix=MANIFEST %s < %t/manifest
+//
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/a.cpp -finstantiation-homes=%t/manifest | FileCheck -check-prefix=HOME %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/b.cpp -finstantiation-homes=%t/manifest | FileCheck -check-prefix=ELSEWHERE %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm-only %t/b.cpp -finstantiation-homes=%t/manifest -print-stats 2>&1 | FileCheck -check-prefix=STATS-B %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -emit-llvm -o - %t/b.cpp -DKEYED -DEXPLICIT -finstantiation-homes=%t/manifest | FileCheck -check-prefix=NOT-HOMED %s
+
+// Classes without a key function have their vtables, VTTs and type info
+// defined by the first translation unit that lists them.
+
+struct Widget {
+  Widget();
+  virtual ~Widget() {}
+  virtual int get() { return 1; }
+};
+
+struct Derived : virtual Widget {
+  Derived();
+  int get() override { return 2; }
+};
+
+Widget::Widget() {}
+Derived::Derived() {}
+
+// Gaining a key function decides where the vtable goes again.
+struct Keyed {
+  Keyed();
+#ifdef KEYED
+  virtual int key();
+#else
+  virtual int key() { return 3; }
+#endif
+};
+
+Keyed::Keyed() {}
+#ifdef KEYED
+int Keyed::key() { return 3; }
+#endif
+
+// An explicit instantiation definition always defines the vtable.
+template <typename T> struct Tmpl {
+  virtual T get() { return T(); }
+};
+#ifdef EXPLICIT
+template struct Tmpl<int>;
+#endif
+
+int useTmpl() {
+  Tmpl<int> T;
+  return T.get();
+}
+
+// MANIFEST-DAG: {{^}}_ZTV6Widget {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_ZTV7Derived {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_ZTV5Keyed {{.*}}a.cpp{{$}}
+// MANIFEST-DAG: {{^}}_ZTV4TmplIiE {{.*}}a.cpp{{$}}
+
+// HOME-DAG: @_ZTV6Widget = weak_odr unnamed_addr constant
+// HOME-DAG: @_ZTV7Derived = weak_odr unnamed_addr constant
+// HOME-DAG: @_ZTT7Derived = weak_odr unnamed_addr constant
+// HOME-DAG: @_ZTI7Derived = weak_odr constant
+
+// ELSEWHERE-DAG: @_ZTV6Widget = external unnamed_addr constant
+// ELSEWHERE-DAG: @_ZTV7Derived = external unnamed_addr constant
+// ELSEWHERE-DAG: @_ZTV5Keyed = external unnamed_addr constant
+// ELSEWHERE-DAG: @_ZTV4TmplIiE = external unnamed_addr constant
+
+// NOT-HOMED-DAG: @_ZTV6Widget = external unnamed_addr constant
+// NOT-HOMED-DAG: @_ZTV5Keyed = unnamed_addr constant
+// NOT-HOMED-DAG: @_ZTV4TmplIiE = weak_odr unnamed_addr constant
+
+// STATS-A: *** VTable Stats:
+// STATS-A-NEXT: 4 vtable layouts computed
+// STATS-A-NEXT: 4 classes with vtables emitted, 1 VTTs, 0 construction vtables
+// STATS-A-NEXT: {{[0-9]+\.[0-9]+}} seconds emitting vtables
+
+// STATS-B: *** Instantiation Home Stats:
+// STATS-B: 4 vtables left to the translation unit that defines them
+// STATS-B-NEXT: 0 vtables defined for other translation units
+// STATS-B: *** VTable Stats:
+// STATS-B-NEXT: 4 vtable layouts computed
+// STATS-B-NEXT: 0 classes with vtables emitted, 0 VTTs, 0 construction vtables
@@ -158,6 +158,19 @@
 // CHECK-VECTORIZE: "-vectorize-loops"
 // CHECK-NO-VECTORIZE-NOT: "-vectorize-loops"
 
+// RUN: %clang -### -S -fderive-loop-hints %s 2>&1 | FileCheck -check-prefix=CHECK-DERIVE-LOOP-HINTS %s
+// RUN: %clang -### -S -fderive-loop-hints -fno-derive-loop-hints %s 2>&1 | FileCheck -check-prefix=CHECK-NO-DERIVE-LOOP-HINTS %s
+// CHECK-DERIVE-LOOP-HINTS: "-fderive-loop-hints"
+// CHECK-NO-DERIVE-LOOP-HINTS-NOT: "-fderive-loop-hints"
+
+// RUN: %clang -### -S -fstruct-path-tbaa-arrays %s 2>&1 | FileCheck -check-prefix=CHECK-STRUCT-PATH-TBAA-ARRAYS %s
+// RUN: %clang -### -S -fstruct-path-tbaa-arrays -fno-struct-path-tbaa-arrays %s 2>&1 | FileCheck -check-prefix=CHECK-NO-STRUCT-PATH-TBAA-ARRAYS %s
+// CHECK-STRUCT-PATH-TBAA-ARRAYS: "-fstruct-path-tbaa-arrays"
+// CHECK-NO-STRUCT-PATH-TBAA-ARRAYS-NOT: "-fstruct-path-tbaa-arrays"
+
+// RUN: %clang -### -S -fcodegen-threads=4 %s 2>&1 | FileCheck -check-prefix=CHECK-CODEGEN-THREADS %s
+// CHECK-CODEGEN-THREADS: "-fcodegen-threads=4"
+
 // RUN: %clang -### -S -fslp-vectorize %s 2>&1 | FileCheck -check-prefix=CHECK-SLP-VECTORIZE %s
 // RUN: %clang -### -S -fno-slp-vectorize -fslp-vectorize %s 2>&1 | FileCheck -check-prefix=CHECK-SLP-VECTORIZE %s
 // RUN: %clang -### -S -fno-slp-vectorize %s 2>&1 | FileCheck -check-prefix=CHECK-NO-SLP-VECTORIZE %s
@@ -503,3 +516,17 @@
 // CHECK-WINDOWS-ISO10646: "-fwchar-type=int"
 // CHECK-WINDOWS-ISO10646: "-fsigned-wchar"
 
+
+// RUN: %clang -### -S -finstantiation-homes=manifest.txt -femit-instantiation-homes=a.homes %s 2>&1 | FileCheck -check-prefix=CHECK-INSTANTIATION-HOMES %s
+// CHECK-INSTANTIATION-HOMES: "-finstantiation-homes=manifest.txt"
+// CHECK-INSTANTIATION-HOMES: "-femit-instantiation-homes=a.homes"
+
+// RUN: %clang -### -S -fprofile-cold-optnone %s 2>&1 | FileCheck -check-prefix=CHECK-PROFILE-COLD-OPTNONE %s
+// RUN: %clang -### -S -fprofile-cold-optnone -fno-profile-cold-optnone %s 2>&1 | FileCheck -check-prefix=CHECK-NO-PROFILE-COLD-OPTNONE %s
+// CHECK-PROFILE-COLD-OPTNONE: "-fprofile-cold-optnone"
+// CHECK-NO-PROFILE-COLD-OPTNONE-NOT: "-fprofile-cold-optnone"
+
+// RUN: %clang -### -S -fprofile-instr-generate -fcoverage-counters=fast %s 2>&1 | FileCheck -check-prefix=CHECK-COVERAGE-COUNTERS %s
+// RUN: %clang -### -S -fcoverage-counters=fast %s 2>&1 | FileCheck -check-prefix=CHECK-COVERAGE-COUNTERS-NO-PROFILE %s
+// CHECK-COVERAGE-COUNTERS: "-fcoverage-counters=fast"
+// CHECK-COVERAGE-COUNTERS-NO-PROFILE: error: invalid argument '-fcoverage-counters=fast' only allowed with '-fprofile-instr-generate'
@@ -143,6 +143,15 @@
 // RUN: %clang -### -fdebug-types-section -fno-debug-types-section %s 2>&1 \
 // RUN:        | FileCheck -check-prefix=NOFDTS %s
 //
+// RUN: %clang -### -target x86_64-linux-gnu -g -fdebug-type-homing %s 2>&1 \
+// RUN:        | FileCheck -check-prefix=TYPEHOMING %s
+// RUN: %clang -### -target x86_64-linux-gnu -g -fstandalone-debug \
+// RUN:        -fdebug-type-homing %s 2>&1 \
+// RUN:        | FileCheck -check-prefix=NOTYPEHOMING %s
+// RUN: %clang -### -target x86_64-linux-gnu -g -fdebug-type-homing \
+// RUN:        -fno-debug-type-homing %s 2>&1 \
+// RUN:        | FileCheck -check-prefix=NOTYPEHOMING %s
+//
 // RUN: %clang -### -g -gno-column-info %s 2>&1 \
 // RUN:        | FileCheck -check-prefix=NOCI %s
 //
@@ -229,6 +238,9 @@
 //
 // NOFDTS-NOT: "-backend-option" "-generate-type-units"
 //
+// TYPEHOMING: "-fdebug-type-homing"
+// NOTYPEHOMING-NOT: "-fdebug-type-homing"
+//
 // CI: "-dwarf-column-info"
 //
 // NOCI-NOT: "-dwarf-column-info"
@@ -27,6 +27,16 @@
 // RUN: %clang -fmodules-validate-once-per-build-session -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_ONCE_ERR %s
 // MODULES_VALIDATE_ONCE_ERR: option '-fmodules-validate-once-per-build-session' requires '-fbuild-session-timestamp=<seconds since Epoch>' or '-fbuild-session-file=<file>'
 
+// RUN: %clang -fbuild-session-timestamp=123 -fmodules-share-session-validation -### %s 2>&1 | FileCheck -check-prefix=MODULES_SHARE_SESSION_VALIDATION %s
+// MODULES_SHARE_SESSION_VALIDATION: -fbuild-session-timestamp=123
+// MODULES_SHARE_SESSION_VALIDATION: -fmodules-share-session-validation
+
+// RUN: %clang -fmodules-share-session-validation -### %s 2>&1 | FileCheck -check-prefix=MODULES_SHARE_SESSION_VALIDATION_ERR %s
+// MODULES_SHARE_SESSION_VALIDATION_ERR: option '-fmodules-share-session-validation' requires '-fbuild-session-timestamp=<seconds since Epoch>' or '-fbuild-session-file=<file>'
+
+// RUN: %clang -fvalidate-ast-input-files-content -### %s 2>&1 | FileCheck -check-prefix=VALIDATE_CONTENT %s
+// VALIDATE_CONTENT: -fvalidate-ast-input-files-content
+
 // RUN: %clang -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_SYSTEM_HEADERS_DEFAULT %s
 // MODULES_VALIDATE_SYSTEM_HEADERS_DEFAULT-NOT: -fmodules-validate-system-headers
 
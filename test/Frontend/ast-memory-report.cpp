@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -ast-memory-report %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -fsyntax-only -ast-memory-report=json %s 2>&1 | FileCheck %s --check-prefix=JSON
+// RUN: not %clang_cc1 -fsyntax-only -ast-memory-report=xml %s 2>&1 | FileCheck %s --check-prefix=BAD
+
+template <typename T> struct Box { T Value; };
+
+int twice(int x) { return x + x; }
+
+Box<int> b = {twice(1)};
+
+// CHECK: *** AST Memory Report:
+// CHECK-NEXT: {{[0-9]+}} bytes in {{[0-9]+}} allocations ({{[0-9]+}} bytes of slabs)
+// CHECK: By node kind
+// CHECK-DAG: {{[0-9]+}} ClassTemplateSpecializationDecl ({{[0-9]+}} + {{[0-9]+}})
+// CHECK-DAG: {{[0-9]+}} FunctionDecl ({{[0-9]+}} + {{[0-9]+}})
+// CHECK-DAG: {{[0-9]+}} CompoundStmt ({{[0-9]+}} + {{[0-9]+}})
+// CHECK-DAG: {{[0-9]+}} FunctionProtoType ({{[0-9]+}} + {{[0-9]+}})
+// CHECK: By file:
+// CHECK: {{[0-9]+}} {{.*}}ast-memory-report.cpp
+// CHECK: Other tables:
+// CHECK-DAG: ASTContext side tables
+// CHECK-DAG: DeclContext lookup tables
+// CHECK-DAG: Sema side tables
+
+// JSON: "allocated": {{[0-9]+}},
+// JSON: "kinds": [
+// JSON-DAG: {"kind": "FunctionDecl", "category": "Decl", "count": {{[0-9]+}}, "bytes": {{[0-9]+}}, "own": {{[0-9]+}}, "aux": {{[0-9]+}}}
+// JSON-DAG: {"kind": "CompoundStmt", "category": "Stmt", "count": {{[0-9]+}},
+// JSON: "files": [
+// JSON: {"file": "{{.*}}ast-memory-report.cpp", "bytes": {{[0-9]+}}}
+// JSON: "tables": [
+// JSON: {"table": "DeclContext lookup tables", "bytes": {{[0-9]+}}}
+
+// BAD: invalid value 'xml' in '-ast-memory-report=xml'
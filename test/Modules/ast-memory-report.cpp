@@ -0,0 +1,15 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t -I %S/Inputs/ast-memory-report -fsyntax-only -ast-memory-report %s 2>&1 | FileCheck %s
+
+// Building the module neither prints a report of its own nor stops the
+// importer's report from attributing what is parsed after the import.
+
+#include "a.h"
+
+int after_import(int x) { return x + a(x); }
+
+// CHECK: *** AST Memory Report:
+// CHECK-NOT: *** AST Memory Report:
+// CHECK: By file:
+// CHECK: {{[0-9]+}} {{.*}}ast-memory-report.cpp
+// CHECK-NOT: *** AST Memory Report:
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'namespace N { int a(); }' > %t/A.h
+// RUN: echo 'namespace N { int b(); }' > %t/B.h
+// RUN: echo 'module A { header "A.h" } module B { header "B.h" }' > %t/module.modulemap
+
+// Build the modules, and the global module index.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fdisable-module-hash -I %t -fsyntax-only -verify %s
+// RUN: ls %t/cache | grep modules.idx
+
+// Only the module files that declare a name are searched for it.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fdisable-module-hash -I %t -fsyntax-only -verify %s \
+// RUN:            -print-stats 2>&1 | FileCheck %s
+// CHECK: *** Global Module Index Statistics:
+// CHECK: declaration name lookups found {{[0-9.]+}} module files each, of 2 known
+
+// expected-no-diagnostics
+
+#include "A.h"
+#include "B.h"
+
+int x = N::a() + N::b();
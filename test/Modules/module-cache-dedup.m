@@ -0,0 +1,54 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '// A' > %t/A.h
+// RUN: echo 'module A { header "A.h" }' > %t/module.modulemap
+
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-cache-dedup -fmodules-cache-stats
+// RUN: ls %t/cache/objects | count 1
+
+// Building the same module again produces an identical module file, which
+// shares the stored one.
+// RUN: find %t/cache -name 'A-*.pcm' | xargs rm
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-cache-dedup -fmodules-cache-stats
+// RUN: ls %t/cache/objects | count 1
+
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-cache-dedup -fmodules-cache-stats \
+// RUN:            -print-stats 2>&1 | FileCheck -check-prefix=PRINT-STATS %s
+
+// RUN: %clang_cc1 -print-module-cache-stats -fmodules-cache-path=%t/cache \
+// RUN:   | FileCheck %s
+
+// PRINT-STATS: *** Module Cache Stats:
+// PRINT-STATS-NEXT: 1 hits, 0 misses (0 missing, 0 out of date), 0 failed builds
+
+// CHECK: *** Module Cache Stats for '{{.*}}cache':
+// CHECK-NEXT: 1 module files in 1 configurations
+// CHECK-NEXT: 1 hits, 2 misses (2 missing, 0 out of date), 0 failed builds
+// CHECK-NEXT: 0 module files built ahead of their import
+// CHECK-NEXT: 1 module files stored by content, 1 deduplicated
+
+// When the cache is pruned, it is limited to its maximum size by removing the
+// least recently used module files. The module file this compilation uses was
+// used last, so it stays.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/lru \
+// RUN:            -fsyntax-only %s -I %t -fmodules-cache-dedup
+// RUN: mkdir %t/lru/other
+// RUN: dd if=/dev/zero of=%t/lru/other/Oldest.pcm bs=1024 count=400 2>/dev/null
+// RUN: dd if=/dev/zero of=%t/lru/other/Older.pcm bs=1024 count=400 2>/dev/null
+// RUN: dd if=/dev/zero of=%t/lru/other/Old.pcm bs=1024 count=400 2>/dev/null
+// RUN: touch -a -t 201101010000 %t/lru/other/Oldest.pcm
+// RUN: touch -a -t 201101020000 %t/lru/other/Older.pcm
+// RUN: touch -a -t 201101030000 %t/lru/other/Old.pcm
+// RUN: touch -m -a -t 201101010000 %t/lru/modules.timestamp
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/lru \
+// RUN:            -fsyntax-only %s -I %t -fmodules-cache-dedup \
+// RUN:            -fmodules-prune-interval=172800 \
+// RUN:            -fmodules-prune-after=1000000000 -fmodules-cache-max-size=1
+// RUN: not ls %t/lru/other/Oldest.pcm
+// RUN: ls %t/lru/other/Older.pcm %t/lru/other/Old.pcm
+// RUN: find %t/lru -name 'A-*.pcm' | count 1
+
+@import A;
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#warning in Top' > %t/Top.h
+// RUN: echo '#include "Top.h"' > %t/Bottom.h
+// RUN: echo 'module Top { header "Top.h" export * }' > %t/module.modulemap
+// RUN: echo 'module Bottom { header "Bottom.h" export * }' >> %t/module.modulemap
+
+// Diagnostics of modules built on the scheduler's threads are reported to the
+// importer's consumer, with their locations, while the module is reported as
+// built.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -Rmodule-build -fmodules-build-threads=4 \
+// RUN:            -serialize-diagnostics %t/diags.dia 2>&1 | FileCheck %s
+// RUN: c-index-test -read-diagnostics %t/diags.dia 2>&1 \
+// RUN:   | FileCheck -check-prefix=SERIALIZED %s
+
+// CHECK: remark: building module 'Top' as
+// CHECK-NEXT: Top.h:1:2: warning: in Top
+// CHECK-NEXT: #warning in Top
+// CHECK: remark: finished building module 'Top'
+
+// SERIALIZED: Top.h:1:2: warning: in Top
+
+@import Bottom;
@@ -0,0 +1,26 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '// Top' > %t/Top.h
+// RUN: echo '#include "Top.h"' > %t/Bottom.h
+// RUN: echo 'module Top { header "Top.h" export * }' > %t/module.modulemap
+// RUN: echo 'module Bottom { header "Bottom.h" export * }' >> %t/module.modulemap
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-build-threads=4
+
+// Make it look like another process is building Top, and have it finish a
+// little later.
+// RUN: rm %t/cache/*/Bottom-*.pcm
+// RUN: for f in %t/cache/*/Top-*.pcm; do echo $f > %t/top-path; mv $f %t/Top.pcm; echo 'elsewhere 1' > $f.lock; done
+// RUN: (sleep 1; mv %t/Top.pcm `cat %t/top-path`; rm `cat %t/top-path`.lock) & \
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -Rmodule-build -fmodules-build-threads=4 \
+// RUN:            2>&1 | FileCheck %s
+
+// A module written by another process is not reported as built here.
+// CHECK-NOT: remark: building module 'Top'
+// CHECK: remark: building module 'Bottom' as
+// CHECK-NOT: remark: building module 'Top'
+// CHECK: remark: finished building module 'Bottom'
+
+@import Bottom;
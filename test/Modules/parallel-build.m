@@ -0,0 +1,33 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '// Top' > %t/Top.h
+// RUN: echo '#include "Top.h"' > %t/Left.h
+// RUN: echo '#include "Top.h"' > %t/Right.h
+// RUN: echo '#include "Left.h"' > %t/Bottom.h
+// RUN: echo '#include "Right.h"' >> %t/Bottom.h
+// RUN: echo 'module Top { header "Top.h" export * }' > %t/module.modulemap
+// RUN: echo 'module Left { header "Left.h" export * }' >> %t/module.modulemap
+// RUN: echo 'module Right { header "Right.h" export * }' >> %t/module.modulemap
+// RUN: echo 'module Bottom { header "Bottom.h" export * }' >> %t/module.modulemap
+
+// The modules that Bottom depends on are built before Bottom, so building
+// Bottom builds nothing else.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -Rmodule-build -fmodules-build-threads=4 \
+// RUN:            2>&1 | FileCheck %s
+
+// With everything built, nothing is built again.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -Rmodule-build -fmodules-build-threads=4 \
+// RUN:            2>&1 | FileCheck -allow-empty -check-prefix=NO-REBUILD %s
+
+// CHECK-DAG: remark: building module 'Top' as
+// CHECK-DAG: remark: building module 'Left' as
+// CHECK-DAG: remark: building module 'Right' as
+// CHECK: remark: building module 'Bottom' as
+// CHECK-NOT: remark: building module
+// CHECK: remark: finished building module 'Bottom'
+
+// NO-REBUILD-NOT: building module
+
+@import Bottom;
@@ -0,0 +1,55 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'int a;' > %t/A.h
+// RUN: echo 'module A { header "A.h" }' > %t/module.modulemap
+
+// Building the module validates it, and records that in the module cache.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-share-session-validation \
+// RUN:            -fbuild-session-timestamp=123
+// RUN: cat %t/cache/*/modules.validated | FileCheck -check-prefix=LIST %s
+// LIST: 123
+// LIST-NEXT: {{^[0-9a-f]{40}$}}
+
+// Later compilations in the session trust it.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-share-session-validation \
+// RUN:            -fbuild-session-timestamp=123 -print-stats 2>&1 \
+// RUN:   | FileCheck -check-prefix=TRUSTED %s
+// TRUSTED: 0 module files validated, 1 trusted from earlier in the build session
+
+// A new session validates it again.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fsyntax-only %s -I %t -fmodules-share-session-validation \
+// RUN:            -fbuild-session-timestamp=124 -print-stats 2>&1 \
+// RUN:   | FileCheck -check-prefix=VALIDATED %s
+// VALIDATED: 1 module files validated, 0 trusted from earlier in the build session
+// VALIDATED: input files validated in {{[0-9.]+}} ms, 0 unchanged by content
+// RUN: cat %t/cache/*/modules.validated | FileCheck -check-prefix=NEW-LIST %s
+// NEW-LIST: 124
+
+// The contents of the input files are only hashed when they are compared.
+// RUN: llvm-bcanalyzer -dump %t/cache/*/A-*.pcm | FileCheck -check-prefix=NO-HASH %s
+// NO-HASH-NOT: INPUT_FILE_HASH
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps \
+// RUN:            -fmodules-cache-path=%t/content-cache -fsyntax-only %s -I %t \
+// RUN:            -fvalidate-ast-input-files-content
+// RUN: llvm-bcanalyzer -dump %t/content-cache/*/A-*.pcm | FileCheck -check-prefix=HASH %s
+// HASH: INPUT_FILE_HASH
+
+// A header whose modification time changed, but not its contents, only
+// makes the module out of date when the contents are not compared.
+// RUN: touch -m -a -t 201101010000 %t/A.h
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps \
+// RUN:            -fmodules-cache-path=%t/content-cache -fsyntax-only %s -I %t \
+// RUN:            -fvalidate-ast-input-files-content -Rmodule-build -print-stats 2>&1 \
+// RUN:   | FileCheck -check-prefix=CONTENT %s
+// CONTENT-NOT: building module 'A'
+// CONTENT: 1 unchanged by content
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps \
+// RUN:            -fmodules-cache-path=%t/content-cache -fsyntax-only %s -I %t \
+// RUN:            -Rmodule-build 2>&1 \
+// RUN:   | FileCheck -check-prefix=NO-CONTENT %s
+// NO-CONTENT: building module 'A'
+
+@import A;
@@ -0,0 +1,40 @@
+// RUN: %clang_cc1 -std=c++11 -emit-pch %s -o %t
+// RUN: %clang_cc1 -std=c++11 -include-pch %t -fsyntax-only -verify %s -print-stats 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -std=c++11 -include-pch %t -fsyntax-only -verify %s -DUSE_CONSTEXPR -print-stats 2>&1 | FileCheck -check-prefix=CHECK-CONSTEXPR %s
+
+// Bodies of functions imported from a PCH are attached to their declarations
+// without being read, and are only read once they are needed.
+
+// CHECK: 0/{{[1-9][0-9]*}} function bodies read
+// CHECK: 0/1 constructor initializer lists read
+
+// CHECK-CONSTEXPR: {{[1-9][0-9]*}} of the statements read were in function bodies
+// CHECK-CONSTEXPR: 1/{{[1-9][0-9]*}} function bodies read
+
+// expected-no-diagnostics
+
+#ifndef HEADER_INCLUDED
+#define HEADER_INCLUDED
+
+constexpr int answer() { return 42; }
+inline int used() { return answer() + 1; }
+inline int unused() { return answer() + 2; }
+
+struct S {
+  int x;
+  S() : x(used()) {}
+  int get() const { return x; }
+};
+
+#else
+
+int f() {
+  S s;
+  return used() + s.get();
+}
+
+#ifdef USE_CONSTEXPR
+static_assert(answer() == 42, "");
+#endif
+
+#endif
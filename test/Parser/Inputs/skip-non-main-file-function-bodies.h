@@ -0,0 +1,15 @@
+inline int headerFunction() {
+  return undeclaredInHeader;
+}
+
+struct HeaderClass {
+  int method() { return alsoUndeclaredInHeader; }
+};
+
+template <typename T> T headerTemplate(T t) {
+  return t + undeclaredInHeaderTemplate;
+}
+
+constexpr int headerConstexpr() {
+  return 42;
+}
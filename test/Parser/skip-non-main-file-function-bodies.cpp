@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -skip-non-main-file-function-bodies -I %S/Inputs -verify %s
+// RUN: %clang_cc1 -std=c++11 -skip-non-main-file-function-bodies -I %S/Inputs -ast-dump -DDUMP %s | FileCheck %s
+
+#include "skip-non-main-file-function-bodies.h"
+
+// Bodies of functions in the header are skipped, so the errors in them are
+// never diagnosed, but constexpr functions are still parsed.
+static_assert(headerConstexpr() == 42, "");
+
+int mainFileFunction() {
+#ifndef DUMP
+  return undeclaredInMainFile; // expected-error {{use of undeclared identifier 'undeclaredInMainFile'}}
+#else
+  return headerFunction();
+#endif
+}
+
+// CHECK: FunctionDecl {{.*}} headerFunction 'int (void)'
+// CHECK-NOT: CompoundStmt
+// CHECK: FunctionDecl {{.*}} headerConstexpr 'int (void)'
+// CHECK-NEXT: CompoundStmt
+// CHECK: FunctionDecl {{.*}} mainFileFunction 'int (void)'
+// CHECK-NEXT: CompoundStmt
@@ -0,0 +1,35 @@
+// Test the ways instrumentation counters can be updated.
+
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name c-coverage-counters.c %s -o - -emit-llvm -fprofile-instrument=clang -fcoverage-counters=full -disable-llvm-passes | FileCheck -check-prefix=FULL %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name c-coverage-counters.c %s -o - -emit-llvm -fprofile-instrument=clang -fcoverage-counters=fast -disable-llvm-passes | FileCheck -check-prefix=FULL %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name c-coverage-counters.c %s -o - -emit-llvm -fprofile-instrument=clang -fcoverage-counters=fast -O2 | FileCheck -check-prefix=FAST %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -main-file-name c-coverage-counters.c %s -emit-llvm-only -fprofile-instrument=clang -fcoverage-counters=fast -fcoverage-mapping -dump-coverage-mapping | FileCheck -check-prefix=MAPPING %s
+// RUN: not %clang_cc1 -fcoverage-counters=some %s 2>&1 | FileCheck -check-prefix=INVALID %s
+// RUN: not %clang_cc1 -fcoverage-counters=boolean %s 2>&1 | FileCheck -check-prefix=BOOLEAN %s
+
+// Only how the counters are updated changes, not which regions have them, so
+// the counts of else branches and loop exits, which coverage derives from
+// other counters, stay exact.
+
+// FULL-LABEL: define i32 @main()
+// FULL: call void @llvm.instrprof.increment(i8* getelementptr inbounds ([4 x i8], [4 x i8]* @__profn_main, i32 0, i32 0), i64 {{[0-9]+}}, i32 3, i32 0)
+// FULL: call void @llvm.instrprof.increment(i8* getelementptr inbounds ([4 x i8], [4 x i8]* @__profn_main, i32 0, i32 0), i64 {{[0-9]+}}, i32 3, i32 1)
+// FULL: call void @llvm.instrprof.increment(i8* getelementptr inbounds ([4 x i8], [4 x i8]* @__profn_main, i32 0, i32 0), i64 {{[0-9]+}}, i32 3, i32 2)
+// FULL-NOT: call void @llvm.instrprof.increment(
+
+// FAST: @__profc_main = private global [3 x i64] zeroinitializer
+
+// MAPPING-LABEL: main:
+// MAPPING: File 0, [[@LINE+7]]:7 -> [[@LINE+7]]:13 = (#1 - #2)
+int main() {
+  int i, n = 0;
+  for (i = 0; i < 10; i++)
+    if (i % 3)
+      n += i;
+    else
+      n -= i;
+  return n != 9;
+}
+
+// INVALID: error: invalid value 'some' in '-fcoverage-counters=some'
+// BOOLEAN: error: invalid value 'boolean' in '-fcoverage-counters=boolean'
@@ -0,0 +1,43 @@
+// Test that the profile moves hot and never-executed functions apart.
+
+// RUN: llvm-profdata merge %S/Inputs/c-hot-cold.proftext -o %t.profdata
+// RUN: %clang_cc1 %s -o - -O2 -disable-llvm-passes -emit-llvm -fprofile-instrument-use-path=%t.profdata | FileCheck %s
+// RUN: %clang_cc1 %s -o - -O2 -disable-llvm-passes -emit-llvm -fprofile-instrument-use-path=%t.profdata -fprofile-cold-optnone | FileCheck -check-prefix=OPTNONE %s
+// RUN: %clang_cc1 %s -O2 -disable-llvm-passes -emit-llvm-only -fprofile-instrument-use-path=%t.profdata -Rprofile-instr-layout 2>&1 | FileCheck -check-prefix=REMARK %s
+// RUN: %clang_cc1 %s -O2 -disable-llvm-passes -emit-llvm-only -fprofile-instrument-use-path=%t.profdata -fprofile-cold-optnone -Rprofile-instr-layout 2>&1 | FileCheck -check-prefix=REMARK-OPTNONE %s
+
+// REMARK: remark: 'cold' was never entered in the profile; placed last, in the unlikely text section{{$}}
+void cold() { return; }
+
+// Functions that must be inlined or kept small can't be optnone.
+__attribute__((always_inline)) void cold_inline() { return; }
+__attribute__((minsize)) void cold_small() { return; }
+
+void warm() { return; }
+
+// REMARK: remark: 'hot' is hot (entered 1000000 times in the profile); placed first, in the hot text section
+void hot() { return; }
+
+int main() {
+  int i;
+  for (i = 0; i < 1000000; i++) hot();
+  warm();
+  return 0;
+}
+
+// REMARK-OPTNONE: remark: 'cold' was never entered in the profile; placed last, in the unlikely text section and not optimized
+// REMARK-OPTNONE: remark: 'cold_inline' was never entered in the profile; placed last, in the unlikely text section{{$}}
+// REMARK-OPTNONE: remark: 'cold_small' was never entered in the profile; placed last, in the unlikely text section{{$}}
+
+// Hot functions come first and never-executed ones last.
+// CHECK: define void @hot() {{.*}}!section_prefix [[HOT:![0-9]+]]
+// CHECK: define void @warm() #[[WARM:[0-9]+]] !prof
+// CHECK-NOT: !section_prefix
+// CHECK: define i32 @main()
+// CHECK: define void @cold() #[[COLD:[0-9]+]] {{.*}}!section_prefix [[UNLIKELY:![0-9]+]]
+// CHECK: attributes #[[COLD]] = { cold
+// CHECK-DAG: [[HOT]] = !{!"function_section_prefix", !".hot"}
+// CHECK-DAG: [[UNLIKELY]] = !{!"function_section_prefix", !".unlikely"}
+
+// OPTNONE: define void @cold() #[[COLD:[0-9]+]]
+// OPTNONE: attributes #[[COLD]] = { cold noinline {{.*}}optnone
@@ -0,0 +1,47 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -DSTEPS -fconstexpr-steps 1000
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only %s -print-stats 2>&1 | FileCheck %s
+
+// CHECK: *** APValue Stats:
+// CHECK-NEXT: sizeof(APValue) = {{[0-9]+}} bytes
+// CHECK-NEXT: {{[0-9]+}} heap allocations, {{[0-9]+}} bytes total
+// CHECK-NEXT: {{[0-9]+}} bytes peak heap usage
+
+// Elements with a non-trivial default initializer share a single value.
+struct S { int a = 1; int b = a + 1; };
+
+#ifndef STEPS
+struct Table { S s[100000]; };
+constexpr Table t{};
+static_assert(t.s[0].b == 2 && t.s[99999].b == 2, "");
+
+constexpr int update() {
+  Table t{};
+  for (int i = 0; i < 100; ++i)
+    t.s[i * 1000].a = i;
+  return t.s[99000].a + t.s[99001].a;
+}
+static_assert(update() == 100, "");
+
+// Elements whose value depends on their position are still evaluated one by
+// one.
+struct Chain {
+  int v;
+  constexpr Chain(int v) : v(v) {}
+  constexpr Chain() : v((this - 1)->v + 1) {}
+};
+constexpr int chain() {
+  Chain c[4] = {Chain(10)};
+  return c[1].v + c[3].v;
+}
+static_assert(chain() == 24, "");
+
+#else
+// Sharing a value still takes as many steps as evaluating each element.
+struct T { int v; constexpr T() : v(7) {} }; // expected-note {{constexpr evaluation hit maximum step limit}}
+struct Big { T t[2000]; };
+constexpr Big big{}; // expected-error {{must be initialized by a constant expression}} expected-note {{in call to 'T()'}}
+struct Small { T t[500]; };
+constexpr Small small{};
+static_assert(small.t[499].v == 7, "");
+#endif
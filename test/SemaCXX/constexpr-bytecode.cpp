@@ -0,0 +1,102 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-bytecode
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-bytecode-verify
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-bytecode-verify -fconstexpr-steps 100 -DSTEPS
+
+#ifndef STEPS
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(20) == 6765, "");
+
+constexpr unsigned long long fac(unsigned n) {
+  unsigned long long r = 1;
+  for (unsigned i = 2; i <= n; ++i)
+    r *= i;
+  return r;
+}
+static_assert(fac(20) == 2432902008176640000ull, "");
+
+constexpr unsigned collatz(unsigned long long n) {
+  unsigned steps = 0;
+  while (n != 1) {
+    if (n % 2)
+      n = 3 * n + 1;
+    else
+      n /= 2;
+    steps++;
+  }
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr int isqrt(int n) {
+  int lo = 0, hi = n;
+  do {
+    int mid = lo + (hi - lo + 1) / 2;
+    if (mid > n / (mid ? mid : 1))
+      hi = mid - 1;
+    else
+      lo = mid;
+  } while (lo < hi);
+  return lo;
+}
+static_assert(isqrt(1000000) == 1000, "");
+
+constexpr int loops(int n) {
+  int sum = 0;
+  for (int i = 0; i < n; ++i) {
+    if (i == 3)
+      continue;
+    if (i == 8)
+      break;
+    sum += i;
+  }
+  return sum;
+}
+static_assert(loops(100) == 25, "");
+static_assert(loops(5) == 7, "");
+
+// Conversions and wrapping arithmetic in narrow and unsigned types.
+constexpr unsigned char truncate(int n) { return n; }
+static_assert(truncate(0x1ff) == 0xff, "");
+constexpr short narrow(long long n) { return (short)n; }
+static_assert(narrow(0x18000) == -32768, "");
+constexpr unsigned wrap(unsigned a) { return a - 1; }
+static_assert(wrap(0) == 0xffffffffu, "");
+constexpr bool to_bool(int n) { return n; }
+static_assert(to_bool(2) && !to_bool(0), "");
+constexpr int shifts(int a, unsigned b) { return (a << b) >> (b - 1); }
+static_assert(shifts(3, 4) == 6, "");
+static_assert(shifts(-1 & 0xff, 24) == -2, "");
+constexpr int logical(int a, int b) { return (a && b) + (a || b) * 2 + !a * 4; }
+static_assert(logical(0, 5) == 6 && logical(3, 5) == 3, "");
+
+enum E { Zero, One, Two };
+constexpr int enums(E e) { return e == Two ? 10 : e + One; }
+static_assert(enums(Two) == 10 && enums(One) == 2, "");
+
+constexpr int kGlobal = 42;
+const int kConst = 7;
+constexpr int globals(int n = kConst) { return n * kGlobal; }
+static_assert(globals() == 294, "");
+
+template <int N> constexpr int tmpl(int x) { return x + N + sizeof(int); }
+static_assert(tmpl<3>(4) == 11, "");
+
+// Anything that needs a diagnostic is left to the AST evaluator.
+constexpr int overflow(int n) { return n + 1; } // expected-note {{value 2147483648 is outside the range}}
+static_assert(overflow(2147483647), ""); // expected-error {{constant expression}} expected-note {{in call to 'overflow(2147483647)'}}
+constexpr int divide(int a, int b) { return a / b; } // expected-note {{division by zero}}
+static_assert(divide(1, 0), ""); // expected-error {{constant expression}} expected-note {{in call to 'divide(1, 0)'}}
+constexpr int no_return(int n) { if (n) return n; } // expected-warning {{control may reach end of non-void function}} expected-note {{control reached end of constexpr function}}
+static_assert(no_return(0), ""); // expected-error {{constant expression}} expected-note {{in call to 'no_return(0)'}}
+
+#else
+// Steps are counted exactly as the AST evaluator counts them.
+constexpr int count(int n) {
+  int k = 0;
+  while (k < n)
+    ++k;
+  return k; // expected-note {{constexpr evaluation hit maximum step limit}}
+}
+static_assert(count(96) == 96, "");
+static_assert(count(97) == 97, ""); // expected-error {{constant expression}} expected-note {{in call to 'count(97)'}}
+#endif
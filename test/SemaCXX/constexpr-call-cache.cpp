@@ -0,0 +1,47 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-call-cache -fconstexpr-steps 100 -fconstexpr-depth 10
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-call-cache -fconstexpr-steps 100 -fconstexpr-depth 10 -fconstexpr-bytecode
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-call-cache -fconstexpr-steps 100 -fconstexpr-depth 10 -print-stats 2>&1 | FileCheck %s
+
+// CHECK: *** Constexpr Call Cache Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}} cached call results
+// CHECK-NEXT: {{[1-9][0-9]*}}/{{[0-9]+}} lookups hit the cache
+// CHECK-NEXT: {{[1-9][0-9]*}} calls could not be cached
+// CHECK-NEXT: {{[1-9][0-9]*}} evaluation steps saved
+
+// This takes n + 4 steps.
+constexpr int count(int n) {
+  int k = 0;
+  while (k < n)
+    ++k; // expected-note {{constexpr evaluation hit maximum step limit}}
+  return k;
+}
+static_assert(count(60) == 60, "");
+static_assert(count(60) == 60, "");
+
+// A cached result still uses up the steps that evaluating the call took.
+constexpr int twice(int n) { return count(n) + count(n); }
+static_assert(twice(20) == 40, "");
+static_assert(twice(60) == 120, ""); // expected-error {{constant expression}} expected-note {{in call to 'twice(60)'}} expected-note {{in call to 'count(60)'}}
+
+// ... and the call depth.
+constexpr int depth(int n) { return n ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth of 10 calls}} expected-note 7{{in call to 'depth(}}
+constexpr int wrap1(int n) { return depth(n); } // expected-note {{in call to 'depth(8)'}}
+constexpr int wrap2(int n) { return wrap1(n); } // expected-note {{in call to 'wrap1(8)'}}
+static_assert(wrap1(8) == 0, "");
+static_assert(wrap2(8) == 0, ""); // expected-error {{constant expression}} expected-note {{in call to 'wrap2(8)'}}
+
+// Calls with pointer or reference arguments are never cached.
+constexpr int deref(const int &r) { return r; }
+constexpr int a = 1, b = 2;
+static_assert(deref(a) == 1 && deref(b) == 2, "");
+
+// Aggregate arguments and results are.
+struct Pair { int first, second; };
+constexpr Pair swap(Pair p) { return {p.second, p.first}; }
+static_assert(swap({1, 2}).first == 2, "");
+static_assert(swap(swap({1, 2})).first == 1, "");
+
+// Calls that fail or produce a diagnostic are not cached.
+constexpr int divide(int a, int b) { return a / b; } // expected-note 2{{division by zero}}
+static_assert(divide(4, 0), ""); // expected-error {{constant expression}} expected-note {{in call to 'divide(4, 0)'}}
+static_assert(divide(4, 0), ""); // expected-error {{constant expression}} expected-note {{in call to 'divide(4, 0)'}}
@@ -0,0 +1,54 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -verify %s -ftypo-correction-budget 100000
+// RUN: %clang_cc1 -fsyntax-only -verify %s -print-stats 2>&1 | FileCheck %s
+// RUN: not %clang_cc1 -fsyntax-only %s -DMANY_TYPOS -fspell-checking-limit 0 -ftypo-correction-budget 1 -print-stats 2>&1 | FileCheck %s --check-prefix=BUDGET
+
+// CHECK: *** Typo Correction Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}} typos looked at, 0 over the limit, 0 over the budget
+// CHECK-NEXT: {{[1-9][0-9]*}} edit distances computed in {{[0-9.]+}} ms
+// CHECK-NEXT: {{[1-9][0-9]*}} identifiers indexed, in {{[1-9][0-9]*}} updates
+// CHECK-NEXT: {{[1-9][0-9]*}}/{{[1-9][0-9]*}} names of a similar length passed the character filter, in {{[1-9][0-9]*}} queries
+
+// A thousand typos take more than a millisecond to correct, so the last one
+// is not corrected.
+// BUDGET: error: use of undeclared identifier 'counter_vlaue'{{$}}
+// BUDGET: *** Typo Correction Stats:
+// BUDGET-NEXT: {{[1-9][0-9]*}} typos looked at, 0 over the limit, {{[1-9][0-9]*}} over the budget
+
+int counter_value; // expected-note {{'counter_value' declared here}}
+int buffer2_size; // expected-note {{'buffer2_size' declared here}}
+
+namespace gadgets {
+  int widget_count; // expected-note {{'gadgets::widget_count' declared here}}
+}
+
+int f() {
+  return counter_valeu; // expected-error {{use of undeclared identifier 'counter_valeu'; did you mean 'counter_value'?}}
+}
+
+int g() {
+  return bufer2_size; // expected-error {{use of undeclared identifier 'bufer2_size'; did you mean 'buffer2_size'?}}
+}
+
+int h() {
+  return widget_cuont; // expected-error {{use of undeclared identifier 'widget_cuont'; did you mean 'gadgets::widget_count'?}}
+}
+
+int k() {
+  return zzz_nothing_like_it; // expected-error {{use of undeclared identifier 'zzz_nothing_like_it'}}
+}
+
+#ifdef MANY_TYPOS
+#define TYPO1(n) int typo_var##n = undeclared_name_##n;
+#define TYPO10(n) TYPO1(n##0) TYPO1(n##1) TYPO1(n##2) TYPO1(n##3) TYPO1(n##4) \
+                  TYPO1(n##5) TYPO1(n##6) TYPO1(n##7) TYPO1(n##8) TYPO1(n##9)
+#define TYPO100(n) TYPO10(n##0) TYPO10(n##1) TYPO10(n##2) TYPO10(n##3) \
+                   TYPO10(n##4) TYPO10(n##5) TYPO10(n##6) TYPO10(n##7) \
+                   TYPO10(n##8) TYPO10(n##9)
+#define TYPO1000(n) TYPO100(n##0) TYPO100(n##1) TYPO100(n##2) TYPO100(n##3) \
+                    TYPO100(n##4) TYPO100(n##5) TYPO100(n##6) TYPO100(n##7) \
+                    TYPO100(n##8) TYPO100(n##9)
+TYPO1000(1)
+
+int last = counter_vlaue;
+#endif
@@ -0,0 +1,137 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s -fcache-unqualified-lookup
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s -fcache-unqualified-lookup -print-stats 2>&1 | FileCheck %s
+
+// CHECK: *** Unqualified Lookup Cache Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}}/{{[0-9]+}} lookups hit the cache
+// CHECK-NEXT: {{[1-9][0-9]*}} results cached, {{[1-9][0-9]*}} invalidated, {{[0-9]+}} still cached
+// CHECK-NEXT: {{[1-9][0-9]*}} full invalidations
+
+template<typename T, typename U> struct is_same { static const bool value = false; };
+template<typename T> struct is_same<T, T> { static const bool value = true; };
+
+namespace std { typedef unsigned long size_t; }
+
+// Repeated lookups of the same names from the same scope.
+namespace repeated {
+  struct vec {
+    typedef int value_type;
+    typedef std::size_t size_type;
+    value_type a(size_type);
+    value_type b(size_type);
+    value_type c(size_type);
+  };
+  static_assert(is_same<decltype(vec().a(0)), int>::value, "");
+}
+
+// A local declaration shadows a name that was already looked up.
+namespace shadow {
+  typedef int T;
+  void f() {
+    T a = 0;
+    static_assert(is_same<T, int>::value, "");
+    typedef char T;
+    static_assert(is_same<T, char>::value, "");
+    (void)a;
+  }
+}
+
+// A name declared in a namespace after a failed lookup is found.
+namespace later {
+  void f() {
+    declared_later(); // expected-error {{use of undeclared identifier 'declared_later'}}
+  }
+  void declared_later();
+  void h() {
+    declared_later();
+  }
+}
+
+// Declarations from a recycled block scope are not found again.
+namespace blocks {
+  typedef int T;
+  void f() {
+    {
+      typedef char T;
+      static_assert(is_same<T, char>::value, "");
+    }
+    {
+      static_assert(is_same<T, int>::value, "");
+    }
+  }
+}
+
+// A using-directive at block scope only applies until the end of the block.
+typedef int Dir;
+namespace directives {
+  namespace N { typedef char Dir; }
+  void f() {
+    {
+      using namespace N;
+      static_assert(is_same<Dir, char>::value, "");
+    }
+    {
+      static_assert(is_same<Dir, int>::value, "");
+    }
+    {
+      using namespace N;
+      static_assert(is_same<Dir, char>::value, "");
+    }
+  }
+}
+
+// Members of base classes are found once the bases are attached.
+namespace bases {
+  struct B { typedef char T; };
+  typedef int T;
+  template<typename Base> struct D : Base {
+    static_assert(is_same<T, int>::value, "");
+  };
+  struct E : B {
+    static_assert(is_same<T, char>::value, "");
+  };
+  struct F {
+    static_assert(is_same<T, int>::value, "");
+  };
+}
+
+// Block scopes of functions in different namespaces, which are recycled at
+// the same address with the same parent, do not share results.
+namespace recycled {
+  namespace N1 { typedef int X; }
+  namespace N2 { typedef char X; }
+  namespace N1 {
+    void f() {
+      {
+        static_assert(is_same<X, int>::value, "");
+      }
+    }
+  }
+  namespace N2 {
+    void g() {
+      {
+        static_assert(is_same<X, char>::value, "");
+      }
+    }
+  }
+}
+
+// Nor do member functions of different classes.
+namespace members {
+  typedef int X;
+  struct A {
+    typedef char X;
+    void f() {
+      {
+        static_assert(is_same<X, char>::value, "");
+      }
+    }
+  };
+  struct B {
+    void g() {
+      {
+        static_assert(is_same<X, int>::value, "");
+      }
+    }
+  };
+}
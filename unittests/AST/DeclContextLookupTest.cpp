@@ -0,0 +1,104 @@
+//===- unittests/AST/DeclContextLookupTest.cpp - DeclContext lookup tests -===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Tests for the lookup tables built by DeclContext.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclContextInternals.h"
+#include "clang/AST/DeclLookups.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/Twine.h"
+#include "gtest/gtest.h"
+#include <string>
+
+using namespace clang;
+
+namespace {
+
+const unsigned NumNames = 2000;
+
+std::string getName(StringRef Prefix, unsigned I) {
+  return (Prefix + llvm::Twine(I)).str();
+}
+
+/// Build a namespace with many overloaded functions and a class with many
+/// members, so that the lookup tables grow well beyond their inline buckets.
+std::string makeLargeContexts() {
+  std::string Code = "namespace N {\n";
+  for (unsigned I = 0; I != NumNames; ++I) {
+    Code += "int " + getName("f", I) + "(int);\n";
+    if (I % 3 == 0)
+      Code += "int " + getName("f", I) + "(double);\n";
+  }
+  Code += "}\nstruct S {\n";
+  for (unsigned I = 0; I != NumNames; ++I)
+    Code += "  int " + getName("m", I) + ";\n";
+  Code += "};\n";
+  return Code;
+}
+
+DeclContext *getContext(ASTContext &Ctx, StringRef Name) {
+  auto Result =
+      Ctx.getTranslationUnitDecl()->lookup(&Ctx.Idents.get(Name));
+  if (Result.size() != 1)
+    return nullptr;
+  return dyn_cast<DeclContext>(Result.front());
+}
+
+TEST(DeclContextLookup, LargeNamespace) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(makeLargeContexts());
+  ASSERT_TRUE(AST.get());
+  ASTContext &Ctx = AST->getASTContext();
+
+  DeclContext *N = getContext(Ctx, "N");
+  ASSERT_TRUE(N);
+  for (unsigned I = 0; I != NumNames; ++I) {
+    std::string Name = getName("f", I);
+    auto Result = N->lookup(&Ctx.Idents.get(Name));
+    ASSERT_EQ(I % 3 == 0 ? 2u : 1u, Result.size()) << Name;
+    for (NamedDecl *ND : Result)
+      EXPECT_EQ(Name, ND->getName());
+  }
+
+  EXPECT_TRUE(N->lookup(&Ctx.Idents.get("missing")).empty());
+  EXPECT_TRUE(N->lookup(&Ctx.Idents.get("m0")).empty());
+
+  StoredDeclsMap *Map = N->getPrimaryContext()->getLookupPtr();
+  ASSERT_TRUE(Map);
+  EXPECT_EQ(NumNames, Map->size());
+  EXPECT_LE(Map->size() * 4, Map->getNumBuckets() * 3);
+}
+
+TEST(DeclContextLookup, LargeClass) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(makeLargeContexts());
+  ASSERT_TRUE(AST.get());
+  ASTContext &Ctx = AST->getASTContext();
+
+  DeclContext *S = getContext(Ctx, "S");
+  ASSERT_TRUE(S);
+  for (unsigned I = 0; I != NumNames; ++I) {
+    std::string Name = getName("m", I);
+    auto Result = S->lookup(&Ctx.Idents.get(Name));
+    ASSERT_EQ(1u, Result.size()) << Name;
+    EXPECT_EQ(Name, Result.front()->getName());
+  }
+
+  // Every member is visited exactly once when iterating over the table.
+  unsigned NumMembers = 0;
+  for (auto I = S->lookups_begin(), E = S->lookups_end(); I != E; ++I)
+    if (I.getLookupName().getAsString()[0] == 'm')
+      ++NumMembers;
+  EXPECT_EQ(NumNames, NumMembers);
+}
+
+} // end anonymous namespace
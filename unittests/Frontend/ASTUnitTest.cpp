@@ -9,6 +9,8 @@
 
 #include <fstream>
 
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
@@ -84,4 +86,61 @@ TEST(ASTUnit, SaveLoadPreservesLangOptionsInPrintingPolicy) {
   EXPECT_FALSE(AU->getASTContext().getPrintingPolicy().UseVoidForZeroParams);
 }
 
+TEST(ASTUnit, ParseSkippedFunctionBodyOnDemand) {
+  int FD;
+  llvm::SmallString<256> HeaderFileName;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("ast-unit", "h", FD, HeaderFileName));
+  ToolOutputFile header_file(HeaderFileName, FD);
+  header_file.os() << "inline int answer() { return 42; }\n";
+  header_file.os().flush();
+
+  llvm::SmallString<256> InputFileName;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("ast-unit", "cpp", FD, InputFileName));
+  ToolOutputFile input_file(InputFileName, FD);
+  input_file.os() << "#include \"" << HeaderFileName << "\"\n"
+                  << "int main() { return answer(); }\n";
+  input_file.os().flush();
+
+  const char *Args[] = {"clang", "-xc++", "-fsyntax-only", "-Xclang",
+                        "-skip-non-main-file-function-bodies",
+                        InputFileName.c_str()};
+
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+      CompilerInstance::createDiagnostics(new DiagnosticOptions());
+
+  std::shared_ptr<CompilerInvocation> CInvok =
+      createInvocationFromCommandLine(Args, Diags);
+
+  if (!CInvok)
+    FAIL() << "could not create compiler invocation";
+
+  FileManager *FileMgr =
+      new FileManager(FileSystemOptions(), vfs::getRealFileSystem());
+  auto PCHContainerOps = std::make_shared<PCHContainerOperations>();
+
+  std::unique_ptr<ASTUnit> AST = ASTUnit::LoadFromCompilerInvocation(
+      CInvok, PCHContainerOps, Diags, FileMgr);
+
+  if (!AST)
+    FAIL() << "failed to create ASTUnit";
+
+  ASTContext &Ctx = AST->getASTContext();
+  auto Lookup = Ctx.getTranslationUnitDecl()->lookup(&Ctx.Idents.get("answer"));
+  ASSERT_TRUE(Lookup.size() == 1);
+  auto *Answer = dyn_cast<FunctionDecl>(Lookup.front());
+  ASSERT_TRUE(Answer);
+
+  EXPECT_TRUE(Answer->hasSkippedBody());
+  EXPECT_FALSE(Answer->hasBody());
+
+  EXPECT_TRUE(AST->parseSkippedFunctionBody(Answer));
+  EXPECT_FALSE(Answer->hasSkippedBody());
+  EXPECT_TRUE(Answer->hasBody());
+
+  // The retained tokens are consumed by the first parse.
+  EXPECT_FALSE(AST->parseSkippedFunctionBody(Answer));
+}
+
 } // anonymous namespace